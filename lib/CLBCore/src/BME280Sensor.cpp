@@ -278,7 +278,7 @@ void sendBME280Humidity(BME280SensorReading *reading, sensorListener *pos)
 										  bme280SensorSettings.humidNormMin, bme280SensorSettings.humidNormMax);
 
 	putUnalignedFloat(humidityNormalised, (unsigned char *)optionBuffer);
-	pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+	sendToSensorListener(pos);
 }
 
 void sendBME280Temp(BME280SensorReading *reading, sensorListener *pos)
@@ -293,7 +293,7 @@ void sendBME280Temp(BME280SensorReading *reading, sensorListener *pos)
 										  bme280SensorSettings.tempNormMin, bme280SensorSettings.tempNormMax);
 
 	putUnalignedFloat(tempNormalised, (unsigned char *)optionBuffer);
-	pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+	sendToSensorListener(pos);
 }
 
 void sendBME280Press(BME280SensorReading *reading, sensorListener *pos)
@@ -308,7 +308,7 @@ void sendBME280Press(BME280SensorReading *reading, sensorListener *pos)
 										  bme280SensorSettings.pressNormMin, bme280SensorSettings.pressNormMax);
 
 	putUnalignedFloat(pressNormalised, (unsigned char *)optionBuffer);
-	pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+	sendToSensorListener(pos);
 }
 
 void sendBME280All(BME280SensorReading *reading, sensorListener *pos)
@@ -325,7 +325,7 @@ void sendBME280All(BME280SensorReading *reading, sensorListener *pos)
 										  bme280SensorSettings.tempNormMin, bme280SensorSettings.tempNormMax);
 	putUnalignedFloat(tempNormalised, (unsigned char *)optionBuffer);
 
-	pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+	sendToSensorListener(pos);
 }
 
 void sendBME280Reading(BME280SensorReading *reading, int sensorNo, sensorListener *pos)
@@ -557,12 +557,15 @@ void updateBME280SensorReading()
 	{
 	case SENSOR_OK:
 		updateBME280Sensor();
+		scheduleSensorWakeup(&bme280Sensor, BME280_READING_INTERVAL_MILLIS);
 		break;
 
 	case BME280SENSOR_NOT_FITTED:
+		setSensorEventDriven(&bme280Sensor);
 		break;
 
 	case BME280SENSOR_NOT_CONNECTED:
+		setSensorEventDriven(&bme280Sensor);
 		break;
 	}
 }
@@ -5,6 +5,9 @@
 
 #define ENV_READING_LIFETIME_MSECS 5000
 
+// Time between readings, short enough to see every clock second
+#define BME280_READING_INTERVAL_MILLIS 100
+
 #define BME280SENSOR_NOT_FITTED -1
 #define BME280SENSOR_NOT_CONNECTED -2
 
@@ -20,7 +20,14 @@ struct SettingItem hullosEnabled = {
 
 boolean validateHullOSCode(void *dest, const char *newValueStr)
 {
-	return (validateString((char *)dest, newValueStr, HULLOS_PROGRAM_SIZE));
+	if (!validateString((char *)dest, newValueStr, HULLOS_PROGRAM_SIZE))
+	{
+		return false;
+	}
+
+	// the stored program has changed
+	invalidateLabelIndex();
+	return true;
 }
 
 void setDefaultHullOSCode(void *dest)
@@ -31,10 +38,60 @@ void setDefaultHullOSCode(void *dest)
 struct SettingItem hullosProgramSetting = {
 	"hullosCode", "Hullos program", hullosSettings.hullosCode, HULLOS_PROGRAM_SIZE, text, setEmptyString, validateHullOSCode};
 
+void setDefaultHullOSSliceStatements(void *dest)
+{
+	int *destInt = (int *)dest;
+	*destInt = HULLOS_DEFAULT_SLICE_STATEMENTS;
+}
+
+void setDefaultHullOSSliceMicros(void *dest)
+{
+	int *destInt = (int *)dest;
+	*destInt = HULLOS_DEFAULT_SLICE_MICROS;
+}
+
+boolean validateHullOSSliceBudget(void *dest, const char *newValueStr)
+{
+	int value;
+
+	if (!validateInt(&value, newValueStr))
+	{
+		return false;
+	}
+
+	if (value < 0)
+	{
+		return false;
+	}
+
+	*(int *)dest = value;
+	return true;
+}
+
+struct SettingItem hullosSliceStatementsSetting = {
+	"HullOS statements per task update (0 for no limit)",
+	"hullosslicestatements",
+	&hullosSettings.hullosSliceStatements,
+	NUMBER_INPUT_LENGTH,
+	integerValue,
+	setDefaultHullOSSliceStatements,
+	validateHullOSSliceBudget};
+
+struct SettingItem hullosSliceMicrosSetting = {
+	"HullOS microseconds per task update (0 for no limit)",
+	"hullosslicemicros",
+	&hullosSettings.hullosSliceMicros,
+	NUMBER_INPUT_LENGTH,
+	integerValue,
+	setDefaultHullOSSliceMicros,
+	validateHullOSSliceBudget};
+
 struct SettingItem *hullosSettingItemPointers[] =
     {
         &hullosEnabled,
-        &hullosProgramSetting};
+        &hullosProgramSetting,
+        &hullosSliceStatementsSetting,
+        &hullosSliceMicrosSetting};
 
 struct SettingItemCollection hullosSettingItems = {
     "hullos",
@@ -56,6 +113,7 @@ void hullosOn()
 void initHullOS()
 {
     hullosProcess.status = HULLOS_STOPPED;
+    setupRemoteControl();
 }
 
 void startHullOS()
@@ -67,9 +125,108 @@ void startHullOS()
     }
 }
 
+// HullOS is updated on every pass of the loop while it is receiving a
+// program or running statements. Otherwise it sleeps until the next
+// command check or the end of a delay.
+
 bool commandsNeedFullSpeed()
 {
-    return deviceState != EXECUTE_IMMEDIATELY;
+    return (deviceState != EXECUTE_IMMEDIATELY) || hullosTaskActive();
+}
+
+unsigned long hullosSpeedStartMillis = 0;
+
+// Runs statements of the selected task until it has used up its budget
+// for this update, so that each task gets a turn
+
+void runHullOSSlice()
+{
+    int sliceStatements = hullosSettings.hullosSliceStatements;
+    unsigned long sliceMicros = hullosSettings.hullosSliceMicros;
+
+    if ((sliceStatements == 0) && (sliceMicros == 0))
+    {
+        // no budget at all - run one statement per update
+        sliceStatements = 1;
+    }
+
+    unsigned long sliceStartMicros = micros();
+    int statements = 0;
+
+    while (hullosTask->programState == PROGRAM_ACTIVE)
+    {
+        exeuteProgramStatement();
+        statements++;
+
+        if ((sliceStatements > 0) && (statements >= sliceStatements))
+        {
+            break;
+        }
+
+        if ((sliceMicros > 0) && (ulongDiff(micros(), sliceStartMicros) >= sliceMicros))
+        {
+            break;
+        }
+    }
+
+    hullosTask->statementCount += statements;
+}
+
+void updateHullOSTask(struct HullOSTask *task)
+{
+    selectHullOSTask(task);
+
+    if ((task->programState == PROGRAM_AWAITING_DELAY_COMPLETION) && millisReached(task->delayEndTime, millis()))
+    {
+        task->programState = PROGRAM_ACTIVE;
+    }
+
+    if (task->programState == PROGRAM_ACTIVE)
+    {
+        runHullOSSlice();
+    }
+}
+
+void updateHullOSSpeed()
+{
+    unsigned long now = millis();
+    unsigned long speedMillis = ulongDiff(now, hullosSpeedStartMillis);
+
+    if (speedMillis >= HULLOS_SPEED_INTERVAL_MILLIS)
+    {
+        for (int i = 0; i < HULLOS_MAX_TASKS; i++)
+        {
+            struct HullOSTask *task = &hullosTasks[i];
+            task->statementsPerSecond = (task->statementCount * 1000) / speedMillis;
+            task->statementCount = 0;
+        }
+        hullosSpeedStartMillis = now;
+    }
+}
+
+void scheduleHullOS()
+{
+    if (commandsNeedFullSpeed())
+    {
+        setProcessPolled(&hullosProcess);
+        return;
+    }
+
+    unsigned long wakeMillis = millis() + HULLOS_IDLE_POLL_MILLIS;
+
+    // wake at the end of a delay if that comes before the next command check
+    for (int i = 0; i < HULLOS_MAX_TASKS; i++)
+    {
+        struct HullOSTask *task = &hullosTasks[i];
+
+        if (task->inUse && (task->programState == PROGRAM_AWAITING_DELAY_COMPLETION) &&
+            !millisReached(wakeMillis, task->delayEndTime))
+        {
+            wakeMillis = task->delayEndTime;
+        }
+    }
+
+    scheduleProcessAt(&hullosProcess, wakeMillis);
 }
 
 void updateHullOS()
@@ -79,30 +236,32 @@ void updateHullOS()
 
     if(hullosProcess.status == HULLOS_STOPPED)
     {
+        scheduleProcessWakeup(&hullosProcess, HULLOS_IDLE_POLL_MILLIS);
         return;
     }
 
+    // commands from the serial port act on task 0
+    selectHullOSTask(&hullosTasks[0]);
+
     while (CharsAvailable())
     {
         byte b = GetRawCh();
         processHullOSSerialByte(b);
     }
 
-    switch (programState)
+    for (int i = 0; i < HULLOS_MAX_TASKS; i++)
     {
-    case PROGRAM_STOPPED:
-    case PROGRAM_PAUSED:
-        break;
-    case PROGRAM_ACTIVE:
-        exeuteProgramStatement();
-        break;
-    case PROGRAM_AWAITING_DELAY_COMPLETION:
-        if (millis() > delayEndTime)
+        if (hullosTasks[i].inUse)
         {
-            programState = PROGRAM_ACTIVE;
+            updateHullOSTask(&hullosTasks[i]);
         }
-        break;
     }
+
+    selectHullOSTask(&hullosTasks[0]);
+
+    updateHullOSSpeed();
+
+    scheduleHullOS();
 }
 
 void stophullos()
@@ -123,7 +282,26 @@ void hullosStatusMessage(char *buffer, int bufferLength)
     }
     else
     {
-        snprintf(buffer, bufferLength, "HullOS enabled");
+        int runningTasks = 0;
+        unsigned long statementsPerSecond = 0;
+
+        for (int i = 0; i < HULLOS_MAX_TASKS; i++)
+        {
+            if (hullosTasks[i].inUse && (hullosTasks[i].programState != PROGRAM_STOPPED))
+            {
+                runningTasks++;
+                statementsPerSecond += hullosTasks[i].statementsPerSecond;
+            }
+        }
+
+        if (runningTasks == 0)
+        {
+            snprintf(buffer, bufferLength, "HullOS enabled");
+        }
+        else
+        {
+            snprintf(buffer, bufferLength, "HullOS running %d tasks %lu statements/sec", runningTasks, statementsPerSecond);
+        }
     }
 }
 
@@ -5,9 +5,21 @@
 
 #define HULLOS_PROGRAM_SIZE 100
 
+// Each running task executes statements until it reaches a delay or
+// uses up its slice budget for the update. A budget of 0 is not checked.
+#define HULLOS_DEFAULT_SLICE_STATEMENTS 100
+#define HULLOS_DEFAULT_SLICE_MICROS 2000
+
+// How often HullOS looks for commands when no program is running
+#define HULLOS_IDLE_POLL_MILLIS 10
+
+#define HULLOS_SPEED_INTERVAL_MILLIS 1000
+
 struct HullOSSettings {
 	bool hullosEnabled;
 	unsigned char hullosCode[HULLOS_PROGRAM_SIZE];
+	int hullosSliceStatements;
+	int hullosSliceMicros;
 };
 
 void hullosOff();
@@ -0,0 +1,897 @@
+#include <Arduino.h>
+#include "string.h"
+#include "utils.h"
+#include "HullOSCommands.h"
+#include "HullOSVariables.h"
+#include "HullOS.h"
+#include "HullOSBytecode.h"
+
+bool hullosBytecodeEnabled = true;
+
+struct bytecodeLabel
+{
+	char name[HULLOS_MAX_LABEL_LENGTH + 1];
+	int destination;
+};
+
+
+// A jump destination to be filled in once all the labels have been found
+
+struct bytecodeJump
+{
+	char name[HULLOS_MAX_LABEL_LENGTH + 1];
+	int patchPosition;
+};
+
+// Compiler state, for the program being compiled into the bytecode of a task
+
+struct HullOSBytecodeCompiler
+{
+	uint8_t *bytecode;
+	int writePos;
+	bool compileFailed;
+
+	struct bytecodeLabel labels[HULLOS_MAX_LABELS];
+	int noOfLabels;
+
+	struct bytecodeJump jumps[HULLOS_MAX_JUMPS];
+	int noOfJumps;
+};
+
+// A program is compiled in one go, so the tasks can share the compiler
+// state rather than each keeping the label tables
+
+struct HullOSBytecodeCompiler bytecodeCompiler;
+
+void clearHullOSBytecode(struct HullOSTask *task)
+{
+	task->bytecodeReady = false;
+	task->bytecodeCounter = 0;
+}
+
+void emitBytecodeByte(struct HullOSBytecodeCompiler *compiler, uint8_t b)
+{
+	if (compiler->writePos >= HULLOS_BYTECODE_SIZE)
+	{
+		compiler->compileFailed = true;
+		return;
+	}
+	compiler->bytecode[compiler->writePos++] = b;
+}
+
+void setBytecodeByte(struct HullOSBytecodeCompiler *compiler, int position, uint8_t b)
+{
+	if (position < HULLOS_BYTECODE_SIZE)
+	{
+		compiler->bytecode[position] = b;
+	}
+}
+
+void emitBytecodeInt(struct HullOSBytecodeCompiler *compiler, int value)
+{
+	uint32_t bits = (uint32_t)value;
+
+	for (int i = 0; i < 4; i++)
+	{
+		emitBytecodeByte(compiler, bits & 0xff);
+		bits = bits >> 8;
+	}
+}
+
+void emitBytecodeAddress(struct HullOSBytecodeCompiler *compiler, int address)
+{
+	emitBytecodeByte(compiler, address & 0xff);
+	emitBytecodeByte(compiler, address >> 8);
+}
+
+// copies the label name that ends at the statement terminator
+// returns false if the name is too long to store
+
+bool copyBytecodeLabelName(char *dest, char *text)
+{
+	int length = 0;
+
+	while (*text != STATEMENT_TERMINATOR)
+	{
+		if (length == HULLOS_MAX_LABEL_LENGTH)
+		{
+			return false;
+		}
+		dest[length++] = *text++;
+	}
+
+	dest[length] = 0;
+	return true;
+}
+
+void declareBytecodeLabel(struct HullOSBytecodeCompiler *compiler, char *text)
+{
+	char name[HULLOS_MAX_LABEL_LENGTH + 1];
+
+	if (!copyBytecodeLabelName(name, text))
+	{
+		compiler->compileFailed = true;
+		return;
+	}
+
+	// A jump goes to the first declaration of a label, as it does
+	// when the interpreter searches the program text
+
+	for (int i = 0; i < compiler->noOfLabels; i++)
+	{
+		if (strcmp(compiler->labels[i].name, name) == 0)
+		{
+			return;
+		}
+	}
+
+	if (compiler->noOfLabels == HULLOS_MAX_LABELS)
+	{
+		compiler->compileFailed = true;
+		return;
+	}
+
+	strcpy(compiler->labels[compiler->noOfLabels].name, name);
+	compiler->labels[compiler->noOfLabels].destination = compiler->writePos;
+	compiler->noOfLabels++;
+}
+
+void emitBytecodeJump(struct HullOSBytecodeCompiler *compiler, char *text)
+{
+	if (compiler->noOfJumps == HULLOS_MAX_JUMPS ||
+		!copyBytecodeLabelName(compiler->jumps[compiler->noOfJumps].name, text))
+	{
+		compiler->compileFailed = true;
+		return;
+	}
+
+	compiler->jumps[compiler->noOfJumps].patchPosition = compiler->writePos;
+	compiler->noOfJumps++;
+
+	emitBytecodeAddress(compiler, 0);
+}
+
+bool resolveBytecodeJumps(struct HullOSBytecodeCompiler *compiler)
+{
+	for (int i = 0; i < compiler->noOfJumps; i++)
+	{
+		int label;
+
+		for (label = 0; label < compiler->noOfLabels; label++)
+		{
+			if (strcmp(compiler->labels[label].name, compiler->jumps[i].name) == 0)
+			{
+				break;
+			}
+		}
+
+		if (label == compiler->noOfLabels)
+		{
+			return false;
+		}
+
+		int destination = compiler->labels[label].destination;
+		setBytecodeByte(compiler, compiler->jumps[i].patchPosition, destination & 0xff);
+		setBytecodeByte(compiler, compiler->jumps[i].patchPosition + 1, destination >> 8);
+	}
+
+	return true;
+}
+
+uint8_t arithmeticOpcode(char ch)
+{
+	switch (ch)
+	{
+	case '+':
+		return BC_ADD;
+	case '-':
+		return BC_SUBTRACT;
+	case '*':
+		return BC_MULTIPLY;
+	case '/':
+		return BC_DIVIDE;
+	case '%':
+		return BC_MODULUS;
+	}
+	return BC_VALUE;
+}
+
+uint8_t comparisonOpcode(struct logicalOp *op)
+{
+	if (op == &logicEquals)
+		return BC_EQUALS;
+	if (op == &logicNotEquals)
+		return BC_NOT_EQUALS;
+	if (op == &logicLessThan)
+		return BC_LESS_THAN;
+	if (op == &logicGreaterThan)
+		return BC_GREATER_THAN;
+	if (op == &logicLessThanEquals)
+		return BC_LESS_THAN_EQUALS;
+	return BC_GREATER_THAN_EQUALS;
+}
+
+// Compiles a literal, variable or reading and moves textPos past it
+// Variables are given their slots the first time they are seen
+
+bool compileBytecodeOperand(struct HullOSBytecodeCompiler *compiler, char **textPos)
+{
+	char *text = *textPos;
+
+	while (*text == ' ')
+	{
+		text++;
+	}
+
+	if (isVariableNameStart(text))
+	{
+		int position;
+
+		if (findVariable(text, &position) != OPERAND_OK)
+		{
+			if (createVariable(text, &position) != OPERAND_OK)
+			{
+				return false;
+			}
+		}
+
+		emitBytecodeByte(compiler, BC_OPERAND_VARIABLE);
+		emitBytecodeByte(compiler, position);
+		*textPos = text + getVariableNameLength(position);
+		return true;
+	}
+
+	if (isdigit(*text) || (*text == '+') || (*text == '-'))
+	{
+		int sign = 1;
+		int value = 0;
+		bool gotDigit = false;
+
+		if (*text == '-')
+		{
+			sign = -1;
+			text++;
+		}
+
+		if (*text == '+')
+		{
+			text++;
+		}
+
+		while ((*text >= '0') && (*text <= '9'))
+		{
+			value = (value * 10) + (*text - '0');
+			gotDigit = true;
+			text++;
+		}
+
+		if (!gotDigit)
+		{
+			return false;
+		}
+
+		emitBytecodeByte(compiler, BC_OPERAND_LITERAL);
+		emitBytecodeInt(compiler, value * sign);
+		*textPos = text;
+		return true;
+	}
+
+	if (*text == READING_START_CHAR)
+	{
+		text++;
+
+		int readerNo = getReadingIndex(text);
+
+		if (readerNo < 0)
+		{
+			return false;
+		}
+
+		emitBytecodeByte(compiler, BC_OPERAND_READING);
+		emitBytecodeByte(compiler, readerNo);
+		*textPos = text + strlen(readers[readerNo]->name);
+		return true;
+	}
+
+	return false;
+}
+
+// A single operand or a two operand expression, as read by getValue
+
+bool compileBytecodeExpression(struct HullOSBytecodeCompiler *compiler, char **textPos)
+{
+	int opcodePos = compiler->writePos;
+
+	emitBytecodeByte(compiler, BC_VALUE);
+
+	if (!compileBytecodeOperand(compiler, textPos))
+	{
+		return false;
+	}
+
+	char *text = *textPos;
+
+	while (*text == ' ')
+	{
+		text++;
+	}
+
+	if ((*text == STATEMENT_TERMINATOR) || (*text == ','))
+	{
+		*textPos = text;
+		return true;
+	}
+
+	uint8_t opcode = arithmeticOpcode(*text);
+
+	if (opcode == BC_VALUE)
+	{
+		return false;
+	}
+
+	setBytecodeByte(compiler, opcodePos, opcode);
+
+	*textPos = text + 1;
+
+	return compileBytecodeOperand(compiler, textPos);
+}
+
+bool compileBytecodeSet(struct HullOSBytecodeCompiler *compiler, char *text)
+{
+	if (checkIdentifier(text) != VARIABLE_NAME_OK)
+	{
+		return false;
+	}
+
+	int position;
+
+	if (findVariable(text, &position) != OPERAND_OK)
+	{
+		if (createVariable(text, &position) != OPERAND_OK)
+		{
+			return false;
+		}
+	}
+
+	text = text + getVariableNameLength(position);
+
+	if (*text != '=')
+	{
+		return false;
+	}
+
+	text++;
+
+	emitBytecodeByte(compiler, BC_SET);
+	emitBytecodeByte(compiler, position);
+
+	return compileBytecodeExpression(compiler, &text);
+}
+
+// Compiles the condition and label of a CT or CF statement, as read by compareAndJump
+
+bool compileBytecodeCondition(struct HullOSBytecodeCompiler *compiler, uint8_t opcode, char *text)
+{
+	emitBytecodeByte(compiler, opcode);
+
+	int comparePos = compiler->writePos;
+
+	emitBytecodeByte(compiler, BC_EQUALS);
+
+	if (!compileBytecodeOperand(compiler, &text))
+	{
+		return false;
+	}
+
+	struct logicalOp *op = findLogicalOp(text);
+
+	if (op == NULL)
+	{
+		return false;
+	}
+
+	setBytecodeByte(compiler, comparePos, comparisonOpcode(op));
+
+	text = text + strlen(op->operatorCh);
+
+	if (!compileBytecodeOperand(compiler, &text))
+	{
+		return false;
+	}
+
+	// skip the comma in front of the label
+
+	if (*text == STATEMENT_TERMINATOR)
+	{
+		return false;
+	}
+
+	text++;
+
+	if (*text == STATEMENT_TERMINATOR)
+	{
+		return false;
+	}
+
+	emitBytecodeJump(compiler, text);
+
+	return true;
+}
+
+// Compiles a statement held in the buffer. The statement ends with a terminator.
+// Statements that can't be compiled are run from the program text
+
+void compileBytecodeStatement(struct HullOSBytecodeCompiler *compiler, char *statement, int statementStart)
+{
+	int startPos = compiler->writePos;
+	bool compiled = false;
+
+	char commandCh = toupper(statement[0]);
+	char subCommandCh = 0;
+
+	if (commandCh != STATEMENT_TERMINATOR)
+	{
+		subCommandCh = toupper(statement[1]);
+	}
+
+	char *text = statement + 2;
+
+	switch (commandCh)
+	{
+	case '#':
+	case STATEMENT_TERMINATOR:
+		// comments and empty statements don't do anything
+		compiled = true;
+		break;
+
+	case 'C':
+		switch (subCommandCh)
+		{
+		case 'D':
+			if (*text != STATEMENT_TERMINATOR)
+			{
+				emitBytecodeByte(compiler, BC_DELAY);
+				compiled = compileBytecodeExpression(compiler, &text);
+			}
+			break;
+		case 'L':
+			declareBytecodeLabel(compiler, text);
+			compiled = true;
+			break;
+		case 'J':
+			emitBytecodeByte(compiler, BC_JUMP);
+			emitBytecodeJump(compiler, text);
+			compiled = true;
+			break;
+		case 'C':
+			emitBytecodeByte(compiler, BC_COIN_TOSS);
+			emitBytecodeJump(compiler, text);
+			compiled = true;
+			break;
+		case 'T':
+			compiled = compileBytecodeCondition(compiler, BC_JUMP_IF_TRUE, text);
+			break;
+		case 'F':
+			compiled = compileBytecodeCondition(compiler, BC_JUMP_IF_FALSE, text);
+			break;
+		}
+		break;
+
+	case 'V':
+		switch (subCommandCh)
+		{
+		case 'S':
+			compiled = compileBytecodeSet(compiler, text);
+			break;
+		case 'C':
+			emitBytecodeByte(compiler, BC_CLEAR_VARIABLES);
+			compiled = true;
+			break;
+		}
+		break;
+
+	case 'W':
+		switch (subCommandCh)
+		{
+		case 'T':
+		{
+			emitBytecodeByte(compiler, BC_PRINT_TEXT);
+			int lengthPos = compiler->writePos;
+			emitBytecodeByte(compiler, 0);
+			int length = 0;
+			while (*text != STATEMENT_TERMINATOR)
+			{
+				emitBytecodeByte(compiler, *text++);
+				length++;
+			}
+			setBytecodeByte(compiler, lengthPos, length);
+			compiled = true;
+			break;
+		}
+		case 'L':
+			emitBytecodeByte(compiler, BC_PRINT_LINE);
+			compiled = true;
+			break;
+		case 'V':
+			emitBytecodeByte(compiler, BC_PRINT_VALUE);
+			compiled = compileBytecodeExpression(compiler, &text);
+			break;
+		}
+		break;
+	}
+
+	if (!compiled)
+	{
+		compiler->writePos = startPos;
+		emitBytecodeByte(compiler, BC_STATEMENT);
+		emitBytecodeAddress(compiler, statementStart);
+	}
+}
+
+// The variable slots are given out from the variable store of the selected task,
+// which must be the task that will run the bytecode
+
+bool compileHullOSBytecode(struct HullOSTask *task, int programPosition)
+{
+	char statement[COMMAND_BUFFER_SIZE];
+	struct HullOSBytecodeCompiler *compiler = &bytecodeCompiler;
+
+	clearHullOSBytecode(task);
+
+	compiler->bytecode = task->bytecode;
+	compiler->writePos = 0;
+	compiler->compileFailed = false;
+	compiler->noOfLabels = 0;
+	compiler->noOfJumps = 0;
+
+	int position = programPosition;
+
+	while (position < programSize)
+	{
+		int statementStart = position;
+		int length = 0;
+		bool gotStatement = false;
+
+		while (position < programSize)
+		{
+			char programByte = readHullOSProgramByte(position);
+
+			if (programByte == PROGRAM_TERMINATOR)
+			{
+				break;
+			}
+
+			if (length == COMMAND_BUFFER_SIZE)
+			{
+				// too long for the command buffer - leave it to the interpreter
+				return false;
+			}
+
+			statement[length++] = programByte;
+			position++;
+
+			if (programByte == STATEMENT_TERMINATOR)
+			{
+				gotStatement = true;
+				break;
+			}
+		}
+
+		if (!gotStatement)
+		{
+			break;
+		}
+
+		compileBytecodeStatement(compiler, statement, statementStart);
+
+		if (compiler->compileFailed)
+		{
+			return false;
+		}
+	}
+
+	emitBytecodeByte(compiler, BC_END);
+
+	if (compiler->compileFailed || !resolveBytecodeJumps(compiler))
+	{
+		return false;
+	}
+
+	task->bytecodeReady = true;
+	return true;
+}
+
+int readBytecodeAddress(int *pc)
+{
+	int address = hullosTask->bytecode[*pc] | (hullosTask->bytecode[*pc + 1] << 8);
+	*pc += 2;
+	return address;
+}
+
+int readBytecodeInt(int *pc)
+{
+	uint32_t bits = 0;
+
+	for (int i = 3; i >= 0; i--)
+	{
+		bits = (bits << 8) | hullosTask->bytecode[*pc + i];
+	}
+
+	*pc += 4;
+	return (int)bits;
+}
+
+void skipBytecodeOperand(int *pc)
+{
+	if (hullosTask->bytecode[*pc] == BC_OPERAND_LITERAL)
+	{
+		*pc += 5;
+	}
+	else
+	{
+		*pc += 2;
+	}
+}
+
+bool readBytecodeOperand(int *pc, int *result)
+{
+	uint8_t operandType = hullosTask->bytecode[(*pc)++];
+
+	switch (operandType)
+	{
+	case BC_OPERAND_LITERAL:
+		*result = readBytecodeInt(pc);
+		return true;
+
+	case BC_OPERAND_VARIABLE:
+	{
+		int slot = hullosTask->bytecode[(*pc)++];
+
+		if (variableStore->variables[slot].unassigned)
+		{
+			Serial.print(F("Operand error: "));
+			Serial.println(USING_UNASSIGNED_VARIABLE);
+			return false;
+		}
+
+		*result = variableStore->variables[slot].value;
+		return true;
+	}
+
+	case BC_OPERAND_READING:
+		*result = readers[hullosTask->bytecode[(*pc)++]]->reader();
+		return true;
+	}
+
+	return false;
+}
+
+bool evaluateBytecodeExpression(int *pc, int *result)
+{
+	uint8_t opcode = hullosTask->bytecode[(*pc)++];
+
+	int firstOperand;
+
+	if (!readBytecodeOperand(pc, &firstOperand))
+	{
+		if (opcode != BC_VALUE)
+		{
+			skipBytecodeOperand(pc);
+		}
+		return false;
+	}
+
+	if (opcode == BC_VALUE)
+	{
+		*result = firstOperand;
+		return true;
+	}
+
+	int secondOperand;
+
+	if (!readBytecodeOperand(pc, &secondOperand))
+	{
+		return false;
+	}
+
+	switch (opcode)
+	{
+	case BC_ADD:
+		*result = firstOperand + secondOperand;
+		break;
+	case BC_SUBTRACT:
+		*result = firstOperand - secondOperand;
+		break;
+	case BC_MULTIPLY:
+		*result = firstOperand * secondOperand;
+		break;
+	case BC_DIVIDE:
+		*result = firstOperand / secondOperand;
+		break;
+	case BC_MODULUS:
+		*result = firstOperand % secondOperand;
+		break;
+	}
+
+	return true;
+}
+
+bool compareBytecodeValues(uint8_t opcode, int firstOperand, int secondOperand)
+{
+	switch (opcode)
+	{
+	case BC_EQUALS:
+		return firstOperand == secondOperand;
+	case BC_NOT_EQUALS:
+		return firstOperand != secondOperand;
+	case BC_LESS_THAN:
+		return firstOperand < secondOperand;
+	case BC_GREATER_THAN:
+		return firstOperand > secondOperand;
+	case BC_LESS_THAN_EQUALS:
+		return firstOperand <= secondOperand;
+	}
+	return firstOperand >= secondOperand;
+}
+
+// Runs a statement from the program text through the command interpreter
+
+void executeStoredStatement(int statementPos)
+{
+	while (statementPos < programSize)
+	{
+		char programByte = readHullOSProgramByte(statementPos++);
+
+		processCommandByte(programByte);
+
+		if (programByte == STATEMENT_TERMINATOR)
+		{
+			return;
+		}
+	}
+}
+
+bool executeBytecodeStatement()
+{
+	int pc = hullosTask->bytecodeCounter;
+	int value;
+
+#ifdef DIAGNOSTICS_ACTIVE
+	if (diagnosticsOutputLevel & LINE_NUMBERS)
+	{
+		Serial.print(F("Bytecode offset: "));
+		Serial.println(pc);
+	}
+#endif
+
+	uint8_t opcode = hullosTask->bytecode[pc++];
+
+	switch (opcode)
+	{
+	case BC_END:
+		haltProgramExecution();
+		return false;
+
+	case BC_SET:
+	{
+		int slot = hullosTask->bytecode[pc++];
+
+		if (evaluateBytecodeExpression(&pc, &value))
+		{
+			setVariable(slot, value);
+
+			if (diagnosticsOutputLevel & STATEMENT_CONFIRMATION)
+			{
+				Serial.println(F("VSOK"));
+			}
+		}
+		break;
+	}
+
+	case BC_DELAY:
+		if (evaluateBytecodeExpression(&pc, &value))
+		{
+			hullosTask->delayEndTime = millis() + value * 100;
+			hullosTask->programState = PROGRAM_AWAITING_DELAY_COMPLETION;
+		}
+		break;
+
+	case BC_JUMP:
+	{
+		int destination = readBytecodeAddress(&pc);
+		pc = destination;
+		break;
+	}
+
+	case BC_COIN_TOSS:
+	{
+		int destination = readBytecodeAddress(&pc);
+
+		if (random(0, 2) == 0)
+		{
+			pc = destination;
+		}
+		break;
+	}
+
+	case BC_JUMP_IF_TRUE:
+	case BC_JUMP_IF_FALSE:
+	{
+		uint8_t compareOpcode = hullosTask->bytecode[pc++];
+		int firstOperand;
+		int secondOperand;
+
+		if (!readBytecodeOperand(&pc, &firstOperand))
+		{
+			skipBytecodeOperand(&pc);
+			pc += 2;
+			break;
+		}
+
+		if (!readBytecodeOperand(&pc, &secondOperand))
+		{
+			pc += 2;
+			break;
+		}
+
+		int destination = readBytecodeAddress(&pc);
+
+		bool result = compareBytecodeValues(compareOpcode, firstOperand, secondOperand);
+
+		if (result == (opcode == BC_JUMP_IF_TRUE))
+		{
+			pc = destination;
+		}
+		break;
+	}
+
+	case BC_PRINT_TEXT:
+	{
+		int length = hullosTask->bytecode[pc++];
+
+		for (int i = 0; i < length; i++)
+		{
+			Serial.print((char)hullosTask->bytecode[pc++]);
+		}
+		break;
+	}
+
+	case BC_PRINT_LINE:
+		Serial.println();
+		break;
+
+	case BC_PRINT_VALUE:
+		if (evaluateBytecodeExpression(&pc, &value))
+		{
+			Serial.print(value);
+		}
+		break;
+
+	case BC_CLEAR_VARIABLES:
+		// keep the names so that the compiled slots stay valid
+		for (int i = 0; i < NUMBER_OF_VARIABLES; i++)
+		{
+			variableStore->variables[i].unassigned = true;
+			variableStore->variables[i].value = 0;
+		}
+
+		if (diagnosticsOutputLevel & STATEMENT_CONFIRMATION)
+		{
+			Serial.print(F("VCOK"));
+		}
+		break;
+
+	case BC_STATEMENT:
+	{
+		int statementPos = readBytecodeAddress(&pc);
+
+		// the statement might restart or halt the program, so move on first
+		hullosTask->bytecodeCounter = pc;
+		executeStoredStatement(statementPos);
+		return true;
+	}
+	}
+
+	hullosTask->bytecodeCounter = pc;
+	return true;
+}
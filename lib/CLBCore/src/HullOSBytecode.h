@@ -0,0 +1,71 @@
+#pragma once
+
+// Compiles the stored HullOS program text into bytecode when the program
+// is started. Jump targets are resolved to bytecode offsets, variable names
+// to variable slots and operators to opcodes, so that the statements in a
+// loop are not parsed again each time round.
+// Statements that the compiler does not handle are run from the program text
+// by the command interpreter. If the program can't be compiled at all it is
+// interpreted as text.
+
+#define HULLOS_BYTECODE_SIZE 256
+#define HULLOS_MAX_LABELS 20
+#define HULLOS_MAX_JUMPS 30
+
+// The longest label name, for the compiler and the label index alike
+
+#define HULLOS_MAX_LABEL_LENGTH 8
+
+// Statement opcodes
+
+#define BC_END 0
+#define BC_SET 1
+#define BC_DELAY 2
+#define BC_JUMP 3
+#define BC_COIN_TOSS 4
+#define BC_JUMP_IF_TRUE 5
+#define BC_JUMP_IF_FALSE 6
+#define BC_PRINT_TEXT 7
+#define BC_PRINT_LINE 8
+#define BC_PRINT_VALUE 9
+#define BC_CLEAR_VARIABLES 10
+#define BC_STATEMENT 11
+
+// Operand types
+
+#define BC_OPERAND_LITERAL 1
+#define BC_OPERAND_VARIABLE 2
+#define BC_OPERAND_READING 3
+
+// Expressions start with an arithmetic opcode, then one or two operands
+
+#define BC_VALUE 0
+#define BC_ADD 1
+#define BC_SUBTRACT 2
+#define BC_MULTIPLY 3
+#define BC_DIVIDE 4
+#define BC_MODULUS 5
+
+// Comparisons in conditional jumps
+
+#define BC_EQUALS 1
+#define BC_NOT_EQUALS 2
+#define BC_LESS_THAN 3
+#define BC_GREATER_THAN 4
+#define BC_LESS_THAN_EQUALS 5
+#define BC_GREATER_THAN_EQUALS 6
+
+struct HullOSTask;
+
+extern bool hullosBytecodeEnabled;
+
+void clearHullOSBytecode(struct HullOSTask *task);
+
+// Compiles the program text that starts at programPosition into the bytecode of the task
+// Returns false if the program could not be compiled
+bool compileHullOSBytecode(struct HullOSTask *task, int programPosition);
+
+// Executes the bytecode statement at the bytecode counter of the selected task
+// Returns false if the program has ended
+bool executeBytecodeStatement();
+
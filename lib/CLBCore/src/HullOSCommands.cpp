@@ -13,16 +13,14 @@
 #include "HullOSCommands.h"
 #include "HullOSVariables.h"
 #include "HullOSScript.h"
+#include "HullOSBytecode.h"
 #include "HullOS.h"
 #include "otaupdate.h"
 
-ProgramState programState = PROGRAM_STOPPED;
 DeviceState deviceState = EXECUTE_IMMEDIATELY;
 
 uint8_t diagnosticsOutputLevel = 0;
 
-unsigned long delayEndTime;
-
 char programCommand[COMMAND_BUFFER_SIZE];
 char *commandPos;
 char *commandLimit;
@@ -50,11 +48,16 @@ uint8_t GetRawCh()
     return (uint8_t)ch;
 }
 
-// Current position in the EEPROM of the execution
-int programCounter;
+// Task 0 is always in use, the others are started by startHullOSTask
+struct HullOSTask hullosTasks[HULLOS_MAX_TASKS] = {{true}};
 
-// Start position of the code as stored in the EEPROM
-int programBase;
+struct HullOSTask *hullosTask = &hullosTasks[0];
+
+void selectHullOSTask(struct HullOSTask *task)
+{
+	hullosTask = task;
+	variableStore = &task->variableStore;
+}
 
 // Write position when downloading and storing program code
 int programWriteBase;
@@ -72,6 +75,16 @@ uint8_t readHullOSProgramByte(int address)
 
 bool storeByteIntoEEPROM(char byte, int pos)
 {
+	if (pos >= HULLOS_PROGRAM_SIZE)
+	{
+		return false;
+	}
+
+	hullosSettings.hullosCode[pos] = byte;
+
+	// the labels may have moved
+	invalidateLabelIndex();
+
 	return true;
 }
 
@@ -107,20 +120,20 @@ void clearProgramStoredFlag()
 //   storeByteIntoEEPROM(0, PROGRAM_STATUS_BYTE_OFFSET + 1);
 }
 
+// A program is stored when the program store holds something other than a
+// terminator, or the 0xFF of an erased store, at the stored program offset
+
 bool isProgramStored()
 {
-//   if ((EEPROM.read(PROGRAM_STATUS_BYTE_OFFSET) == PROGRAM_STORED_VALUE1) &
-//     (EEPROM.read(PROGRAM_STATUS_BYTE_OFFSET + 1) == PROGRAM_STORED_VALUE2))
-//     return true;
-//   else
-//     return false;
-return true;
+	uint8_t firstByte = readHullOSProgramByte(STORED_PROGRAM_OFFSET);
+
+	return (firstByte != PROGRAM_TERMINATOR) && (firstByte != 0xFF);
 }
 
-// set to the length of the program in bytes
-// Get this from the file size when we load the program
+// Size of the program store. Execution stops at the program terminator
+// or at the end of the store
 
-int programSize;
+int programSize = HULLOS_PROGRAM_SIZE;
 
 void dumpProgramFromEEPROM(int EEPromStart)
 {
@@ -163,9 +176,23 @@ void startProgramExecution(int programPosition)
         Serial.println(programPosition);
 #endif
         clearVariables();
-        programCounter = programPosition;
-        programBase = programPosition;
-        programState = PROGRAM_ACTIVE;
+
+        if (!labelIndexValid || (labelIndexBase != programPosition))
+        {
+            buildLabelIndex(programPosition);
+        }
+
+        hullosTask->programCounter = programPosition;
+        hullosTask->programBase = programPosition;
+        hullosTask->programState = PROGRAM_ACTIVE;
+
+        clearHullOSBytecode(hullosTask);
+
+        if (hullosBytecodeEnabled)
+        {
+            // If the program doesn't compile it is interpreted from the text
+            compileHullOSBytecode(hullosTask, programPosition);
+        }
     }
 }
 
@@ -174,10 +201,87 @@ void haltProgramExecution()
 {
 #ifdef PROGRAM_DEBUG
     Serial.print(F(".Ending program execution at: "));
-    Serial.println(programCounter);
+    Serial.println(hullosTask->programCounter);
 #endif
 
-    programState = PROGRAM_STOPPED;
+    hullosTask->programState = PROGRAM_STOPPED;
+
+    // the serial port task is always available, other tasks are released when they stop
+    if (hullosTask != &hullosTasks[0])
+    {
+        hullosTask->inUse = false;
+    }
+}
+
+struct HullOSTask *startHullOSTask(int programPosition)
+{
+    // don't take a task for a program that isn't there
+    if (!isProgramStored())
+    {
+        return NULL;
+    }
+
+    // task 0 belongs to the serial port
+
+    for (int i = 1; i < HULLOS_MAX_TASKS; i++)
+    {
+        struct HullOSTask *task = &hullosTasks[i];
+
+        if (task->inUse)
+        {
+            continue;
+        }
+
+        struct HullOSTask *previousTask = hullosTask;
+
+        task->inUse = true;
+        selectHullOSTask(task);
+        startProgramExecution(programPosition);
+
+        if (task->programState != PROGRAM_ACTIVE)
+        {
+            task->inUse = false;
+            task = NULL;
+        }
+
+        selectHullOSTask(previousTask);
+        return task;
+    }
+
+    return NULL;
+}
+
+void haltAllHullOSTasks()
+{
+    struct HullOSTask *previousTask = hullosTask;
+
+    for (int i = 0; i < HULLOS_MAX_TASKS; i++)
+    {
+        struct HullOSTask *task = &hullosTasks[i];
+
+        if (task->inUse)
+        {
+            selectHullOSTask(task);
+            haltProgramExecution();
+        }
+
+        clearHullOSBytecode(task);
+    }
+
+    selectHullOSTask(previousTask);
+}
+
+bool hullosTaskActive()
+{
+    for (int i = 0; i < HULLOS_MAX_TASKS; i++)
+    {
+        if (hullosTasks[i].inUse && (hullosTasks[i].programState == PROGRAM_ACTIVE))
+        {
+            return true;
+        }
+    }
+
+    return false;
 }
 
 // RP - pause program
@@ -185,10 +289,10 @@ void pauseProgramExecution()
 {
 #ifdef PROGRAM_DEBUG
     Serial.print(".Pausing program execution at: ");
-    Serial.println(programCounter);
+    Serial.println(hullosTask->programCounter);
 #endif
 
-    programState = PROGRAM_PAUSED;
+    hullosTask->programState = PROGRAM_PAUSED;
 
 #ifdef DIAGNOSTICS_ACTIVE
 
@@ -205,13 +309,13 @@ void resumeProgramExecution()
 {
 #ifdef PROGRAM_DEBUG
 	Serial.print(".Resuming program execution at: ");
-	Serial.println(programCounter);
+	Serial.println(hullosTask->programCounter);
 #endif
 
-	if (programState == PROGRAM_PAUSED)
+	if (hullosTask->programState == PROGRAM_PAUSED)
 	{
 		// Can resume the program
-		programState = PROGRAM_ACTIVE;
+		hullosTask->programState = PROGRAM_ACTIVE;
 
 #ifdef DIAGNOSTICS_ACTIVE
 
@@ -230,7 +334,7 @@ void resumeProgramExecution()
 		if (diagnosticsOutputLevel & STATEMENT_CONFIRMATION)
 		{
 			Serial.print(F("RRFail:"));
-			Serial.println(programState);
+			Serial.println(hullosTask->programState);
 		}
 #endif
 	}
@@ -252,6 +356,9 @@ void storeProgramByte(uint8_t b)
 void clearStoredProgram()
 {
 	clearProgramStoredFlag();
+	// the running programs are about to be overwritten
+	haltAllHullOSTasks();
+	invalidateLabelIndex();
 	storeByteIntoEEPROM(PROGRAM_TERMINATOR, STORED_PROGRAM_OFFSET);
 }
 
@@ -264,8 +371,8 @@ void startDownloadingCode(int downloadPosition)
 	Serial.println(".Starting code download");
 #endif
 
-	// Stop the current program
-	haltProgramExecution();
+	// Stop the running programs
+	haltAllHullOSTasks();
 
 	// clear the existing program so that
 	// partially stored programs never get executed on power up
@@ -340,6 +447,8 @@ void storeReceivedByte(uint8_t b)
 
 			setProgramStored();
 
+			buildLabelIndex(STORED_PROGRAM_OFFSET);
+
 #ifdef DIAGNOSTICS_ACTIVE
 
 			if (diagnosticsOutputLevel & DUMP_DOWNLOADS)
@@ -474,9 +583,9 @@ void remoteDelay()
 	}
 #endif
 
-	delayEndTime = millis() + delayValueInTenthsIOfASecond * 100;
+	hullosTask->delayEndTime = millis() + delayValueInTenthsIOfASecond * 100;
 
-	programState = PROGRAM_AWAITING_DELAY_COMPLETION;
+	hullosTask->programState = PROGRAM_AWAITING_DELAY_COMPLETION;
 }
 
 // Command CLxxxx - program label
@@ -689,6 +798,183 @@ int findLabelInProgram(char *label, int programPosition)
 	}
 }
 
+struct labelIndexEntry labelIndex[LABEL_INDEX_SIZE];
+
+bool labelIndexValid = false;
+
+// Start of the program that the index was built for
+int labelIndexBase;
+
+void invalidateLabelIndex()
+{
+	labelIndexValid = false;
+}
+
+// The label ends with a statement terminator or a zero
+
+unsigned int labelIndexHash(char *label)
+{
+	unsigned int hash = 0;
+
+	while ((*label != STATEMENT_TERMINATOR) && (*label != 0))
+	{
+		hash = (hash * 31) + (uint8_t)*label;
+		label++;
+	}
+
+	return hash % LABEL_INDEX_SIZE;
+}
+
+bool labelIndexEntryMatches(struct labelIndexEntry *entry, char *label)
+{
+	char *name = entry->name;
+
+	while (*name != 0)
+	{
+		if (*name != *label)
+		{
+			return false;
+		}
+		name++;
+		label++;
+	}
+
+	return (*label == STATEMENT_TERMINATOR) || (*label == 0);
+}
+
+bool addLabelToIndex(char *name, int statementStart)
+{
+	unsigned int slot = labelIndexHash(name);
+
+	for (int i = 0; i < LABEL_INDEX_SIZE; i++)
+	{
+		struct labelIndexEntry *entry = &labelIndex[slot];
+
+		if (entry->statementStart < 0)
+		{
+			strcpy(entry->name, name);
+			entry->statementStart = statementStart;
+			return true;
+		}
+
+		if (labelIndexEntryMatches(entry, name))
+		{
+			// a branch goes to the first declaration of a label
+			return true;
+		}
+
+		slot = (slot + 1) % LABEL_INDEX_SIZE;
+	}
+
+	return false;
+}
+
+//#define BUILD_LABEL_INDEX_DEBUG
+
+bool buildLabelIndex(int programPosition)
+{
+	labelIndexValid = false;
+
+	for (int i = 0; i < LABEL_INDEX_SIZE; i++)
+	{
+		labelIndex[i].statementStart = -1;
+	}
+
+	int statementStart = programPosition;
+
+	while ((statementStart >= 0) && (statementStart < programSize))
+	{
+		char programByte = readHullOSProgramByte(statementStart);
+
+		if (programByte == PROGRAM_TERMINATOR)
+		{
+			break;
+		}
+
+		if (((programByte == 'C') || (programByte == 'c')) && (statementStart + 1 < programSize))
+		{
+			programByte = readHullOSProgramByte(statementStart + 1);
+
+			if ((programByte == 'L') || (programByte == 'l'))
+			{
+				char name[HULLOS_MAX_LABEL_LENGTH + 1];
+				int nameLength = 0;
+				int position = statementStart + 2;
+
+				// A label is only found by a branch if its statement has a terminator
+
+				while (position < programSize)
+				{
+					programByte = readHullOSProgramByte(position++);
+
+					if ((programByte == STATEMENT_TERMINATOR) || (programByte == PROGRAM_TERMINATOR))
+					{
+						break;
+					}
+
+					if (nameLength == HULLOS_MAX_LABEL_LENGTH)
+					{
+						return false;
+					}
+
+					name[nameLength++] = programByte;
+				}
+
+				name[nameLength] = 0;
+
+				if (programByte == STATEMENT_TERMINATOR)
+				{
+#ifdef BUILD_LABEL_INDEX_DEBUG
+					Serial.print("Label: ");
+					Serial.print(name);
+					Serial.print(" at: ");
+					Serial.println(statementStart);
+#endif
+					if (!addLabelToIndex(name, statementStart))
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+		statementStart = findNextStatement(statementStart);
+	}
+
+	labelIndexBase = programPosition;
+	labelIndexValid = true;
+	return true;
+}
+
+int findLabel(char *label)
+{
+	if (!labelIndexValid || (labelIndexBase != hullosTask->programBase))
+	{
+		return findLabelInProgram(label, hullosTask->programBase);
+	}
+
+	unsigned int slot = labelIndexHash(label);
+
+	for (int i = 0; i < LABEL_INDEX_SIZE; i++)
+	{
+		struct labelIndexEntry *entry = &labelIndex[slot];
+
+		if (entry->statementStart < 0)
+		{
+			return -1;
+		}
+
+		if (labelIndexEntryMatches(entry, label))
+		{
+			return entry->statementStart;
+		}
+
+		slot = (slot + 1) % LABEL_INDEX_SIZE;
+	}
+
+	return -1;
+}
+
 // Command CJxxxx - jump to label
 // Jumps to the specified label
 // Return CJOK if the label is found, error if not.
@@ -699,7 +985,7 @@ void jumpToLabel()
 	Serial.println(".**jump to label");
 #endif
 
-	int labelStatementPos = findLabelInProgram(decodePos, programBase);
+	int labelStatementPos = findLabel(decodePos);
 
 #ifdef JUMP_TO_LABEL_DEBUG
 	Serial.print("Label statement pos: ");
@@ -709,11 +995,11 @@ void jumpToLabel()
 	if (labelStatementPos >= 0)
 	{
 		// the label has been found - jump to it
-		programCounter = labelStatementPos;
+		hullosTask->programCounter = labelStatementPos;
 
 #ifdef JUMP_TO_LABEL_DEBUG
 		Serial.print("New Program Counter: ");
-		Serial.println(programCounter);
+		Serial.println(hullosTask->programCounter);
 #endif
 
 #ifdef DIAGNOSTICS_ACTIVE
@@ -748,7 +1034,7 @@ void jumpToLabelCoinToss()
 
 #endif
 
-	int labelStatementPos = findLabelInProgram(decodePos, programBase);
+	int labelStatementPos = findLabel(decodePos);
 
 #ifdef JUMP_TO_LABEL_COIN_DEBUG
 	Serial.print("  Label statement pos: ");
@@ -761,7 +1047,7 @@ void jumpToLabelCoinToss()
 
 		if (random(0, 2) == 0)
 		{
-			programCounter = labelStatementPos;
+			hullosTask->programCounter = labelStatementPos;
 #ifdef DIAGNOSTICS_ACTIVE
 			if (diagnosticsOutputLevel & STATEMENT_CONFIRMATION)
 			{
@@ -781,7 +1067,7 @@ void jumpToLabelCoinToss()
 
 #ifdef JUMP_TO_LABEL_COIN_DEBUG
 		Serial.print(F("New Program Counter: "));
-		Serial.println(programCounter);
+		Serial.println(hullosTask->programCounter);
 #endif
 	}
 	else
@@ -846,7 +1132,7 @@ void compareAndJump(bool jumpIfTrue)
 		return;
 	}
 
-	int labelStatementPos = findLabelInProgram(decodePos, programBase);
+	int labelStatementPos = findLabel(decodePos);
 
 #ifdef COMPARE_CONDITION_DEBUG
 	Serial.print("Label statement pos: ");
@@ -867,7 +1153,7 @@ void compareAndJump(bool jumpIfTrue)
 		Serial.println(F("Condition true - taking jump"));
 #endif
 		// the label has been found - jump to it
-		programCounter = labelStatementPos;
+		hullosTask->programCounter = labelStatementPos;
 
 #ifdef DIAGNOSTICS_ACTIVE
 		if (diagnosticsOutputLevel & STATEMENT_CONFIRMATION)
@@ -1077,7 +1363,7 @@ void printStatus()
 		Serial.println(F("ISOK"));
 	}
 #endif
-	Serial.print(programState);
+	Serial.print(hullosTask->programState);
 	Serial.println(diagnosticsOutputLevel);
 }
 
@@ -1406,6 +1692,10 @@ void interpretSerialByte(uint8_t b)
 	}
 }
 
+// Script compiler state for the script text arriving over the serial port
+
+struct HullOSScriptContext serialScriptContext;
+
 void processHullOSSerialByte(uint8_t b)
 {
 #ifdef COMMAND_DEBUG
@@ -1416,10 +1706,10 @@ void processHullOSSerialByte(uint8_t b)
 	switch (deviceState)
 	{
 	case EXECUTE_IMMEDIATELY:
-		decodeScriptChar(b, interpretSerialByte);
+		decodeScriptChar(&serialScriptContext, b, interpretSerialByte);
 		break;
 	case STORE_PROGRAM:
-		decodeScriptChar(b, storeReceivedByte);
+		decodeScriptChar(&serialScriptContext, b, storeReceivedByte);
 		break;
 	}
 }
@@ -1434,6 +1724,16 @@ void setupRemoteControl()
 }
 
 bool exeuteProgramStatement()
+{
+	if (hullosTask->bytecodeReady)
+	{
+		return executeBytecodeStatement();
+	}
+
+	return exeuteProgramTextStatement();
+}
+
+bool exeuteProgramTextStatement()
 {
 	char programByte;
 
@@ -1445,15 +1745,15 @@ bool exeuteProgramStatement()
 	if (diagnosticsOutputLevel & LINE_NUMBERS)
 	{
 		Serial.print(F("Offset: "));
-		Serial.println((int)programCounter);
+		Serial.println((int)hullosTask->programCounter);
 	}
 #endif
 
 	while (true)
 	{
-		programByte = readHullOSProgramByte(programCounter++);
+		programByte = readHullOSProgramByte(hullosTask->programCounter++);
 
-		if (programCounter >= programSize || programByte == PROGRAM_TERMINATOR)
+		if (hullosTask->programCounter >= programSize || programByte == PROGRAM_TERMINATOR)
 		{
 			haltProgramExecution();
 			return false;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "HullOSVariables.h"
+#include "HullOSBytecode.h"
 
 //#define DIAGNOSTICS_ACTIVE
 //#define STORE_RECEIVED_BYTE_DEBUG
@@ -40,12 +41,56 @@ enum DeviceState
 #define READ_INTEGER_DEBUG
 #endif
 
-extern ProgramState programState;
 extern DeviceState deviceState;
 
 extern uint8_t diagnosticsOutputLevel;
 
-extern unsigned long delayEndTime;
+// A stored program running as a HullOS task. Each task has its own
+// execution state, bytecode and variables, and updateHullOS runs the
+// active tasks in turn, each for a slice of statements.
+// Task 0 is the task that is controlled by the commands from the serial port.
+
+#define HULLOS_MAX_TASKS 3
+
+struct HullOSTask
+{
+	bool inUse;
+
+	ProgramState programState;
+
+	// Current position in the program store of the execution
+	int programCounter;
+
+	// Start position of the code in the program store
+	int programBase;
+
+	unsigned long delayEndTime;
+
+	// Offset of the next bytecode statement to be executed
+	int bytecodeCounter;
+	bool bytecodeReady;
+	uint8_t bytecode[HULLOS_BYTECODE_SIZE];
+
+	struct HullOSVariableStore variableStore;
+
+	// Statements executed since the speed was last worked out
+	unsigned long statementCount;
+	unsigned long statementsPerSecond;
+};
+
+extern struct HullOSTask hullosTasks[];
+
+// The task that the program statements and commands act on
+extern struct HullOSTask *hullosTask;
+
+void selectHullOSTask(struct HullOSTask *task);
+
+// Starts the program at programPosition in a free task
+// Returns NULL if no program is stored or all the tasks are in use
+struct HullOSTask *startHullOSTask(int programPosition);
+
+void haltAllHullOSTasks();
+bool hullosTaskActive();
 
 extern char programCommand[];
 extern char *commandPos;
@@ -103,6 +148,32 @@ void declareLabel();
 
 	int findNextStatement(int programPosition);
 
+// Label index
+// Maps the labels in the stored program to the offsets of their statements
+// so that a branch doesn't have to search the program text. Built when a
+// program is stored or started and invalidated when the program store changes.
+
+#define LABEL_INDEX_SIZE 32
+
+struct labelIndexEntry
+{
+	char name[HULLOS_MAX_LABEL_LENGTH + 1];
+	int statementStart;
+};
+
+extern bool labelIndexValid;
+extern int labelIndexBase;
+
+void invalidateLabelIndex();
+
+// Returns false if the program has too many labels, or labels that are too long,
+// to be indexed. Branches then search the program text.
+bool buildLabelIndex(int programPosition);
+
+// Returns the offset of the statement that declares the label, or -1 if
+// there isn't one. The label ends with a statement terminator.
+int findLabel(char *label);
+
 // Find a label in the program
 // Returns the offset into the program where the label is declared
 // The first parameter is the first character of the label
@@ -159,9 +230,15 @@ void interpretSerialByte(uint8_t b);
 void processHullOSSerialByte(uint8_t b);
 void setupRemoteControl();
 
+extern int programSize;
+
+// Executes the next statement of the running program, from the bytecode
+// if the program has been compiled
+bool exeuteProgramStatement();
+
 // Executes the statement in the EEPROM at the current program counter
 // The statement is assembled into a buffer by interpretCommandByte
-bool exeuteProgramStatement();
+bool exeuteProgramTextStatement();
 
 void updateHullOS();
 bool commandsNeedFullSpeed();
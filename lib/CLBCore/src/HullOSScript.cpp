@@ -18,76 +18,13 @@
 // command numbers:             0    1 2  3  4    5  6     7      8        9    10    11  12    13   14   15    16    17    18    19    20     
 const char commandNames[] = "delay#set#if#do#while#endif#forever#endwhile#until#clear#run#else#wait#stop#begin#end#print#println#break#continue#"; // don't forget the # on the end
 
-char scriptInputBuffer[SCRIPT_INPUT_BUFFER_LENGTH];
-
-int scriptInputBufferPos;
-
-// The line number in the script
-// Used when reporting errors
-
-int scriptLineNumber;
-
-// Flag to indicate an error has been detected
-// Used for error reporting
-
-bool programError;
-
-// Flag to indicate that a program is being compiled - i.e. a begin keyword has been detected
-
-bool compilingProgram = false;
-
-// The start position of the command in the input buffer
-// Set by decodeCommand
-// Shared with all the functions below
-char * commandStartPos;
-
-// THIS MEANS THAT THIS COMPILER IS NOT REENTRANT
-
-// The position in the input buffer 
-// Set to the start of the command buffer by decodeScriptLine
-// Shared with all the functions below and updated by them
-
-// THIS MEANS THAT THIS COMPILER IS NOT REENTRANT
-
-char * bufferPos;
-
-// The position in the command names
-// Set to the start of the command names by decodeScriptLine
-// Shared with all the functions below and updated by some
-
-// THIS ALSO MEANS THAT THIS COMPILER IS NOT REENTRANT
-
-int scriptCommandPos;
-
-// The indent level of the current statement
-// Starts at 0 and increases with each block construction
-// Shared with all the functions below and updated by some
-
-// THIS ALSO MEANS THAT THIS COMPILER IS NOT REENTRANT
-
-byte currentIndentLevel;
-
-// True if the previous statement started a block
-// This statement is allowed to set a new indent level
-//
-
-bool previousStatementStartedBlock;
-
 bool displayErrors = true;
 
-// The function to be used to send out comipiled bytes. 
-// Set at the start of the line by decodeScriptLine
-// Shared with all the functions below
-
-// YET ANOTHER REASON THAT THIS COMPILER IS NOT REENTRANT
-
-void(*outputFunction) (byte);
-
-bool spinToCommandEnd()
+bool spinToCommandEnd(struct HullOSScriptContext *script)
 {
 	while (true)
 	{
-		char ch = pgm_read_byte_near(commandNames + scriptCommandPos);
+		char ch = pgm_read_byte_near(commandNames + script->scriptCommandPos);
 
 		if (ch == 0)
 			// end of the string in memory
@@ -96,57 +33,57 @@ bool spinToCommandEnd()
 		if (ch == COMMAND_NAME_TERMINATOR)
 		{
 			// move past the terminator
-			scriptCommandPos++;
+			script->scriptCommandPos++;
 			return true;
 		}
 
 		// move to the next character
-		scriptCommandPos++;
+		script->scriptCommandPos++;
 	}
 }
 
-unsigned char skipInputSpaces()
+unsigned char skipInputSpaces(struct HullOSScriptContext *script)
 {
 	unsigned char result = 0;
 
-	while (*bufferPos == ' ')
+	while (*script->bufferPos == ' ')
 	{
 		result++;
-		bufferPos++;
+		script->bufferPos++;
 	}
 	return result;
 }
 
-void writeBytesFromBuffer(int length)
+void writeBytesFromBuffer(struct HullOSScriptContext *script, int length)
 {
 	for (int i = 0; i < length; i++)
 	{
-		outputFunction(*bufferPos);
-		bufferPos++;
+		script->outputFunction(*script->bufferPos);
+		script->bufferPos++;
 	}
 }
 
-void writeMatchingStringFromBuffer(char * string)
+void writeMatchingStringFromBuffer(struct HullOSScriptContext *script, char * string)
 {
 	while (*string)
 	{
-		outputFunction(*bufferPos);
-		bufferPos++;
+		script->outputFunction(*script->bufferPos);
+		script->bufferPos++;
 		string++;
 	}
 }
 
 //#define COMPARE_COMMAND_DEBUG
 
-ScriptCompareCommandResult compareCommand()
+ScriptCompareCommandResult compareCommand(struct HullOSScriptContext *script)
 {
 	// Start at the buffer position
 
-	char * comparePos = bufferPos;
+	char * comparePos = script->bufferPos;
 
 	while (true)
 	{
-		char ch = pgm_read_byte_near(commandNames + scriptCommandPos);
+		char ch = pgm_read_byte_near(commandNames + script->scriptCommandPos);
 
 #ifdef COMPARE_COMMAND_DEBUG
 		Serial.print(ch);
@@ -162,7 +99,7 @@ ScriptCompareCommandResult compareCommand()
 		if ((ch == COMMAND_NAME_TERMINATOR) && (inputCh == ' ' || inputCh == 0))
 		{
 			// Set the buffer position to the end of the command
-			bufferPos = comparePos;
+			script->bufferPos = comparePos;
 
 #ifdef COMPARE_COMMAND_DEBUG
 			Serial.println("..match");
@@ -177,44 +114,44 @@ ScriptCompareCommandResult compareCommand()
 #endif
 			return COMMAND_NOT_MATCHED;
 		}
-		scriptCommandPos++;
+		script->scriptCommandPos++;
 		comparePos++;
 	}
 }
 
 // Decodes the command held in the area of memory referred to by bufferPos
-int decodeCommandName()
+int decodeCommandName(struct HullOSScriptContext *script)
 {
 	// Set the position in the command list to the start of the list
-	scriptCommandPos = 0;
+	script->scriptCommandPos = 0;
 
 	// Set the command counter to 0
 	int commandNumber = 0;
 
-	skipInputSpaces();
+	skipInputSpaces(script);
 
 	// ignore empty lines
-	if (*bufferPos==0)
+	if (*script->bufferPos==0)
 		return COMMAND_EMPTY_LINE;
 
 	// Set commandStartPos to point to the start of the statement being decoded
 	// Used when decoding colour names
 
-	commandStartPos = bufferPos;
+	script->commandStartPos = script->bufferPos;
 
 	// it is a system command - just return this immediately
 
-	if (*bufferPos == '*')
+	if (*script->bufferPos == '*')
 	{
 		// skip past the *
-		bufferPos++;
+		script->bufferPos++;
 		// return the command type
 		return COMMAND_SYSTEM_COMMAND;
 	}
 
 	while (true)
 	{
-		ScriptCompareCommandResult result = compareCommand();
+		ScriptCompareCommandResult result = compareCommand(script);
 
 		switch (result)
 		{
@@ -222,7 +159,7 @@ int decodeCommandName()
 			return commandNumber;
 
 		case COMMAND_NOT_MATCHED:
-			if (!spinToCommandEnd())
+			if (!spinToCommandEnd(script))
 				return -1;
 			commandNumber++;
 			break;
@@ -275,16 +212,16 @@ void dumpByte(unsigned char b)
 
 #endif
 
-int processSingleValue()
+int processSingleValue(struct HullOSScriptContext *script)
 {
-	skipInputSpaces();
+	skipInputSpaces(script);
 
-	if (isVariableNameStart(bufferPos))
+	if (isVariableNameStart(script->bufferPos))
 	{
 		// its a variable
 		int position;
 
-		if (findVariable(bufferPos,&position) == VARIABLE_NOT_FOUND)
+		if (findVariable(script->bufferPos,&position) == VARIABLE_NOT_FOUND)
 		{
 			return VARIABLE_USED_BEFORE_IT_WAS_CREATED;
 		}
@@ -295,19 +232,19 @@ int processSingleValue()
 
 		for (int i = 0; i < variableLength; i++)
 		{
-			outputFunction(*bufferPos);
-			bufferPos++;
+			script->outputFunction(*script->bufferPos);
+			script->bufferPos++;
 		}
 		return ERROR_OK;
 	}
 
-	if (isdigit(*bufferPos) | (*bufferPos == '+') | (*bufferPos == '-'))
+	if (isdigit(*script->bufferPos) | (*script->bufferPos == '+') | (*script->bufferPos == '-'))
 	{
 		bool firstch = true;
 
 		while (true)
 		{
-			char ch = *bufferPos;
+			char ch = *script->bufferPos;
 
 			if ((ch<'0') | (ch>'9'))
 			{
@@ -323,19 +260,19 @@ int processSingleValue()
 					return ERROR_OK;
 				}
 			}
-			outputFunction(ch);
+			script->outputFunction(ch);
 			firstch = false;
-			bufferPos++;
+			script->bufferPos++;
 		}
 	}
 
-	if (*bufferPos == READING_START_CHAR)
+	if (*script->bufferPos == READING_START_CHAR)
 	{
 		// Move past the start character
 
-		bufferPos++;
+		script->bufferPos++;
 
-		struct reading * reader = getReading(bufferPos);
+		struct reading * reader = getReading(script->bufferPos);
 
 		if (reader == NULL)
 		{
@@ -344,7 +281,7 @@ int processSingleValue()
 
 		// Drop out the char to start the hardware name
 
-		outputFunction(READING_START_CHAR);
+		script->outputFunction(READING_START_CHAR);
 
 		// copy the variable into the instruction
 
@@ -352,47 +289,47 @@ int processSingleValue()
 
 		for (int i = 0; i < readerLength; i++)
 		{
-			outputFunction(*bufferPos);
-			bufferPos++;
+			script->outputFunction(*script->bufferPos);
+			script->bufferPos++;
 		}
 		return ERROR_OK;
 	}
     return ERROR_MISSING_SINGLE_VALUE;
 }
 
-int processValue()
+int processValue(struct HullOSScriptContext *script)
 {
-	int result = processSingleValue();
+	int result = processSingleValue(script);
 
 	if (result != ERROR_OK)
 		return result;
 
-	skipInputSpaces();
+	skipInputSpaces(script);
 
-	if (*bufferPos == 0)
+	if (*script->bufferPos == 0)
 		// Just a single value - no expression 
 		return ERROR_OK;
 
-	if (validOperator(*bufferPos))
+	if (validOperator(*script->bufferPos))
 	{
 		// write out the operator
-		outputFunction(*bufferPos);
+		script->outputFunction(*script->bufferPos);
 
 		// move past the operator
-		bufferPos++;
+		script->bufferPos++;
 
-		skipInputSpaces();
+		skipInputSpaces(script);
 
 		// process the second value
-		return processSingleValue();
+		return processSingleValue(script);
 	}
 
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
 	return ERROR_OK;
 }
 
-void sendCommand( const char *command)
+void sendCommand(struct HullOSScriptContext *script, const char *command)
 {
 	int pos = 0;
 
@@ -403,112 +340,98 @@ void sendCommand( const char *command)
 		if (b == 0)
 			break;
 
-		outputFunction(b);
+		script->outputFunction(b);
 		pos++;
 	}
 }
 
-void endCommand()
+void endCommand(struct HullOSScriptContext *script)
 {
-	outputFunction(STATEMENT_TERMINATOR);
+	script->outputFunction(STATEMENT_TERMINATOR);
 }
 
-void abandonCompilation()
+void abandonCompilation(struct HullOSScriptContext *script)
 {
-	programError = true;
+	script->programError = true;
 }
 
 const char delayCommand[] = "CD";
 
-int compileDelay()
+int compileDelay(struct HullOSScriptContext *script)
 {
 #ifdef SCRIPT_DEBUG
 	Serial.print(F("Compiling delay: "));
 #endif // SCRIPT_DEBUG
 
-	skipInputSpaces();
+	skipInputSpaces(script);
 
-	if (*bufferPos == 0)
+	if (*script->bufferPos == 0)
 	{
 		return ERROR_MISSING_TIME_IN_DELAY;
 	}
 
-	sendCommand(delayCommand);
+	sendCommand(script, delayCommand);
 
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
-	return processValue();
+	return processValue(script);
 }
 const char setCommand[] = "VS";
 
-int compileAssignment()
+int compileAssignment(struct HullOSScriptContext *script)
 {
 #ifdef SCRIPT_DEBUG
 	Serial.print(F("Compiling set: "));
 #endif // SCRIPT_DEBUG
 
 	// Not allowed to indent after a set
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
-	skipInputSpaces();
+	skipInputSpaces(script);
 
-	if (checkIdentifier(bufferPos) != VARIABLE_NAME_OK)
+	if (checkIdentifier(script->bufferPos) != VARIABLE_NAME_OK)
 		return ERROR_INVALID_VARIABLE_NAME_IN_SET;
 
 	int position ;
 
-	if (findVariable(bufferPos, &position) == VARIABLE_NOT_FOUND)
+	if (findVariable(script->bufferPos, &position) == VARIABLE_NOT_FOUND)
 	{
-		if (createVariable(bufferPos, &position) == NO_ROOM_FOR_VARIABLE)
+		if (createVariable(script->bufferPos, &position) == NO_ROOM_FOR_VARIABLE)
 		{
 			return ERROR_TOO_MANY_VARIABLES;
 		}
 	}
 
-	sendCommand(setCommand);
+	sendCommand(script, setCommand);
 
-	writeBytesFromBuffer(getVariableNameLength(position));
+	writeBytesFromBuffer(script, getVariableNameLength(position));
 
-	skipInputSpaces();
+	skipInputSpaces(script);
 
-	if (*bufferPos != '=')
+	if (*script->bufferPos != '=')
 	{
 		return ERROR_NO_EQUALS_IN_SET;
 	}
 
-	bufferPos++; // skip past the equals
-	outputFunction('=');  // write the equals
+	script->bufferPos++; // skip past the equals
+	script->outputFunction('=');  // write the equals
 
-	skipInputSpaces();
+	skipInputSpaces(script);
 
-	return processValue();
+	return processValue(script);
 }
 
-struct stackItem {
-	unsigned char constructionType;
-	int count;
-	unsigned char indentLevel;
-};
-
-#define STACK_SIZE 10
-
-struct stackItem operation[STACK_SIZE];
-
-int operationStackPointer;
-
 #define EMPTY_STACK -1
 #define IF_CONSTRUCTION_STACK_ITEM 1
 #define WHILE_CONSTRUCTION_STACK_ITEM 3
 #define FOREVER_CONSTRUCTION_STACK_ITEM 4
 
-int labelCounter;
-
-void dropValue(int value)
+void dropValue(struct HullOSScriptContext *script, int value)
 {
 	while (true)
 	{
 		char ch = '0' + (value % 10);
-		outputFunction(ch);
+		script->outputFunction(ch);
 		value = value / 10;
 		if (value == 0)
 			break;
@@ -520,151 +443,151 @@ void dropValue(int value)
 // Push an operation onto the operation stack.
 // This manages the if, do and while constructions
 //
-void push_operation(unsigned char type, unsigned char count)
+void push_operation(struct HullOSScriptContext *script, unsigned char type, unsigned char count)
 {
-	operation[operationStackPointer].constructionType = type;
-	operation[operationStackPointer].count = count;
-	operation[operationStackPointer].indentLevel = currentIndentLevel;
-	operationStackPointer++;
+	script->operation[script->operationStackPointer].constructionType = type;
+	script->operation[script->operationStackPointer].count = count;
+	script->operation[script->operationStackPointer].indentLevel = script->currentIndentLevel;
+	script->operationStackPointer++;
 }
 
 // Get the type of the top operation without removing anything from the stack
 // We need to use this to check to make sure that the end element of a construction
 // matches the start element.
 
-bool inline operation_stack_empty()
+bool inline operation_stack_empty(struct HullOSScriptContext *script)
 {
-	return operationStackPointer == 0;
+	return script->operationStackPointer == 0;
 }
 
-unsigned char top_operation_type()
+unsigned char top_operation_type(struct HullOSScriptContext *script)
 {
-	if (operationStackPointer == 0)
+	if (script->operationStackPointer == 0)
 		return EMPTY_STACK;
 
-	return operation[operationStackPointer - 1].constructionType;
+	return script->operation[script->operationStackPointer - 1].constructionType;
 }
 
-int top_operation_label()
+int top_operation_label(struct HullOSScriptContext *script)
 {
-	if (operationStackPointer == 0)
+	if (script->operationStackPointer == 0)
 		return EMPTY_STACK;
 
-	return operation[operationStackPointer - 1].count;
+	return script->operation[script->operationStackPointer - 1].count;
 }
 
 
-unsigned char top_operation_indent_level()
+unsigned char top_operation_indent_level(struct HullOSScriptContext *script)
 {
-	if (operationStackPointer == 0)
+	if (script->operationStackPointer == 0)
 		return EMPTY_STACK;
 
-	return operation[operationStackPointer - 1].indentLevel;
+	return script->operation[script->operationStackPointer - 1].indentLevel;
 }
 
 // Get the top value on the operation stack
-int pop_operation_count()
+int pop_operation_count(struct HullOSScriptContext *script)
 {
-	operationStackPointer--;
-	return operation[operationStackPointer].count;
+	script->operationStackPointer--;
+	return script->operation[script->operationStackPointer].count;
 }
 
 const char labelCommand[] = "CLl";
 
-void dropLabel(int labelCounter)
+void dropLabel(struct HullOSScriptContext *script, int labelNo)
 {
 	// first character of the label
-	sendCommand(labelCommand);
-	dropValue(labelCounter);
+	sendCommand(script, labelCommand);
+	dropValue(script, labelNo);
 }
 
-void dropLabelStatement(int labelCounter)
+void dropLabelStatement(struct HullOSScriptContext *script, int labelNo)
 {
-	dropLabel(labelCounter);
-	endCommand();
+	dropLabel(script, labelNo);
+	endCommand(script);
 }
 
-void pushLabel(unsigned char labelType)
+void pushLabel(struct HullOSScriptContext *script, unsigned char labelType)
 {
-	labelCounter++; // move on to the next construction
-	push_operation(labelType, labelCounter);
-	dropLabel(labelCounter);
+	script->labelCounter++; // move on to the next construction
+	push_operation(script, labelType, script->labelCounter);
+	dropLabel(script, script->labelCounter);
 }
 
 const char jumpCommand[] = "CJl";
 
-void dropJump(int labelCounter)
+void dropJump(struct HullOSScriptContext *script, int labelNo)
 {
-	sendCommand(jumpCommand);
-	dropValue(labelCounter);
+	sendCommand(script, jumpCommand);
+	dropValue(script, labelNo);
 }
 
-void dropJumpCommand(int labelCounter)
+void dropJumpCommand(struct HullOSScriptContext *script, int labelNo)
 {
-	dropJump(labelCounter);
-	endCommand();
+	dropJump(script, labelNo);
+	endCommand(script);
 }
 
-void resetScriptLine()
+void resetScriptLine(struct HullOSScriptContext *script)
 {
-	scriptInputBufferPos = 0;
+	script->scriptInputBufferPos = 0;
 }
 
-void beginCompilingStatements()
+void beginCompilingStatements(struct HullOSScriptContext *script)
 {
-	currentIndentLevel = 0;
-	previousStatementStartedBlock = false;
-	operationStackPointer = 0;
-	labelCounter = 0;
-	resetScriptLine();
-	scriptLineNumber = 1; // start at the first line
-	programError = false; // indicate that no errors were detected
-	compilingProgram = true; // indicate that we are compiling a program
+	script->currentIndentLevel = 0;
+	script->previousStatementStartedBlock = false;
+	script->operationStackPointer = 0;
+	script->labelCounter = 0;
+	resetScriptLine(script);
+	script->scriptLineNumber = 1; // start at the first line
+	script->programError = false; // indicate that no errors were detected
+	script->compilingProgram = true; // indicate that we are compiling a program
 }
 
 const char endCommandText[] = "RX";
 
 const char failedCommandText[] = "RA";
 
-void endCompilingStatements()
+void endCompilingStatements(struct HullOSScriptContext *script)
 {
-	if (programError)
+	if (script->programError)
 	{
-		sendCommand(failedCommandText);
+		sendCommand(script, failedCommandText);
 		Serial.println("Errors");
 	}
 	else
 	{
-		sendCommand(endCommandText);
+		sendCommand(script, endCommandText);
 		Serial.println("OK");
 	}
 
-	compilingProgram = false;
+	script->compilingProgram = false;
 }
 
 // Drops a comparison statement
-int dropComparisonStatement(int labelNo, bool trueTest)
+int dropComparisonStatement(struct HullOSScriptContext *script, int labelNo, bool trueTest)
 {
-	outputFunction('C');
+	script->outputFunction('C');
 
 	if (trueTest)
-		outputFunction('T');
+		script->outputFunction('T');
 	else
-		outputFunction('F');
+		script->outputFunction('F');
 
-	skipInputSpaces();
+	skipInputSpaces(script);
 
 	// Get the first value in the logical expression
-	int result = processSingleValue();
+	int result = processSingleValue(script);
 
 	if (result != ERROR_OK)
 		return result;
 
 	// Skip to the logical operator
-	skipInputSpaces();
+	skipInputSpaces(script);
 
 	// Get the logical operator
-	struct logicalOp * ifOp = findLogicalOp(bufferPos);
+	struct logicalOp * ifOp = findLogicalOp(script->bufferPos);
 
 	// Abandon if there is no matching logical operator
 	if (ifOp == NULL)
@@ -674,13 +597,13 @@ int dropComparisonStatement(int labelNo, bool trueTest)
 	}
 
 	// Write out the logical operator
-	writeMatchingStringFromBuffer(ifOp->operatorCh);
+	writeMatchingStringFromBuffer(script, ifOp->operatorCh);
 
 	// Skip to the second operand
-	skipInputSpaces();
+	skipInputSpaces(script);
 
 	// process the second operand
-	result = processSingleValue();
+	result = processSingleValue(script);
 
 	if (result != ERROR_OK)
 		return result;
@@ -688,20 +611,20 @@ int dropComparisonStatement(int labelNo, bool trueTest)
 	// if we get here the condition is valid and we need to drop out the destination label
 	// for the branch past the 
 
-	outputFunction(',');  // write the comma
+	script->outputFunction(',');  // write the comma
 
 	// Drop out the first character of the label (which is l)
-	outputFunction('l');
+	script->outputFunction('l');
 	// drop the label counter value
-	dropValue(labelNo);
+	dropValue(script, labelNo);
 
 	return ERROR_OK;
 }
 
-int compileIf()
+int compileIf(struct HullOSScriptContext *script)
 {
 
-	if (!compilingProgram)
+	if (!script->compilingProgram)
 	{
 		return ERROR_IF_CANNOT_BE_USED_OUTSIDE_A_PROGRAM;
 	}
@@ -711,27 +634,27 @@ int compileIf()
 	Serial.print(F("Compiling if: "));
 #endif // SCRIPT_DEBUG
 
-	labelCounter++; // move on to the next label
+	script->labelCounter++; // move on to the next label
 
 					// Add the start of the if to the operation stack
 
-	push_operation(IF_CONSTRUCTION_STACK_ITEM, labelCounter);
+	push_operation(script, IF_CONSTRUCTION_STACK_ITEM, script->labelCounter);
 
-	int result = dropComparisonStatement(labelCounter, false);
+	int result = dropComparisonStatement(script, script->labelCounter, false);
 
-	labelCounter++; // reserve a label for use by else - if any
+	script->labelCounter++; // reserve a label for use by else - if any
 
-	previousStatementStartedBlock = true;
+	script->previousStatementStartedBlock = true;
 
 	return result;
 }
 
-int compileElse()
+int compileElse(struct HullOSScriptContext *script)
 {
 #ifdef SCRIPT_DEBUG
 	Serial.print(F("Compiling else: "));
 #endif // SCRIPT_DEBUG
-	if (!compilingProgram)
+	if (!script->compilingProgram)
 	{
 		return ERROR_ELSE_CANNOT_BE_USED_OUTSIDE_A_PROGRAM;
 	}
@@ -739,13 +662,13 @@ int compileElse()
 	return ERROR_OK;
 }
 
-int compileWhile()
+int compileWhile(struct HullOSScriptContext *script)
 {
 #ifdef SCRIPT_DEBUG
 	Serial.print(F("Compiling while: "));
 #endif // SCRIPT_DEBUG
 
-	if (!compilingProgram)
+	if (!script->compilingProgram)
 	{
 		return ERROR_WHILE_CANNOT_BE_USED_OUTSIDE_A_PROGRAM;
 	}
@@ -753,28 +676,28 @@ int compileWhile()
 	// First drop out a label so that 
 	// we can branch back to the top
 
-	pushLabel(WHILE_CONSTRUCTION_STACK_ITEM);
+	pushLabel(script, WHILE_CONSTRUCTION_STACK_ITEM);
 
 	// Going to follow this command with another
-	endCommand();
+	endCommand(script);
 
-	labelCounter++; // move on to the next label
+	script->labelCounter++; // move on to the next label
 
 	// Now insert the branch past the loop
 
-	previousStatementStartedBlock = true;
+	script->previousStatementStartedBlock = true;
 
-	return dropComparisonStatement(labelCounter, false);
+	return dropComparisonStatement(script, script->labelCounter, false);
 }
 
-int compileForever()
+int compileForever(struct HullOSScriptContext *script)
 {
 
 #ifdef SCRIPT_DEBUG
 	Serial.print(F("Compiling forever: "));
 #endif // SCRIPT_DEBUG
 
-	if (!compilingProgram)
+	if (!script->compilingProgram)
 	{
 		return ERROR_FOREVER_CANNOT_BE_USED_OUTSIDE_A_PROGRAM;
 	}
@@ -782,13 +705,13 @@ int compileForever()
 	// First drop out a label so that 
 	// we can branch back to the top
 
-	pushLabel(FOREVER_CONSTRUCTION_STACK_ITEM);
+	pushLabel(script, FOREVER_CONSTRUCTION_STACK_ITEM);
 
-	labelCounter++; // move on to the next label
+	script->labelCounter++; // move on to the next label
 
 					// Now insert the branch past the loop
 
-	previousStatementStartedBlock = true;
+	script->previousStatementStartedBlock = true;
 
 	return ERROR_OK;
 }
@@ -800,11 +723,11 @@ int compileForever()
 
 #define NO_LABEL_FOR_LOOP_ON_STACK -1
 
-int findTopLoopConstructionLabel()
+int findTopLoopConstructionLabel(struct HullOSScriptContext *script)
 {
 	// Start the search at the top of the stack
 	// Rememver that
-	int searchStackPointer = operationStackPointer;
+	int searchStackPointer = script->operationStackPointer;
 
 
 	// If the operation stack pointer is zero there is nothing
@@ -813,13 +736,13 @@ int findTopLoopConstructionLabel()
 	{
 		searchStackPointer--; // climb down the stack
 							  // pointer aways points to next free location
-		unsigned char constructionType = operation[searchStackPointer].constructionType;
+		unsigned char constructionType = script->operation[searchStackPointer].constructionType;
 
 		if ((constructionType == WHILE_CONSTRUCTION_STACK_ITEM) || (constructionType == FOREVER_CONSTRUCTION_STACK_ITEM))
 		{
 			// found a loop construction
 			// return the label from that loop
-			return operation[searchStackPointer].count;
+			return script->operation[searchStackPointer].count;
 		}
 	}
 
@@ -829,22 +752,22 @@ int findTopLoopConstructionLabel()
 
 }
 
-int compileBreak()
+int compileBreak(struct HullOSScriptContext *script)
 {
 
 	// Not allowed to indent after a break
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
 #ifdef SCRIPT_DEBUG
 	Serial.print(F("Compiling break: "));
 #endif // SCRIPT_DEBUG
 
-	if (!compilingProgram)
+	if (!script->compilingProgram)
 	{
 		return ERROR_BREAK_CANNOT_BE_USED_OUTSIDE_A_PROGRAM;
 	}
 
-	int operation_label = findTopLoopConstructionLabel();
+	int operation_label = findTopLoopConstructionLabel(script);
 
 	if (operation_label == NO_LABEL_FOR_LOOP_ON_STACK)
 		return ERROR_NO_LABEL_FOR_LOOP_ON_STACK_IN_BREAK;
@@ -852,11 +775,11 @@ int compileBreak()
 	// first label value is the jump for the loop repeat
 	// next label value is the label after the end of the loop
 
-	dropJump(operation_label + 1);
+	dropJump(script, operation_label + 1);
 	return ERROR_OK;
 }
 
-int compileContinue()
+int compileContinue(struct HullOSScriptContext *script)
 {
 
 #ifdef SCRIPT_DEBUG
@@ -864,22 +787,22 @@ int compileContinue()
 #endif // SCRIPT_DEBUG
 
 	// Not allowed to indent after a continue
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
 
-	if (!compilingProgram)
+	if (!script->compilingProgram)
 	{
 		return ERROR_CONTINUE_CANNOT_BE_USED_OUTSIDE_A_PROGRAM;
 	}
 
-	int operation_label = findTopLoopConstructionLabel();
+	int operation_label = findTopLoopConstructionLabel(script);
 
 	if (operation_label == NO_LABEL_FOR_LOOP_ON_STACK)
 		return ERROR_NO_LABEL_FOR_LOOP_ON_STACK_IN_CONTINUE;
 
 	// first label value is the jump for the loop repeat
 
-	dropJump(operation_label);
+	dropJump(script, operation_label);
 
 	return ERROR_OK;
 }
@@ -890,101 +813,101 @@ int compileContinue()
 
 const char clearVariablesCommand[] = "VC";
 
-int clearProgram()
+int clearProgram(struct HullOSScriptContext *script)
 {
 #ifdef SCRIPT_DEBUG
 	Serial.print(F("Performing clear program: "));
 #endif // SCRIPT_DEBUG
 
 
-	if (compilingProgram)
+	if (script->compilingProgram)
 	{
 		return ERROR_CLEAR_WHEN_COMPILING_PROGRAM;
 	}
 
-	sendCommand(clearVariablesCommand);
+	sendCommand(script, clearVariablesCommand);
 
 	return ERROR_OK;
 }
 
 const char runCommand[] = "RS";
 
-int runProgram()
+int runProgram(struct HullOSScriptContext *script)
 {
 #ifdef SCRIPT_DEBUG
 	Serial.print(F("Performing run program: "));
 #endif // SCRIPT_DEBUG
 
-	if (compilingProgram)
+	if (script->compilingProgram)
 	{
 		return ERROR_RUN_WHEN_COMPILING_PROGRAM;
 	}
 
-	sendCommand(runCommand);
+	sendCommand(script, runCommand);
 
 	return ERROR_OK;
 }
 
 const char waitCommand[] = "CA";
 
-int compileWait()
+int compileWait(struct HullOSScriptContext *script)
 {
 	// Not allowed to indent after a wait
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
-	sendCommand(waitCommand);
+	sendCommand(script, waitCommand);
 
 	return ERROR_OK;
 }
 
 const char stopCommand[] = "RH";
 
-int compileStop()
+int compileStop(struct HullOSScriptContext *script)
 {
 
 	// Not allowed to indent after a sound
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
-	if (compilingProgram)
+	if (script->compilingProgram)
 	{
 		return ERROR_STOP_WHEN_COMPILING_PROGRAM;
 	}
 
-	sendCommand(stopCommand);
+	sendCommand(script, stopCommand);
 	return ERROR_OK;
 }
 
 const char clearCommand[] = "RC";
 const char beginCommand[] = "RM";
 
-int compileBegin()
+int compileBegin(struct HullOSScriptContext *script)
 {
 	// Not allowed to indent after a begin
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
-	if (compilingProgram)
+	if (script->compilingProgram)
 	{
 		return ERROR_BEGIN_WHEN_COMPILING_PROGRAM;
 	}
 
-	beginCompilingStatements();
-	sendCommand(clearCommand);
-	endCommand();
-	sendCommand(beginCommand);
+	beginCompilingStatements(script);
+	sendCommand(script, clearCommand);
+	endCommand(script);
+	sendCommand(script, beginCommand);
 	return ERROR_OK;
 }
 
-int compileEnd()
+int compileEnd(struct HullOSScriptContext *script)
 {
 	// Not allowed to indent after a end
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
-	if (!compilingProgram)
+	if (!script->compilingProgram)
 	{
 		return ERROR_END_WHEN_NOT_COMPILING_PROGRAM;
 	}
 
-	endCompilingStatements();
+	endCompilingStatements(script);
 
 	return ERROR_OK;
 }
@@ -992,28 +915,28 @@ int compileEnd()
 // compile a print statement
 // The command is followed by an expression or a string of text enclosed in " characters
 //
-int compilePrint()
+int compilePrint(struct HullOSScriptContext *script)
 {
 	// Not allowed to indent after a print
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
 	// first character of the write command
-	outputFunction('W');
+	script->outputFunction('W');
 
-	skipInputSpaces();
+	skipInputSpaces(script);
 
-	if (*bufferPos == '"')
+	if (*script->bufferPos == '"')
 	{
 		// start of a message - just drop out the string of text
-		outputFunction('T');
+		script->outputFunction('T');
 
-		bufferPos++; // skip the starting double quote
-		while (*bufferPos != 0 && *bufferPos != '"')
+		script->bufferPos++; // skip the starting double quote
+		while (*script->bufferPos != 0 && *script->bufferPos != '"')
 		{
-			outputFunction(*bufferPos);
-			bufferPos++;
+			script->outputFunction(*script->bufferPos);
+			script->bufferPos++;
 		}
-		if (*bufferPos == 0)
+		if (*script->bufferPos == 0)
 		{
 			return ERROR_MISSING_CLOSE_QUOTE_ON_PRINT;
 		}
@@ -1025,25 +948,25 @@ int compilePrint()
 	else 
 	{
 		// start of a value - just drop out the expression
-		outputFunction('V');
+		script->outputFunction('V');
 		// dropping a value - just process it
-		return processValue();
+		return processValue(script);
 	}
 }
 
 const char newlineCommand[] = "WL";
 
-int compilePrintln()
+int compilePrintln(struct HullOSScriptContext *script)
 {
 	// Not allowed to indent after a println
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
-	compilePrint();
+	compilePrint(script);
 
 	// Going to follow this command with another
-	endCommand();
+	endCommand(script);
 
-	sendCommand(newlineCommand);
+	sendCommand(script, newlineCommand);
 	return ERROR_OK;
 }
 
@@ -1052,76 +975,76 @@ int compilePrintln()
 // The script line is not buffered, and must not change while this function is running
 
 
-int compileDirectCommand()
+int compileDirectCommand(struct HullOSScriptContext *script)
 {
 	// Not allowed to indent after a sound
-	previousStatementStartedBlock = false;
+	script->previousStatementStartedBlock = false;
 
-	while (*bufferPos)
+	while (*script->bufferPos)
 	{
-		outputFunction(*bufferPos);
-		bufferPos++;
+		script->outputFunction(*script->bufferPos);
+		script->bufferPos++;
 	}
 	return ERROR_OK;
 }
 
-int processCommand(unsigned char commandNo)
+int processCommand(struct HullOSScriptContext *script, unsigned char commandNo)
 {
 	switch (commandNo)
 	{
 	case COMMAND_DELAY:// delay
-		return compileDelay();
+		return compileDelay(script);
 
 	case COMMAND_IF:// if
-		return compileIf();
+		return compileIf(script);
 
 	case COMMAND_WHILE:// while
-		return compileWhile();
+		return compileWhile(script);
 
 	case COMMAND_CLEAR: // clear	
-		return clearProgram();
+		return clearProgram(script);
 
 	case COMMAND_RUN: // run
-		return runProgram();
+		return runProgram(script);
 
 	case COMMAND_ELSE: // else
-		return compileElse();
+		return compileElse(script);
 
 	case COMMAND_FOREVER: // forever
-		return compileForever();
+		return compileForever(script);
 
 	case COMMAND_SET:
-		return compileAssignment();
+		return compileAssignment(script);
 
 	case COMMAND_WAIT:
-		return compileWait();
+		return compileWait(script);
 
 	case COMMAND_STOP:
-		return compileStop();
+		return compileStop(script);
 
 	case COMMAND_BEGIN:
-		return compileBegin();
+		return compileBegin(script);
 
 	case COMMAND_END:
-		return compileEnd();
+		return compileEnd(script);
 
 	case COMMAND_PRINT:
-		return compilePrint();
+		return compilePrint(script);
 
 	case COMMAND_PRINTLN:
-		return compilePrintln();
+		return compilePrintln(script);
 
 	case COMMAND_SYSTEM_COMMAND:
-		return compileDirectCommand();
+		return compileDirectCommand(script);
 
 	case COMMAND_BREAK:
-		return compileBreak();
+		return compileBreak(script);
 
 	case COMMAND_CONTINUE:
-		return compileContinue();
+		return compileContinue(script);
 
 	default:
-		return compileAssignment();
+		return compileAssignment(script);
 	}
 
 	return ERROR_INVALID_COMMAND;
@@ -1135,7 +1058,7 @@ int processCommand(unsigned char commandNo)
 
 //#define SCRIPT_DEBUG_INDENT_OUT
 
-int indentOutToNewIndentLevel(unsigned char indent, int commandNo)
+int indentOutToNewIndentLevel(struct HullOSScriptContext *script, unsigned char indent, int commandNo)
 {
 	int result;
 	int labelNo;
@@ -1147,15 +1070,15 @@ int indentOutToNewIndentLevel(unsigned char indent, int commandNo)
 	Serial.print(" Command: ");
 	Serial.print(commandNo);
 	Serial.print(" Current Indent Level: ");
-	Serial.println(currentIndentLevel);
+	Serial.println(script->currentIndentLevel);
 #endif
 
-	while (indent < currentIndentLevel)
+	while (indent < script->currentIndentLevel)
 	{
 #ifdef SCRIPT_DEBUG_INDENT_OUT
 		Serial.println("Looping");
 #endif
-		if (operation_stack_empty())
+		if (operation_stack_empty(script))
 		{
 #ifdef SCRIPT_DEBUG_INDENT_OUT
 			Serial.println("Operation stack empty");
@@ -1166,7 +1089,7 @@ int indentOutToNewIndentLevel(unsigned char indent, int commandNo)
 		}
 
 		// pull back the indent level to the previous one
-		currentIndentLevel = top_operation_indent_level();
+		script->currentIndentLevel = top_operation_indent_level(script);
 
 		// if this indent level is not the same as the indent
 		// level of the item on the top of the stack we just close
@@ -1174,12 +1097,12 @@ int indentOutToNewIndentLevel(unsigned char indent, int commandNo)
 
 #ifdef SCRIPT_DEBUG_INDENT_OUT
 		Serial.print("New Current Indent Level: ");
-		Serial.println(currentIndentLevel);
+		Serial.println(script->currentIndentLevel);
 #endif
 		// Generate the code to match the end of the 
 		// enclosing statement
 
-		switch (top_operation_type())
+		switch (top_operation_type(script))
 		{
 			case IF_CONSTRUCTION_STACK_ITEM:
 	#ifdef SCRIPT_DEBUG_INDENT_OUT
@@ -1192,7 +1115,7 @@ int indentOutToNewIndentLevel(unsigned char indent, int commandNo)
 				// one that matches. Any other items that we find (including do) will
 				// need to be closed off at this point
 
-				if (currentIndentLevel == indent && 
+				if (script->currentIndentLevel == indent && 
 					commandNo == COMMAND_ELSE)
 				{
 	#ifdef SCRIPT_DEBUG_INDENT_OUT
@@ -1206,55 +1129,55 @@ int indentOutToNewIndentLevel(unsigned char indent, int commandNo)
 					// get the label number for the label reached if we jump 
 					// past the code controlled by the if
 
-					labelNo = pop_operation_count();
+					labelNo = pop_operation_count(script);
 
 					// drop a jump to the next label number
 					// this number was reserved when the if was created
 					// this is the position which will mark the end of the 
 					// code performed by the else - when we see the endif
 
-					dropJumpCommand(labelNo + 1);
+					dropJumpCommand(script, labelNo + 1);
 
 					// Now drop a label to serve as the destination of the 
 					// jump past the if clause code. This is the code obeyed 
 					// if else is the case.
 
-					dropLabel(labelNo);  // drop the label that is jumped
+					dropLabel(script, labelNo);  // drop the label that is jumped
 
 												  // Now need to push a label number for the endif to use
 												  // to create the destination label for the jump past the 
 												  // else code
 
-					push_operation(IF_CONSTRUCTION_STACK_ITEM, labelNo + 1);
+					push_operation(script, IF_CONSTRUCTION_STACK_ITEM, labelNo + 1);
 
 					// Allow statements after this one to indent
-					previousStatementStartedBlock = true;
+					script->previousStatementStartedBlock = true;
 				}
 				else
 				{
 	#ifdef SCRIPT_DEBUG_INDENT_OUT
 					Serial.print("...on its own");
 	#endif
-					dropLabelStatement(pop_operation_count());
+					dropLabelStatement(script, pop_operation_count(script));
 				}
 				break;
 
 			case WHILE_CONSTRUCTION_STACK_ITEM:
 
-				labelNo = pop_operation_count();
+				labelNo = pop_operation_count(script);
 
-				dropJumpCommand(labelNo);
+				dropJumpCommand(script, labelNo);
 
-				dropLabelStatement(labelNo + 1);
+				dropLabelStatement(script, labelNo + 1);
 				break;
 
 			case FOREVER_CONSTRUCTION_STACK_ITEM:
 
-				labelNo = pop_operation_count();
+				labelNo = pop_operation_count(script);
 
-				dropJumpCommand(labelNo);
+				dropJumpCommand(script, labelNo);
 
-				dropLabelStatement(labelNo + 1);
+				dropLabelStatement(script, labelNo + 1);
 				break;
 
 			default:
@@ -1265,7 +1188,7 @@ int indentOutToNewIndentLevel(unsigned char indent, int commandNo)
 	// When we get here the indent of this statement should match the 
 	// the indent level pushed onto the operation stack when we started
 	// this block
-	if (indent != currentIndentLevel)
+	if (indent != script->currentIndentLevel)
 	{
 		result = ERROR_INDENT_OUTWARDS_DOES_NOT_MATCH_ENCLOSING_STATEMENT_INDENT;
 	}
@@ -1278,26 +1201,26 @@ int indentOutToNewIndentLevel(unsigned char indent, int commandNo)
 
 }
 
-int decodeScriptLine(char * input, void(*output) (unsigned char))
+int decodeScriptLine(struct HullOSScriptContext *script, char * input, void(*output) (unsigned char))
 {
 
 	// Set the shared buffer pointer to point to the statement being decoded
-	bufferPos = input;
+	script->bufferPos = input;
 
 	// Set the output function to point to the statement being output
-	outputFunction = output;
+	script->outputFunction = output;
 
 	int result;
 
-	unsigned char indent = skipInputSpaces();
+	unsigned char indent = skipInputSpaces(script);
 
 	// Lines that start with a # are comments
-	if (*bufferPos == '#')
+	if (*script->bufferPos == '#')
 	{
 		return ERROR_OK;
 	}
 
-	int commandNo = decodeCommandName();
+	int commandNo = decodeCommandName(script);
 
 	if (commandNo == COMMAND_EMPTY_LINE)
 	{
@@ -1307,9 +1230,9 @@ int decodeScriptLine(char * input, void(*output) (unsigned char))
 
 #ifdef SCRIPT_DEBUG
 
-	Serial.print(previousStatementStartedBlock);
+	Serial.print(script->previousStatementStartedBlock);
 	Serial.print(" Current indent: ");
-	Serial.print(currentIndentLevel);
+	Serial.print(script->currentIndentLevel);
 	Serial.print("Indent: ");
 	Serial.println(indent);
 
@@ -1322,31 +1245,31 @@ int decodeScriptLine(char * input, void(*output) (unsigned char))
 	// sort out any outward indents
 
 
-	if (compilingProgram)
+	if (script->compilingProgram)
 	{
-		if (indent < currentIndentLevel)
+		if (indent < script->currentIndentLevel)
 		{
 			// new statement is being outdented 
-			result = indentOutToNewIndentLevel(indent, commandNo);
+			result = indentOutToNewIndentLevel(script, indent, commandNo);
 			if (result == ERROR_OK)
 			{
-				result = processCommand(commandNo);
+				result = processCommand(script, commandNo);
 			}
 		}
 		else
 		{
-			if (indent > currentIndentLevel)
+			if (indent > script->currentIndentLevel)
 			{
 				// Indenting the text
 				// Only valid if we were pre-ceded by a 
 				// statement that can cause an indent
-				if (previousStatementStartedBlock)
+				if (script->previousStatementStartedBlock)
 				{
 					// It's OK to increase the indent if you're starting a new block
 					// Set the new indent level for this block
-					currentIndentLevel = indent;
+					script->currentIndentLevel = indent;
 					// Now process the command
-					result = processCommand(commandNo);
+					result = processCommand(script, commandNo);
 				}
 				else
 				{
@@ -1357,24 +1280,24 @@ int decodeScriptLine(char * input, void(*output) (unsigned char))
 			else
 			{
 				// At the same level - just process the command
-				result = processCommand(commandNo);
+				result = processCommand(script, commandNo);
 			}
 		}
 	}
 	else
 	{
 		// Immediate mode
-		result = processCommand(commandNo);
+		result = processCommand(script, commandNo);
 	}
 
 	if (result != ERROR_OK)
 	{
-		abandonCompilation();
+		abandonCompilation(script);
 
-		if (compilingProgram)
+		if (script->compilingProgram)
 		{
 			Serial.print("Line:  ");
-			Serial.print(scriptLineNumber);
+			Serial.print(script->scriptLineNumber);
 			Serial.print(" ");
 		}
 
@@ -1384,12 +1307,12 @@ int decodeScriptLine(char * input, void(*output) (unsigned char))
 		Serial.println(input);
 	}
 
-	endCommand();
+	endCommand(script);
 
 	return result;
 }
 
-int decodeScriptChar(char b, void(*output) (unsigned char))
+int decodeScriptChar(struct HullOSScriptContext *script, char b, void(*output) (unsigned char))
 {
 	// convert linefeeds into carriage return
 
@@ -1400,25 +1323,28 @@ int decodeScriptChar(char b, void(*output) (unsigned char))
 	if ((b >= 'A') && (b <= 'Z'))
 		b = b + 32;
 
-	if (scriptInputBufferPos == SCRIPT_INPUT_BUFFER_LENGTH)
+	if (script->scriptInputBufferPos == SCRIPT_INPUT_BUFFER_LENGTH)
 		return ERROR_SCRIPT_INPUT_BUFFER_OVERFLOW;
 
 	if (b == STATEMENT_TERMINATOR)
 	{
-		scriptInputBuffer[scriptInputBufferPos] = 0;
-		int result = decodeScriptLine(scriptInputBuffer, output);
-		scriptLineNumber++; // move on to the next line
-		resetScriptLine();
+		script->scriptInputBuffer[script->scriptInputBufferPos] = 0;
+		int result = decodeScriptLine(script, script->scriptInputBuffer, output);
+		script->scriptLineNumber++; // move on to the next line
+		resetScriptLine(script);
 		return result;
 	}
 
-	scriptInputBuffer[scriptInputBufferPos++] = b;
+	script->scriptInputBuffer[script->scriptInputBufferPos++] = b;
 	return ERROR_OK;
 }
 
 void testScript()
 {
-	beginCompilingStatements();
+	struct HullOSScriptContext testContext;
+	struct HullOSScriptContext *script = &testContext;
+
+	beginCompilingStatements(script);
 	clearVariables();
 
 #ifdef SCRIPT_DEBUG
@@ -1436,14 +1362,14 @@ void testScript()
 
 #ifdef SCRIPT_MOVE_TEST
 
-	decodeScriptLine("move 50", dumpByte);
-	decodeScriptLine("move 50 intime 10", dumpByte);
-	decodeScriptLine("move", dumpByte);
-	decodeScriptLine("move ", dumpByte);
-	decodeScriptLine("move zz", dumpByte);
-	decodeScriptLine("move 50zz", dumpByte);
-	decodeScriptLine("move 50 intime", dumpByte);
-	decodeScriptLine("move 50 intime 10", dumpByte);
+	decodeScriptLine(script, "move 50", dumpByte);
+	decodeScriptLine(script, "move 50 intime 10", dumpByte);
+	decodeScriptLine(script, "move", dumpByte);
+	decodeScriptLine(script, "move ", dumpByte);
+	decodeScriptLine(script, "move zz", dumpByte);
+	decodeScriptLine(script, "move 50zz", dumpByte);
+	decodeScriptLine(script, "move 50 intime", dumpByte);
+	decodeScriptLine(script, "move 50 intime 10", dumpByte);
 
 #endif
 
@@ -1451,40 +1377,40 @@ void testScript()
 
 #ifdef SCRIPT_TURN_TEST
 
-	decodeScriptLine("turn 50", dumpByte);
-	decodeScriptLine("turn 50 intime 10", dumpByte);
-	decodeScriptLine("turn", dumpByte);
-	decodeScriptLine("turn ", dumpByte);
-	decodeScriptLine("turn zz", dumpByte);
-	decodeScriptLine("turn 50zz", dumpByte);
-	decodeScriptLine("turn 50 intime", dumpByte);
-	decodeScriptLine("turn 50 intime 10", dumpByte);
+	decodeScriptLine(script, "turn 50", dumpByte);
+	decodeScriptLine(script, "turn 50 intime 10", dumpByte);
+	decodeScriptLine(script, "turn", dumpByte);
+	decodeScriptLine(script, "turn ", dumpByte);
+	decodeScriptLine(script, "turn zz", dumpByte);
+	decodeScriptLine(script, "turn 50zz", dumpByte);
+	decodeScriptLine(script, "turn 50 intime", dumpByte);
+	decodeScriptLine(script, "turn 50 intime 10", dumpByte);
 
 #endif
 
 	//#define SCRIPT_ARC_TEST
 
 #ifdef SCRIPT_ARC_TEST
-	decodeScriptLine("arc 90, 180", dumpByte);
-	decodeScriptLine("arc 90, 180 intime 100", dumpByte);
-	decodeScriptLine("arc 90 , 80", dumpByte);
-	decodeScriptLine("arc 90 ,80", dumpByte);
-	decodeScriptLine("arc", dumpByte);
-	decodeScriptLine("arc ", dumpByte);
-	decodeScriptLine("arc zz", dumpByte);
-	decodeScriptLine("arc 90", dumpByte);
-	decodeScriptLine("arc 90,", dumpByte);
-	decodeScriptLine("arc 90,zz", dumpByte);
-	decodeScriptLine("arc 90+ 80", dumpByte);
+	decodeScriptLine(script, "arc 90, 180", dumpByte);
+	decodeScriptLine(script, "arc 90, 180 intime 100", dumpByte);
+	decodeScriptLine(script, "arc 90 , 80", dumpByte);
+	decodeScriptLine(script, "arc 90 ,80", dumpByte);
+	decodeScriptLine(script, "arc", dumpByte);
+	decodeScriptLine(script, "arc ", dumpByte);
+	decodeScriptLine(script, "arc zz", dumpByte);
+	decodeScriptLine(script, "arc 90", dumpByte);
+	decodeScriptLine(script, "arc 90,", dumpByte);
+	decodeScriptLine(script, "arc 90,zz", dumpByte);
+	decodeScriptLine(script, "arc 90+ 80", dumpByte);
 #endif
 
 	//#define SET_TEST
 #ifdef SET_TEST
-	decodeScriptLine("move x", dumpByte);
-	decodeScriptLine("set x=99", dumpByte);
-	decodeScriptLine("move x", dumpByte);
-	decodeScriptLine("set x=x+1", dumpByte);
-	decodeScriptLine("move x+10", dumpByte);
+	decodeScriptLine(script, "move x", dumpByte);
+	decodeScriptLine(script, "set x=99", dumpByte);
+	decodeScriptLine(script, "move x", dumpByte);
+	decodeScriptLine(script, "set x=x+1", dumpByte);
+	decodeScriptLine(script, "move x+10", dumpByte);
 
 #endif
 
@@ -1492,42 +1418,42 @@ void testScript()
 
 #ifdef DELAY_TEST
 
-	decodeScriptLine("delay 100", dumpByte);
-	decodeScriptLine("delay", dumpByte);
-	decodeScriptLine("delay ", dumpByte);
-	decodeScriptLine("delay zz", dumpByte);
+	decodeScriptLine(script, "delay 100", dumpByte);
+	decodeScriptLine(script, "delay", dumpByte);
+	decodeScriptLine(script, "delay ", dumpByte);
+	decodeScriptLine(script, "delay zz", dumpByte);
 #endif
 
 	//#define COLOUR_TEST
 
 #ifdef COLOUR_TEST
-	decodeScriptLine("colour 255,128,0", dumpByte);
-	decodeScriptLine("colour 255,128,", dumpByte);
-	decodeScriptLine("colour 255,128", dumpByte);
-	decodeScriptLine("colour 255,", dumpByte);
-	decodeScriptLine("colour 255", dumpByte);
-	decodeScriptLine("colour ", dumpByte);
-	decodeScriptLine("colour", dumpByte);
-
-	decodeScriptLine("color 255,128,0", dumpByte);
-	decodeScriptLine("color 255,128,", dumpByte);
-	decodeScriptLine("color 255,128", dumpByte);
-	decodeScriptLine("color 255,", dumpByte);
-	decodeScriptLine("color 255", dumpByte);
-	decodeScriptLine("color ", dumpByte);
-	decodeScriptLine("color", dumpByte);
+	decodeScriptLine(script, "colour 255,128,0", dumpByte);
+	decodeScriptLine(script, "colour 255,128,", dumpByte);
+	decodeScriptLine(script, "colour 255,128", dumpByte);
+	decodeScriptLine(script, "colour 255,", dumpByte);
+	decodeScriptLine(script, "colour 255", dumpByte);
+	decodeScriptLine(script, "colour ", dumpByte);
+	decodeScriptLine(script, "colour", dumpByte);
+
+	decodeScriptLine(script, "color 255,128,0", dumpByte);
+	decodeScriptLine(script, "color 255,128,", dumpByte);
+	decodeScriptLine(script, "color 255,128", dumpByte);
+	decodeScriptLine(script, "color 255,", dumpByte);
+	decodeScriptLine(script, "color 255", dumpByte);
+	decodeScriptLine(script, "color ", dumpByte);
+	decodeScriptLine(script, "color", dumpByte);
 
 #endif
 
 	//#define IF_TEST
 
 #ifdef IF_TEST
-	decodeScriptLine("if 1 > 20", dumpByte);
-	decodeScriptLine("colour 255,128,0", dumpByte);
-	decodeScriptLine("endif", dumpByte);
-	decodeScriptLine("if 1 >= 20", dumpByte);
-	decodeScriptLine("colour 255,128,255", dumpByte);
-	decodeScriptLine("endif", dumpByte);
+	decodeScriptLine(script, "if 1 > 20", dumpByte);
+	decodeScriptLine(script, "colour 255,128,0", dumpByte);
+	decodeScriptLine(script, "endif", dumpByte);
+	decodeScriptLine(script, "if 1 >= 20", dumpByte);
+	decodeScriptLine(script, "colour 255,128,255", dumpByte);
+	decodeScriptLine(script, "endif", dumpByte);
 
 #endif
 
@@ -1535,13 +1461,13 @@ void testScript()
 
 #ifdef IF_ELSE_TEST
 
-	decodeScriptLine("do", dumpByte);
-	decodeScriptLine("if %dist > 20", dumpByte);
-	decodeScriptLine("    colour 255,0,0", dumpByte);
-	decodeScriptLine("else", dumpByte);
-	decodeScriptLine("    colour 0,255,0", dumpByte);
-	decodeScriptLine("endif", dumpByte);
-	decodeScriptLine("forever", dumpByte);
+	decodeScriptLine(script, "do", dumpByte);
+	decodeScriptLine(script, "if %dist > 20", dumpByte);
+	decodeScriptLine(script, "    colour 255,0,0", dumpByte);
+	decodeScriptLine(script, "else", dumpByte);
+	decodeScriptLine(script, "    colour 0,255,0", dumpByte);
+	decodeScriptLine(script, "endif", dumpByte);
+	decodeScriptLine(script, "forever", dumpByte);
 
 #endif
 
@@ -1549,27 +1475,27 @@ void testScript()
 	//#define DO_TEST
 
 #ifdef DO_TEST
-	decodeScriptLine("set count = 0", dumpByte);
-	decodeScriptLine("do", dumpByte);
-	decodeScriptLine("colour 255,128,255", dumpByte);
-	decodeScriptLine("delay 10", dumpByte);
-	decodeScriptLine("colour 0,0,0", dumpByte);
-	decodeScriptLine("delay 10", dumpByte);
-	decodeScriptLine("set count = count + 1", dumpByte);
-	decodeScriptLine("until count > 10", dumpByte);
+	decodeScriptLine(script, "set count = 0", dumpByte);
+	decodeScriptLine(script, "do", dumpByte);
+	decodeScriptLine(script, "colour 255,128,255", dumpByte);
+	decodeScriptLine(script, "delay 10", dumpByte);
+	decodeScriptLine(script, "colour 0,0,0", dumpByte);
+	decodeScriptLine(script, "delay 10", dumpByte);
+	decodeScriptLine(script, "set count = count + 1", dumpByte);
+	decodeScriptLine(script, "until count > 10", dumpByte);
 #endif
 
 	//#define WHILE_TEST
 
 #ifdef WHILE_TEST
-	decodeScriptLine("set count = 0", dumpByte);
-	decodeScriptLine("while count < 10", dumpByte);
-	decodeScriptLine("colour 255,128,255", dumpByte);
-	decodeScriptLine("delay 10", dumpByte);
-	decodeScriptLine("colour 0,0,0", dumpByte);
-	decodeScriptLine("delay 10", dumpByte);
-	decodeScriptLine("set count = count + 1", dumpByte);
-	decodeScriptLine("endwhile", dumpByte);
+	decodeScriptLine(script, "set count = 0", dumpByte);
+	decodeScriptLine(script, "while count < 10", dumpByte);
+	decodeScriptLine(script, "colour 255,128,255", dumpByte);
+	decodeScriptLine(script, "delay 10", dumpByte);
+	decodeScriptLine(script, "colour 0,0,0", dumpByte);
+	decodeScriptLine(script, "delay 10", dumpByte);
+	decodeScriptLine(script, "set count = count + 1", dumpByte);
+	decodeScriptLine(script, "endwhile", dumpByte);
 #endif
 
 
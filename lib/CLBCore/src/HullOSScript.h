@@ -92,81 +92,89 @@ extern const char commandNames[];
 
 #define SCRIPT_INPUT_BUFFER_LENGTH 80
 
-extern char scriptInputBuffer[];
+#define STACK_SIZE 10
 
-extern int scriptInputBufferPos;
+struct stackItem {
+	unsigned char constructionType;
+	int count;
+	unsigned char indentLevel;
+};
 
-// The line number in the script
-// Used when reporting errors
+// Everything the script compiler knows about the script it is working on
+// Each source of script text has its own context, so that more than one
+// script can be compiled at the same time
 
-extern int scriptLineNumber;
+struct HullOSScriptContext {
 
-// Flag to indicate an error has been detected
-// Used for error reporting
+	char scriptInputBuffer[SCRIPT_INPUT_BUFFER_LENGTH];
 
-extern bool programError;
+	int scriptInputBufferPos;
 
-// Flag to indicate that a program is being compiled - i.e. a begin keyword has been detected
+	// The line number in the script
+	// Used when reporting errors
 
-extern bool compilingProgram;
+	int scriptLineNumber;
 
+	// Flag to indicate an error has been detected
+	// Used for error reporting
 
-// The start position of the command in the input buffer
-// Set by decodeCommand
-// Shared with all the functions below
-extern char * commandStartPos;
+	bool programError;
 
-// THIS MEANS THAT THIS COMPILER IS NOT REENTRANT
+	// Flag to indicate that a program is being compiled - i.e. a begin keyword has been detected
 
-// The position in the input buffer 
-// Set to the start of the command buffer by decodeScriptLine
-// Shared with all the functions below and updated by them
+	bool compilingProgram;
 
-// THIS MEANS THAT THIS COMPILER IS NOT REENTRANT
+	// The start position of the command in the input buffer
+	// Set by decodeCommand
 
-extern char * bufferPos;
+	char * commandStartPos;
 
-// The position in the command names
-// Set to the start of the command names by decodeScriptLine
-// Shared with all the functions below and updated by some
+	// The position in the input buffer 
+	// Set to the start of the command buffer by decodeScriptLine
+	// Updated by the functions that compile each part of the statement
 
-// THIS ALSO MEANS THAT THIS COMPILER IS NOT REENTRANT
+	char * bufferPos;
 
-extern int scriptCommandPos;
+	// The position in the command names
+	// Set to the start of the command names by decodeScriptLine
 
-// The indent level of the current statement
-// Starts at 0 and increases with each block construction
-// Shared with all the functions below and updated by some
+	int scriptCommandPos;
 
-// THIS ALSO MEANS THAT THIS COMPILER IS NOT REENTRANT
+	// The indent level of the current statement
+	// Starts at 0 and increases with each block construction
 
-extern uint8_t currentIndentLevel;
+	uint8_t currentIndentLevel;
 
-// True if the previous statement started a block
-// This statement is allowed to set a new indent level
-//
+	// True if the previous statement started a block
+	// This statement is allowed to set a new indent level
 
-extern bool previousStatementStartedBlock;
+	bool previousStatementStartedBlock;
 
-extern bool displayErrors;
+	// The function to be used to send out comipiled bytes. 
+	// Set at the start of the line by decodeScriptLine
+
+	void(*outputFunction) (uint8_t);
+
+	// The block constructions that have not been closed yet
 
-// The function to be used to send out comipiled bytes. 
-// Set at the start of the line by decodeScriptLine
-// Shared with all the functions below
+	struct stackItem operation[STACK_SIZE];
 
-// YET ANOTHER REASON THAT THIS COMPILER IS NOT REENTRANT
+	int operationStackPointer;
 
-extern void(*outputFunction) (uint8_t);
+	int labelCounter;
+};
+
+extern bool displayErrors;
 
 #define COMMAND_NAME_TERMINATOR '#'
 #define STATEMENT_TERMINATOR 0x0D
 
-bool spinToCommandEnd();
+bool spinToCommandEnd(struct HullOSScriptContext *script);
 
-uint8_t skipInputSpaces();
+uint8_t skipInputSpaces(struct HullOSScriptContext *script);
 
-void writeBytesFromBuffer(int length);
-void writeMatchingStringFromBuffer(char * string);
+void writeBytesFromBuffer(struct HullOSScriptContext *script, int length);
+void writeMatchingStringFromBuffer(struct HullOSScriptContext *script, char * string);
 
 enum ScriptCompareCommandResult
 {
@@ -178,4 +186,4 @@ enum ScriptCompareCommandResult
 #define DUMP_BUFFER_SIZE 20
 #define DUMP_BUFFER_LIMIT DUMP_BUFFER_SIZE-1
 
-int decodeScriptChar(char b, void(*output) (unsigned char));
+int decodeScriptChar(struct HullOSScriptContext *script, char b, void(*output) (unsigned char));
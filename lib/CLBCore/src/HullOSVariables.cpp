@@ -171,53 +171,41 @@ struct reading randomReading = { "random", readRandom };
 
 struct reading * readers[NO_OF_HARDWARE_READERS] = { &randomReading, &test };
 
-bool validReading(char * text)
+// Reader number plus one for each hash slot, zero for an empty slot
+int8_t readerIndex[READER_INDEX_SIZE];
+bool readerIndexBuilt = false;
+
+unsigned int readingNameHash(char * name)
 {
-	if (!isReadingNameStart(text))
+	unsigned int hash = 0;
+
+	while (isReadingNameChar(name))
 	{
-		if (diagnosticsOutputLevel & STATEMENT_CONFIRMATION)
-		{
-			Serial.println(F("Reading name first character not valid"));
-		}
-		return false;
+		hash = (hash * 31) + (uint8_t)*name;
+		name++;
 	}
 
+	return hash & (READER_INDEX_SIZE - 1);
+}
+
+void buildReaderIndex()
+{
 	for (int i = 0; i < NO_OF_HARDWARE_READERS; i++)
 	{
-		struct reading * currentReader = readers[i];
+		unsigned int slot = readingNameHash(readers[i]->name);
 
-		char * currentChar = text;
-		char * nameChar = currentReader->name;
-
-		while (true)
+		while (readerIndex[slot] != 0)
 		{
-			if (!*nameChar)
-			{
-				// reached the end of the current reader 
-				// If the corresponding character in the program is not 
-				// a valid part of a name, we can consider this a match
-				if (!isReadingNameChar(currentChar))
-					return true;
-			}
-
-			if (*nameChar != *currentChar)
-			{
-				// not the same
-				// move on to the next one
-				break;
-			}
-
-			// These two match, move on to the next one
-
-			nameChar++;
-			currentChar++;
+			slot = (slot + 1) & (READER_INDEX_SIZE - 1);
 		}
+
+		readerIndex[slot] = i + 1;
 	}
-	// If we get here we've spun through all the names and not found a match
-	return false;
+
+	readerIndexBuilt = true;
 }
 
-struct reading * getReading(char * text)
+int getReadingIndex(char * text)
 {
 	if (!isReadingNameStart(text))
 	{
@@ -225,54 +213,88 @@ struct reading * getReading(char * text)
 		{
 			Serial.println(F("Reading name first character not valid"));
 		}
-		return NULL;
+		return -1;
 	}
 
-	for (int i = 0; i < NO_OF_HARDWARE_READERS; i++)
+	if (!readerIndexBuilt)
 	{
-		struct reading * currentReader = readers[i];
+		buildReaderIndex();
+	}
 
-		char * currentChar = text;
-		char * nameChar = currentReader->name;
+	unsigned int slot = readingNameHash(text);
 
-		while (true)
+	while (readerIndex[slot] != 0)
+	{
+		int readerNo = readerIndex[slot] - 1;
+		char * name = readers[readerNo]->name;
+		int nameLength = strlen(name);
+
+		// The name in the program ends at the first character that
+		// can't be part of a name
+
+		if ((strncmp(name, text, nameLength) == 0) && !isReadingNameChar(text + nameLength))
 		{
-			if (!*nameChar)
-			{
-				// reached the end of the current reader 
-				// If the corresponding character in the program is not 
-				// a valid part of a name, we can consider this a match
-				if (!isReadingNameChar(currentChar))
-				{
-					return currentReader;
-				}
-			}
+			return readerNo;
+		}
 
-			if (*nameChar != *currentChar)
-			{
-				// not the same
-				// move on to the next one
-				break;
-			}
+		slot = (slot + 1) & (READER_INDEX_SIZE - 1);
+	}
 
-			// These two match, move on to the next one
+	return -1;
+}
 
-			nameChar++;
-			currentChar++;
-		}
+bool validReading(char * text)
+{
+	return getReadingIndex(text) >= 0;
+}
+
+struct reading * getReading(char * text)
+{
+	int readerNo = getReadingIndex(text);
+
+	if (readerNo < 0)
+	{
+		return NULL;
 	}
-	// If we get here we've spun through all the names and not found a match
-	return NULL;
+
+	return readers[readerNo];
+}
+
+// The variables of the running HullOS task, set when the task is selected
+
+struct HullOSVariableStore *variableStore = &hullosTasks[0].variableStore;
+
+unsigned int variableNameHash(char * name)
+{
+	unsigned int hash = 0;
+
+	while (isVariableNameChar(name))
+	{
+		hash = (hash * 31) + (uint8_t)*name;
+		name++;
+	}
+
+	return hash & (VARIABLE_INDEX_SIZE - 1);
 }
 
-variable variables[NUMBER_OF_VARIABLES];
+void addVariableToIndex(int position)
+{
+	unsigned int slot = variableNameHash(variableStore->variables[position].name);
+
+	while (variableStore->variableIndex[slot] != 0)
+	{
+		slot = (slot + 1) & (VARIABLE_INDEX_SIZE - 1);
+	}
+
+	variableStore->variableIndex[slot] = position + 1;
+}
 
 void clearVariableSlot(int position)
 {
-	variables[position].empty = true;
-	variables[position].unassigned = true;
-	variables[position].value = 0;
-	variables[position].name[0] = 0;
+	variableStore->variables[position].empty = true;
+	variableStore->variables[position].unassigned = true;
+	variableStore->variables[position].value = 0;
+	variableStore->variables[position].name[0] = 0;
 }
 
 void clearVariables()
@@ -284,6 +306,10 @@ void clearVariables()
 		clearVariableSlot(i);
 	}
 
+	for (int i = 0; i < VARIABLE_INDEX_SIZE; i++)
+	{
+		variableStore->variableIndex[i] = 0;
+	}
 }
 
 void setupVariables()
@@ -293,18 +319,18 @@ void setupVariables()
 
 void setVariable(int position, int value)
 {
-	variables[position].value = value;
-	variables[position].unassigned = false;
+	variableStore->variables[position].value = value;
+	variableStore->variables[position].unassigned = false;
 }
 
 int getVariable(int position)
 {
-	return variables[position].value;
+	return variableStore->variables[position].value;
 }
 
 bool isAssigned(int position)
 {
-	return !variables[position].unassigned;
+	return !variableStore->variables[position].unassigned;
 }
 
 bool isVariableNameStart(char * ch)
@@ -319,7 +345,7 @@ bool isVariableNameChar(char * ch)
 
 bool variableSlotEmpty(int position)
 {
-	return variables[position].empty;
+	return variableStore->variables[position].empty;
 }
 
 int checkIdentifier(char * var)
@@ -369,12 +395,12 @@ bool matchVariable(int position, char * text)
 	for (int i = 0; i < MAX_VARIABLE_NAME_LENGTH; i++)
 	{
 #ifdef VAR_DEBUG
-		Serial.print(variables[position].name[i]);
+		Serial.print(variableStore->variables[position].name[i]);
 		Serial.print(F(":"));
 		Serial.print(*text);
 		Serial.print(F("  "));
 #endif
-		if ((variables[position].name[i] == 0) & !isVariableNameChar(text))
+		if ((variableStore->variables[position].name[i] == 0) & !isVariableNameChar(text))
 		{
 			// variable table has ended at the same time as the variable
 			// we have a match
@@ -382,7 +408,7 @@ bool matchVariable(int position, char * text)
 		}
 
 		// See if we have failed to match
-		if (variables[position].name[i] != *text)
+		if (variableStore->variables[position].name[i] != *text)
 		{
 			return false;
 		}
@@ -398,10 +424,10 @@ bool matchVariable(int position, char * text)
 // used for calculating pointer updates
 int getVariableNameLength(int position)
 {
-	if (variables[position].empty)
+	if (variableStore->variables[position].empty)
 		return 0;
 
-	return strlen(variables[position].name);
+	return strlen(variableStore->variables[position].name);
 }
 
 // A variable name must start with a letter and then contain letters and digits only
@@ -426,8 +452,11 @@ parseOperandResult findVariable(char * name, int *position)
 		return parseOperandResult::INVALID_VARIABLE_NAME;
 	}
 
-	for (int i = 0; i < NUMBER_OF_VARIABLES; i++)
+	unsigned int slot = variableNameHash(name);
+
+	while (variableStore->variableIndex[slot] != 0)
 	{
+		int i = variableStore->variableIndex[slot] - 1;
 #ifdef VAR_DEBUG
 		Serial.print(F("    Checking variable: "));
 		Serial.println(i);
@@ -437,6 +466,8 @@ parseOperandResult findVariable(char * name, int *position)
 			*position = i;
 			return parseOperandResult::OPERAND_OK;
 		}
+
+		slot = (slot + 1) & (VARIABLE_INDEX_SIZE - 1);
 	}
 	return parseOperandResult::VARIABLE_NOT_FOUND;
 }
@@ -494,12 +525,12 @@ parseOperandResult createVariable(char * namePos, int * varPos)
 	for (i = 0; i < MAX_VARIABLE_NAME_LENGTH; i++)
 	{
 		// store the variable name
-		variables[position].name[i] = *decodePos;
+		variableStore->variables[position].name[i] = *decodePos;
 
 		decodePos++;
 
 #ifdef VAR_DEBUG
-		Serial.print(variables[position].name[i]);
+		Serial.print(variableStore->variables[position].name[i]);
 		Serial.print(F(":"));
 		Serial.print(*decodePos);
 		Serial.print(F("  "));
@@ -513,8 +544,9 @@ parseOperandResult createVariable(char * namePos, int * varPos)
 				// end the name string
 				// Note that we declared this one element larger to make room 
 				// for the zero
-				variables[position].name[i + 1] = 0;
-			variables[position].empty = false;
+				variableStore->variables[position].name[i + 1] = 0;
+			variableStore->variables[position].empty = false;
+			addVariableToIndex(position);
 			// return the position value
 			*varPos = position;
 			return parseOperandResult::OPERAND_OK;
@@ -633,7 +665,7 @@ parseOperandResult parseOperand(int * result)
 			return parseOperandResult::USING_UNASSIGNED_VARIABLE;
 		}
 
-		*result = variables[position].value;
+		*result = variableStore->variables[position].value;
 
 		return parseOperandResult::OPERAND_OK;
 	}
@@ -5,9 +5,17 @@
 // Variables can be given names, stored and evaluated
 // Simple two operand expressions only
 
-#define NUMBER_OF_VARIABLES 20
+#define NUMBER_OF_VARIABLES 40
 #define MAX_VARIABLE_NAME_LENGTH 10
 
+// Variable names are found through a hash index of the variable store
+// The index must be a power of two and larger than the store
+#define VARIABLE_INDEX_SIZE 64
+
+#if VARIABLE_INDEX_SIZE <= NUMBER_OF_VARIABLES
+#error The variable index must be larger than the variable store
+#endif
+
 enum parseOperandResult {
 	INVALID_VARIABLE_NAME=1,
 	NO_ROOM_FOR_VARIABLE=2,
@@ -108,9 +116,19 @@ extern struct reading randomReading;
 
 #define NO_OF_HARDWARE_READERS 2
 
+// Hash index of the reader names, a power of two larger than the reader table
+#define READER_INDEX_SIZE 8
+
+#if READER_INDEX_SIZE <= NO_OF_HARDWARE_READERS
+#error The reader index must be larger than the reader table
+#endif
+
 extern struct reading * readers[];
 
 bool validReading(char * text);
+
+// returns the offset of the named reader in the readers table, or -1
+int getReadingIndex(char * text);
 struct reading * getReading(char * text);
 
 struct variable
@@ -122,7 +140,24 @@ struct variable
 	int value;
 };
 
-extern variable variables[];
+// Each HullOS task has its own variables
+
+struct HullOSVariableStore
+{
+	variable variables[NUMBER_OF_VARIABLES];
+
+	// Variable store position plus one for each hash slot, zero for an empty slot
+	// Slots are only removed from the index when all the variables are cleared
+	int8_t variableIndex[VARIABLE_INDEX_SIZE];
+};
+
+// The variables of the running task
+extern struct HullOSVariableStore *variableStore;
+
+// hash of the variable name that starts at name, for the variable index
+unsigned int variableNameHash(char * name);
+void addVariableToIndex(int position);
+
 void clearVariableSlot(int position);
 void clearVariables();
 void setupVariables();
@@ -408,6 +408,8 @@ void startMAX7219MessageScroll()
     MAX7219scrolling = true;
 
     MAX7219setScrollDelay();
+
+    wakeProcess(&max7219MessagesProcess);
 }
 
 void stopMAX7219MessageScroll()
@@ -848,6 +850,7 @@ void updateMAX7219Messages()
 
         if ((int)millisSinceLastScroll < MAX7219FrameDelay)
         {
+            scheduleProcessAt(&max7219MessagesProcess, MAX7219millisAtLastScroll + MAX7219FrameDelay);
             return;
         }
 
@@ -871,7 +874,13 @@ void updateMAX7219Messages()
         }
 
         MAX7219millisAtLastScroll = currentMillis;
+
+        // sleep until the next frame of the scroll
+        scheduleProcessWakeup(&max7219MessagesProcess, MAX7219FrameDelay);
+        return;
     }
+
+    setProcessEventDriven(&max7219MessagesProcess);
 }
 
 void stopMAX7219Messages()
@@ -4,6 +4,7 @@
 #include "connectwifi.h"
 #include "utils.h"
 #include "boot.h"
+#include "settingsstore.h"
 
 struct BootSettings bootSettings;
 
@@ -308,13 +309,21 @@ void updateBoot()
         // config boot mode only lasts for a few seconds after boot
         // then we reset as a device
         unsigned long bootTime = ulongDiff(millis(), bootStartMillis);
+        unsigned long timeoutMillis = bootSettings.accessPointTimeoutSecs*1000;
 
-        if (bootTime > bootSettings.accessPointTimeoutSecs*1000)
+        if (bootTime > timeoutMillis)
         {
             // reboot as a device
             internalReboot(DEVICE_BOOT_MODE);
         }
+
+        // sleep until the timeout
+        scheduleProcessWakeup(&bootProcessDescriptor, timeoutMillis - bootTime + 1);
+        return;
     }
+
+    // nothing to do in the other boot modes
+    setProcessEventDriven(&bootProcessDescriptor);
 }
 
 void stopBoot()
@@ -329,6 +338,7 @@ bool bootStatusOK()
 
 void internalReboot(unsigned char rebootCode)
 {
+    flushSettings();
     setInternalBootCode(rebootCode);
     ESP.restart();
 }
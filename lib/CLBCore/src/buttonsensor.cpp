@@ -191,7 +191,7 @@ bool updateButtonSensor()
 				snprintf(messageBuffer, MAX_MESSAGE_LENGTH, "up  ");
 			}
 
-			pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+			sendToSensorListener(pos);
 			pos->lastReadingMillis = buttonSensor.millisAtLastReading;
 			// move on to the next one
 			pos = pos->nextMessageListener;
@@ -203,7 +203,7 @@ bool updateButtonSensor()
 			// send on pressed - is the button pressed now?
 			if (buttonSensoractiveReading->pressed)
 			{
-				pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+				sendToSensorListener(pos);
 				pos->lastReadingMillis = buttonSensor.millisAtLastReading;
 				// move on to the next one
 				pos = pos->nextMessageListener;
@@ -216,7 +216,7 @@ bool updateButtonSensor()
 			// send on pressed - is the button pressed now?
 			if (!buttonSensoractiveReading->pressed)
 			{
-				pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+				sendToSensorListener(pos);
 				pos->lastReadingMillis = buttonSensor.millisAtLastReading;
 				// move on to the next one
 				pos = pos->nextMessageListener;
@@ -267,9 +267,12 @@ void updateButtonSensorReading()
 	{
 	case SENSOR_OK:
 		updateButtonSensor();
+		scheduleSensorWakeup(&buttonSensor, BUTTON_POLL_INTERVAL_MILLIS);
 		break;
 
+	case BUTTONSENSOR_NOT_FITTED:
 	case BUTTONSENSOR_STOPPED:
+		setSensorEventDriven(&buttonSensor);
 		break;
 	}
 }
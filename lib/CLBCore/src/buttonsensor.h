@@ -13,6 +13,9 @@
 // before we read it
 #define BUTTON_INPUT_DEBOUNCE_TIME 10
 
+// read the button twice in each debounce time
+#define BUTTON_POLL_INTERVAL_MILLIS (BUTTON_INPUT_DEBOUNCE_TIME / 2)
+
 
 struct buttonSensorReading {
 	bool pressed;
@@ -519,7 +519,7 @@ void checkClock(struct clockReading *reading)
 					 reading->hour,
 					 reading->minute,
 					 reading->second);
-			pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+			sendToSensorListener(pos);
 		}
 
 		if (pos->config->sendOptionMask == CLOCK_MINUTE_TICK)
@@ -528,7 +528,7 @@ void checkClock(struct clockReading *reading)
 			{
 				TRACELN("Minute Tick");
 				snprintf(messageBuffer, MAX_MESSAGE_LENGTH, "%02d:%02d", reading->hour, reading->minute);
-				pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+				sendToSensorListener(pos);
 				lastClockMinute = reading->minute;
 			}
 		}
@@ -539,7 +539,7 @@ void checkClock(struct clockReading *reading)
 			{
 				TRACELN("Hour Tick");
 				snprintf(messageBuffer, MAX_MESSAGE_LENGTH, "%02d:%02d", reading->hour, reading->minute);
-				pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+				sendToSensorListener(pos);
 				lastClockHour = reading->hour;
 			}
 		}
@@ -550,7 +550,7 @@ void checkClock(struct clockReading *reading)
 			{
 				TRACELN("Day Tick");
 				snprintf(messageBuffer, MAX_MESSAGE_LENGTH, "%02d:%02d:%02d", reading->day, reading->month, reading->year);
-				pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+				sendToSensorListener(pos);
 				lastClockDay = reading->day;
 			}
 		}
@@ -719,6 +719,15 @@ void updateClockReading()
 		checkTimers(clockActiveReading);
 		checkClock(clockActiveReading);
 	}
+
+	if (clockSensor.status == CLOCK_STOPPED)
+	{
+		setSensorEventDriven(&clockSensor);
+	}
+	else
+	{
+		scheduleSensorWakeup(&clockSensor, CLOCK_POLL_INTERVAL_MILLIS);
+	}
 }
 
 void startClockSensorReading()
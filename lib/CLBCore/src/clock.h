@@ -21,6 +21,9 @@
 
 #define CLOCK_SYNC_TIMEOUT 5
 
+// read the clock twice a second so that no second tick is missed
+#define CLOCK_POLL_INTERVAL_MILLIS 500
+
 #define ALARM1_TRIGGER 1
 #define ALARM2_TRIGGER 2
 #define ALARM3_TRIGGER 3
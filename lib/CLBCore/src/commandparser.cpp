@@ -0,0 +1,509 @@
+#include <Arduino.h>
+
+#include "utils.h"
+#include "commandparser.h"
+
+// The parser accepts the same relaxed forms that the previous JSON library did
+// for hand typed commands: keys may be unquoted, strings may use single quotes
+// and a value that is a bare word other than a number, true, false or null is
+// taken as a string.
+
+char *skipCommandWhitespace(char *pos)
+{
+	while (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')
+	{
+		pos++;
+	}
+	return pos;
+}
+
+int hexDigitValue(char ch)
+{
+	if (ch >= '0' && ch <= '9')
+		return ch - '0';
+	if (ch >= 'a' && ch <= 'f')
+		return ch - 'a' + 10;
+	if (ch >= 'A' && ch <= 'F')
+		return ch - 'A' + 10;
+	return -1;
+}
+
+// Decodes the string starting at the opening quote in place.
+// Sets end to the position for the terminator and returns the position
+// after the closing quote, or NULL if the string is not valid.
+// The decoded text is never longer than the escaped text.
+
+char *parseCommandString(char *pos, char **end)
+{
+	char quote = *pos;
+	pos++;
+	char *dest = pos;
+
+	while (*pos != quote)
+	{
+		char ch = *pos;
+
+		if (ch == 0)
+		{
+			// string not closed
+			return NULL;
+		}
+
+		pos++;
+
+		if (ch != '\\')
+		{
+			*dest++ = ch;
+			continue;
+		}
+
+		ch = *pos;
+		pos++;
+
+		switch (ch)
+		{
+		case '"':
+		case '\'':
+		case '\\':
+		case '/':
+			*dest++ = ch;
+			break;
+		case 'b':
+			*dest++ = '\b';
+			break;
+		case 'f':
+			*dest++ = '\f';
+			break;
+		case 'n':
+			*dest++ = '\n';
+			break;
+		case 'r':
+			*dest++ = '\r';
+			break;
+		case 't':
+			*dest++ = '\t';
+			break;
+		case 'u':
+		{
+			unsigned int code = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				int digit = hexDigitValue(*pos);
+				if (digit < 0)
+				{
+					return NULL;
+				}
+				code = (code << 4) + digit;
+				pos++;
+			}
+
+			// write the character as UTF-8, at most 3 bytes for the 6 read
+			if (code < 0x80)
+			{
+				*dest++ = code;
+			}
+			else if (code < 0x800)
+			{
+				*dest++ = 0xC0 | (code >> 6);
+				*dest++ = 0x80 | (code & 0x3F);
+			}
+			else
+			{
+				*dest++ = 0xE0 | (code >> 12);
+				*dest++ = 0x80 | ((code >> 6) & 0x3F);
+				*dest++ = 0x80 | (code & 0x3F);
+			}
+			break;
+		}
+		default:
+			return NULL;
+		}
+	}
+
+	*end = dest;
+	return pos + 1;
+}
+
+bool isCommandWordChar(char ch)
+{
+	return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+		   (ch >= '0' && ch <= '9') || ch == '_' || ch == '-' || ch == '+' || ch == '.';
+}
+
+bool isCommandNumber(const char *text, bool *isInteger)
+{
+	const char *pos = text;
+
+	if (*pos == '-')
+	{
+		pos++;
+	}
+
+	if (*pos < '0' || *pos > '9')
+	{
+		return false;
+	}
+
+	while (*pos >= '0' && *pos <= '9')
+	{
+		pos++;
+	}
+
+	*isInteger = true;
+
+	if (*pos == '.')
+	{
+		*isInteger = false;
+		pos++;
+		if (*pos < '0' || *pos > '9')
+		{
+			return false;
+		}
+		while (*pos >= '0' && *pos <= '9')
+		{
+			pos++;
+		}
+	}
+
+	if (*pos == 'e' || *pos == 'E')
+	{
+		*isInteger = false;
+		pos++;
+		if (*pos == '+' || *pos == '-')
+		{
+			pos++;
+		}
+		if (*pos < '0' || *pos > '9')
+		{
+			return false;
+		}
+		while (*pos >= '0' && *pos <= '9')
+		{
+			pos++;
+		}
+	}
+
+	return *pos == 0;
+}
+
+// Reads an unquoted value. The text is classified once it has been
+// terminated, which the caller does after reading the next separator.
+
+char *parseCommandWord(char *pos, char **end)
+{
+	while (isCommandWordChar(*pos))
+	{
+		pos++;
+	}
+
+	*end = pos;
+	return pos;
+}
+
+bool classifyCommandWord(commandMember *member)
+{
+	const char *text = member->text;
+	bool isInteger;
+
+	if (strcmp(text, "true") == 0 || strcmp(text, "false") == 0)
+	{
+		member->type = booleanCommandValue;
+		return true;
+	}
+
+	if (strcmp(text, "null") == 0)
+	{
+		member->type = nullCommandValue;
+		return true;
+	}
+
+	if (isCommandNumber(text, &isInteger))
+	{
+		member->type = isInteger ? integerCommandValue : floatCommandValue;
+		return true;
+	}
+
+	return false;
+}
+
+bool parseCommand(parsedCommand *command, const char *json)
+{
+	command->noOfMembers = 0;
+
+	int length = strlen(json);
+
+	if (length >= COMMAND_TEXT_LENGTH)
+	{
+		return false;
+	}
+
+	memcpy(command->text, json, length + 1);
+
+	char *pos = skipCommandWhitespace(command->text);
+
+	if (*pos != '{')
+	{
+		return false;
+	}
+
+	pos = skipCommandWhitespace(pos + 1);
+
+	if (*pos == '}')
+	{
+		return *skipCommandWhitespace(pos + 1) == 0;
+	}
+
+	while (true)
+	{
+		if (command->noOfMembers == COMMAND_MAX_MEMBERS)
+		{
+			return false;
+		}
+
+		commandMember *member = &command->members[command->noOfMembers];
+		char *end;
+
+		// the key
+
+		member->key = pos;
+
+		if (*pos == '"' || *pos == '\'')
+		{
+			member->key = pos + 1;
+			pos = parseCommandString(pos, &end);
+		}
+		else
+		{
+			pos = parseCommandWord(pos, &end);
+		}
+
+		if (pos == NULL || end == member->key)
+		{
+			return false;
+		}
+
+		// read the separator before the terminator is written over it
+		pos = skipCommandWhitespace(pos);
+		if (*pos != ':')
+		{
+			return false;
+		}
+		*end = 0;
+
+		pos = skipCommandWhitespace(pos + 1);
+
+		// the value
+
+		bool isString = (*pos == '"' || *pos == '\'');
+
+		if (isString)
+		{
+			member->text = pos + 1;
+			member->type = stringCommandValue;
+			pos = parseCommandString(pos, &end);
+		}
+		else
+		{
+			member->text = pos;
+			pos = parseCommandWord(pos, &end);
+		}
+
+		if (pos == NULL || (end == member->text && !isString))
+		{
+			// bad string, or an object, array or nothing where a value should be
+			return false;
+		}
+
+		pos = skipCommandWhitespace(pos);
+		char separator = *pos;
+		*end = 0;
+
+		if (!isString && !classifyCommandWord(member))
+		{
+			// a bare word such as colourname:red
+			member->type = stringCommandValue;
+		}
+
+		command->noOfMembers++;
+
+		if (separator == '}')
+		{
+			return *skipCommandWhitespace(pos + 1) == 0;
+		}
+
+		if (separator != ',')
+		{
+			return false;
+		}
+
+		pos = skipCommandWhitespace(pos + 1);
+	}
+}
+
+commandMember *findCommandMember(parsedCommand *command, const char *key)
+{
+	for (int i = 0; i < command->noOfMembers; i++)
+	{
+		if (strcmp(command->members[i].key, key) == 0)
+		{
+			return &command->members[i];
+		}
+	}
+	return NULL;
+}
+
+const char *getCommandMemberText(commandMember *member)
+{
+	if (member == NULL || member->type == nullCommandValue)
+	{
+		return NULL;
+	}
+
+	return member->text;
+}
+
+// The validators read numbers with sscanf, which stops an integer at the
+// exponent, so "-1e2" would be taken as -1. A number with an exponent is
+// written out in full, as the previous JSON library did, which gives -100.
+
+const char *getCommandMemberValueText(commandMember *member, char *buffer, int bufferSize)
+{
+	const char *text = getCommandMemberText(member);
+
+	if (text == NULL || member->type != floatCommandValue || strpbrk(text, "eE") == NULL)
+	{
+		return text;
+	}
+
+	snprintf(buffer, bufferSize, "%f", (float)strtod(text, NULL));
+	return buffer;
+}
+
+const char *getCommandText(parsedCommand *command, const char *key)
+{
+	return getCommandMemberText(findCommandMember(command, key));
+}
+
+bool removeCommandMember(parsedCommand *command, const char *key)
+{
+	commandMember *member = findCommandMember(command, key);
+
+	if (member == NULL)
+	{
+		return false;
+	}
+
+	int position = member - command->members;
+
+	for (int i = position + 1; i < command->noOfMembers; i++)
+	{
+		command->members[i - 1] = command->members[i];
+	}
+
+	command->noOfMembers--;
+	return true;
+}
+
+// Appends a character to the output, returning false if there is no room
+
+bool addCommandJsonChar(char *buffer, int bufferSize, int *length, char ch)
+{
+	if (*length >= bufferSize - 1)
+	{
+		return false;
+	}
+	buffer[*length] = ch;
+	(*length)++;
+	return true;
+}
+
+bool addCommandJsonString(char *buffer, int bufferSize, int *length, const char *text)
+{
+	if (!addCommandJsonChar(buffer, bufferSize, length, '"'))
+	{
+		return false;
+	}
+
+	while (*text)
+	{
+		unsigned char ch = *text;
+
+		if (ch == '"' || ch == '\\')
+		{
+			if (!addCommandJsonChar(buffer, bufferSize, length, '\\') ||
+				!addCommandJsonChar(buffer, bufferSize, length, ch))
+			{
+				return false;
+			}
+		}
+		else if (ch == '\n' || ch == '\r' || ch == '\t')
+		{
+			char escaped = ch == '\n' ? 'n' : (ch == '\r' ? 'r' : 't');
+			if (!addCommandJsonChar(buffer, bufferSize, length, '\\') ||
+				!addCommandJsonChar(buffer, bufferSize, length, escaped))
+			{
+				return false;
+			}
+		}
+		else if (ch < 0x20)
+		{
+			char escape[7];
+			snprintf(escape, 7, "\\u%04x", ch);
+			for (int i = 0; i < 6; i++)
+			{
+				if (!addCommandJsonChar(buffer, bufferSize, length, escape[i]))
+				{
+					return false;
+				}
+			}
+		}
+		else
+		{
+			if (!addCommandJsonChar(buffer, bufferSize, length, ch))
+			{
+				return false;
+			}
+		}
+		text++;
+	}
+
+	return addCommandJsonChar(buffer, bufferSize, length, '"');
+}
+
+// Prints the command as compact JSON, used to store commands for later
+
+bool printCommandJson(parsedCommand *command, char *buffer, int bufferSize)
+{
+	int length = 0;
+	bool ok = addCommandJsonChar(buffer, bufferSize, &length, '{');
+
+	for (int i = 0; ok && i < command->noOfMembers; i++)
+	{
+		commandMember *member = &command->members[i];
+
+		if (i != 0)
+		{
+			ok = addCommandJsonChar(buffer, bufferSize, &length, ',');
+		}
+
+		ok = ok && addCommandJsonString(buffer, bufferSize, &length, member->key);
+		ok = ok && addCommandJsonChar(buffer, bufferSize, &length, ':');
+
+		if (member->type == stringCommandValue)
+		{
+			ok = ok && addCommandJsonString(buffer, bufferSize, &length, member->text);
+		}
+		else
+		{
+			for (const char *ch = member->text; ok && *ch; ch++)
+			{
+				ok = addCommandJsonChar(buffer, bufferSize, &length, *ch);
+			}
+		}
+	}
+
+	ok = ok && addCommandJsonChar(buffer, bufferSize, &length, '}');
+
+	buffer[length] = 0;
+	return ok;
+}
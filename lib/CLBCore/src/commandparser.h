@@ -0,0 +1,55 @@
+#pragma once
+
+// Command parser
+// Commands arrive as a single flat JSON object:
+//     {"process":"pixels","command":"setcolour","red":1,"green":0.5,"blue":0,"seq":3}
+// The text is copied once into the parsedCommand and tokenized in place.
+// Each member holds pointers into that text: the key and the value text are
+// terminated and strings have their escapes decoded where they lie.
+// Numbers are left as the text that was sent so that they can be passed
+// straight to the validators without being printed again, apart from those
+// with an exponent, which getCommandMemberValueText writes out in full.
+// Nested objects and arrays are not part of the command schema and are rejected.
+
+#define COMMAND_TEXT_LENGTH 768
+#define COMMAND_MAX_MEMBERS 20
+
+// room for any float written with %f
+#define COMMAND_NUMBER_TEXT_LENGTH 50
+
+enum CommandValue_Type
+{
+	stringCommandValue,
+	integerCommandValue,
+	floatCommandValue,
+	booleanCommandValue,
+	nullCommandValue
+};
+
+struct commandMember
+{
+	const char *key;
+	const char *text;
+	CommandValue_Type type;
+};
+
+struct parsedCommand
+{
+	char text[COMMAND_TEXT_LENGTH];
+	commandMember members[COMMAND_MAX_MEMBERS];
+	int noOfMembers;
+};
+
+bool parseCommand(parsedCommand *command, const char *json);
+
+commandMember *findCommandMember(parsedCommand *command, const char *key);
+
+// returns the text of the value, NULL if the member is missing or null
+const char *getCommandMemberText(commandMember *member);
+// as above, but with a number that has an exponent written out in the buffer
+const char *getCommandMemberValueText(commandMember *member, char *buffer, int bufferSize);
+const char *getCommandText(parsedCommand *command, const char *key);
+
+bool removeCommandMember(parsedCommand *command, const char *key);
+
+bool printCommandJson(parsedCommand *command, char *buffer, int bufferSize);
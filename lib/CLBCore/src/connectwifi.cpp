@@ -403,6 +403,8 @@ void startWifi()
 		WiFiProcessDescriptor.status = WIFI_TURNED_OFF;
 		WiFi.mode(WIFI_OFF);
 	}
+
+	wakeProcess(&WiFiProcessDescriptor);
 }
 
 void checkWiFiTurnedOff()
@@ -461,6 +463,38 @@ void wifiStatusMessage(char *buffer, int bufferLength)
 	}
 }
 
+// sleep until the state the connection is in needs looking at again
+
+void scheduleWiFiUpdate()
+{
+	switch (WiFiProcessDescriptor.status)
+	{
+	case WIFI_OK:
+	case WIFI_TURNED_OFF:
+		scheduleProcessWakeup(&WiFiProcessDescriptor, WIFI_CHECK_INTERVAL_MILLIS);
+		break;
+
+	case WIFI_SCANNING:
+	case WIFI_CONNECTING:
+		scheduleProcessWakeup(&WiFiProcessDescriptor, WIFI_PROGRESS_POLL_MILLIS);
+		break;
+
+	case WIFI_RECONNECT_TIMER:
+		scheduleProcessAt(&WiFiProcessDescriptor, WiFiTimerStart + WIFI_CONNECT_RETRY_MILLS + 1);
+		break;
+
+	case WIFI_CONFIG_HOSTING_WEBSITE:
+		// the web server process serves the site
+		setProcessEventDriven(&WiFiProcessDescriptor);
+		break;
+
+	default:
+		// errors and starting the access point move on at once
+		wakeProcess(&WiFiProcessDescriptor);
+		break;
+	}
+}
+
 void updateWifi()
 {
 	switch (WiFiProcessDescriptor.status)
@@ -501,6 +535,8 @@ void updateWifi()
 		startReconnectTimer();
 		break;
 	}
+
+	scheduleWiFiUpdate();
 }
 
 bool connectWiFiStatusOK()
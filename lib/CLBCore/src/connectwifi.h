@@ -30,6 +30,11 @@
 #define WIFI_CONNECT_RETRY_MILLS 5000
 #define WIFI_SCAN_TIMEOUT_MILLIS 50000
 #define WIFI_NO_OF_CONNECT_ATTEMPTS 3
+
+// how often the process checks on a scan or connection in progress
+#define WIFI_PROGRESS_POLL_MILLIS 50
+// how often the process checks that the connection is still up
+#define WIFI_CHECK_INTERVAL_MILLIS 250
 #define WIFI_MESSAGE_BUFFER_SIZE 120
 
 #define WIFI_STATUS_OK_MESSAGE_NUMBER 1
@@ -10,7 +10,12 @@
 #include "connectwifi.h"
 #include "settingsWebServer.h"
 #include "HullOS.h"
+#include "HullOSBytecode.h"
+#include "HullOSCommands.h"
 #include "boot.h"
+#include "latency.h"
+#include "settingsstore.h"
+#include "commandparser.h"
 
 struct ConsoleSettings consoleSettings;
 
@@ -108,6 +113,123 @@ void doDumpStatus(char *commandLine)
 	Serial.println(ESP.getFreeHeap());
 }
 
+void printTimingMessage(char *json)
+{
+	Serial.println(json);
+}
+
+void doDumpTimings(char *commandLine)
+{
+	char *option = skipCommand(commandLine);
+
+	if (strcasecmp(option, "reset") == 0)
+	{
+		resetSensorTimings();
+		resetProcessTimings();
+		resetLoopTimings();
+		Serial.println("Timings reset");
+		return;
+	}
+
+	if (strcasecmp(option, "json") == 0)
+	{
+		buildTimingMessages(printTimingMessage);
+		return;
+	}
+
+	if (strcasecmp(option, "publish") == 0)
+	{
+		publishTimings();
+		Serial.println("Timings published");
+		return;
+	}
+
+	dumpSensorTimings();
+	dumpProcessTimings();
+	dumpLoopTimings();
+}
+
+#define SETTINGS_BENCH_REPEATS 10
+#define SETTINGS_BENCH_FILENAME "/SettingsBench.config"
+
+unsigned long settingsBenchIndexMicros;
+unsigned long settingsBenchLinearMicros;
+int settingsBenchLookups;
+int settingsBenchMismatches;
+
+void benchSettingCollection(SettingItemCollection *settingCollection)
+{
+	for (int settingNo = 0; settingNo < settingCollection->noOfSettings; settingNo++)
+	{
+		const char *name = settingCollection->settings[settingNo]->formName;
+
+		unsigned long startMicros = micros();
+		SettingItem *indexResult;
+		for (int i = 0; i < SETTINGS_BENCH_REPEATS; i++)
+		{
+			indexResult = findSettingByName(name);
+		}
+		settingsBenchIndexMicros += ulongDiff(micros(), startMicros);
+
+		startMicros = micros();
+		SettingItem *linearResult;
+		for (int i = 0; i < SETTINGS_BENCH_REPEATS; i++)
+		{
+			linearResult = findSettingByNameLinear(name);
+		}
+		settingsBenchLinearMicros += ulongDiff(micros(), startMicros);
+
+		if (indexResult != linearResult)
+		{
+			Serial.printf("   lookup mismatch for %s\n", name);
+			settingsBenchMismatches++;
+		}
+
+		settingsBenchLookups += SETTINGS_BENCH_REPEATS;
+	}
+}
+
+void doSettingsBench(char *commandLine)
+{
+	settingsBenchIndexMicros = 0;
+	settingsBenchLinearMicros = 0;
+	settingsBenchLookups = 0;
+	settingsBenchMismatches = 0;
+
+	iterateThroughSensorSettingCollections(benchSettingCollection);
+	iterateThroughProcessSettingCollections(benchSettingCollection);
+
+	Serial.printf("Setting lookups:%d index:%lu microsecs linear:%lu microsecs mismatches:%d\n",
+				  settingsBenchLookups, settingsBenchIndexMicros, settingsBenchLinearMicros, settingsBenchMismatches);
+
+	// Load the whole settings file, as older firmware did at startup, with each
+	// name found by the linear search and then through the index. The file holds
+	// the current values, so loading it leaves the settings unchanged.
+
+	saveAllSettingsToFile(SETTINGS_BENCH_FILENAME);
+
+	settingIndexEnabled = false;
+	unsigned long startMicros = micros();
+	bool loadedLinear = loadAllSettingsFromFile(SETTINGS_BENCH_FILENAME);
+	unsigned long linearLoadMicros = ulongDiff(micros(), startMicros);
+
+	settingIndexEnabled = true;
+	startMicros = micros();
+	bool loadedIndex = loadAllSettingsFromFile(SETTINGS_BENCH_FILENAME);
+	unsigned long indexLoadMicros = ulongDiff(micros(), startMicros);
+
+	LittleFS.remove(SETTINGS_BENCH_FILENAME);
+
+	if (!loadedLinear || !loadedIndex)
+	{
+		Serial.println("Settings file load failed");
+		return;
+	}
+
+	Serial.printf("Settings file load linear:%lu microsecs index:%lu microsecs\n",
+				  linearLoadMicros, indexLoadMicros);
+}
+
 void doRestart(char *commandLine)
 {
 	saveSettings();
@@ -118,6 +240,7 @@ void doClear(char *commandLine)
 {
 	LittleFS.format();
 	resetSettings();
+	markAllSettingsDirty();
 	saveSettings();
 	internalReboot(DEVICE_BOOT_MODE);
 }
@@ -125,7 +248,9 @@ void doClear(char *commandLine)
 void doSaveSettings(char *commandline)
 {
 	saveSettings();
-	Serial.println("\nSettings saved");
+	flushSettings();
+	settingsStoreStatusMessage(consoleMessageBuffer, CONSOLE_MESSAGE_SIZE);
+	Serial.printf("\nSettings saved\n%s\n", consoleMessageBuffer);
 }
 
 void doTestButtonSensor(char *commandline)
@@ -360,13 +485,64 @@ void doHullOSHelp(char *commandLine)
 
 void doHullOSRun(char *commandLine)
 {
-	Serial.println("Hullos run");
+	char *offsetText = skipCommand(commandLine);
+
+	int programOffset = STORED_PROGRAM_OFFSET;
+
+	if (*offsetText != 0)
+	{
+		programOffset = atoi(offsetText);
+	}
+
+	if ((programOffset < 0) || (programOffset >= HULLOS_PROGRAM_SIZE))
+	{
+		Serial.printf("Program offset must be between 0 and %d\n", HULLOS_PROGRAM_SIZE - 1);
+		return;
+	}
+
+	if (!isProgramStored())
+	{
+		Serial.println("No HullOS program stored");
+		return;
+	}
+
+	struct HullOSTask *task = startHullOSTask(programOffset);
+
+	if (task == NULL)
+	{
+		Serial.println("No free HullOS task to run the program");
+		return;
+	}
+
+	Serial.printf("HullOS task %d running the program at %d\n", (int)(task - hullosTasks), programOffset);
+
+	// make sure the new task gets its first slice straight away
+	scheduleProcessWakeup(&hullosProcess, 0);
+}
+
+void doHullOSTasks(char *commandLine)
+{
+	for (int i = 0; i < HULLOS_MAX_TASKS; i++)
+	{
+		struct HullOSTask *task = &hullosTasks[i];
+
+		if (!task->inUse)
+		{
+			Serial.printf("Task %d: free\n", i);
+			continue;
+		}
+
+		Serial.printf("Task %d: state %d program %d offset %d %s %lu statements/sec\n",
+					  i, task->programState, task->programBase, task->programCounter,
+					  task->bytecodeReady ? "bytecode" : "text", task->statementsPerSecond);
+	}
 }
 
 struct consoleCommand HullOSCommands[] =
 	{
 		{"help", "show all the commands", doHullOSHelp},
-		{"run", "run the HullOS program ", doHullOSRun}};
+		{"run", "run the HullOS program at an offset in a new task", doHullOSRun},
+		{"tasks", "show the HullOS tasks", doHullOSTasks}};
 
 void doHullOS(char *commandLine)
 {
@@ -545,9 +721,11 @@ struct consoleCommand userCommands[] =
 		{"sensors", "list all the sensor triggers", doShowSensorsText},
 		{"sensorsjson", "list all the sensor triggers in json", doShowSensorsJson},
 		{"settings", "show all the setting values", doShowSettings},
+		{"settingsbench", "time setting name lookups and settings file loads", doSettingsBench},
 		{"sprites", "dump sprite data", doDumpSprites},
 		{"status", "show the sensor status", doDumpStatus},
 		{"stores", "dump all the command stores", doDumpStores},
+		{"timing", "show loop timings (timing reset|json|publish)", doDumpTimings},
 		{"storage", "show the storage use of sensors and processes", doDumpStorage},
 };
 
@@ -743,7 +921,11 @@ void updateConsole()
 	if (consoleProcessDescriptor.status == CONSOLE_OK)
 	{
 		checkSerialBuffer();
+		scheduleProcessWakeup(&consoleProcessDescriptor, CONSOLE_POLL_MILLIS);
+		return;
 	}
+
+	setProcessEventDriven(&consoleProcessDescriptor);
 }
 
 void stopConsole()
@@ -19,6 +19,9 @@
 #define CONSOLE_OK 500
 #define CONSOLE_OFF 501
 
+// the serial port holds what arrives between reads
+#define CONSOLE_POLL_MILLIS 10
+
 extern struct process consoleProcessDescriptor;
 
 struct ConsoleSettings 
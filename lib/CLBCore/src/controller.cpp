@@ -10,7 +10,7 @@
 #include "settings.h"
 #include "otaupdate.h"
 #include "errors.h"
-#include "ArduinoJson-v5.13.2.h"
+#include "commandparser.h"
 #include "FS.h"
 #include <LITTLEFS.h>
 
@@ -350,22 +350,22 @@ void startSensorListener(struct sensorListenerConfiguration *commandItem)
 
 char command_reply_buffer[COMMAND_REPLY_BUFFER_SIZE];
 
-StaticJsonBuffer<1000> jsonBuffer;
+parsedCommand receivedCommand;
 
-void build_command_reply(int errorNo, JsonObject &root, char *resultBuffer)
+void build_command_reply(int errorNo, parsedCommand *root, char *resultBuffer)
 {
 	char replyBuffer[REPLY_ELEMENT_SIZE];
 	char errorDescription[REPLY_ERROR_SIZE];
 
 	decodeError(errorNo, errorDescription,REPLY_ERROR_SIZE);
 
-	const char *sequence = root["seq"];
+	const char *sequence = getCommandText(root, "seq");
 
 	if (sequence)
 	{
 		// Got a sequence number in the command - must return the same number
 		// so that the sender can identify the command that was sent
-		int sequenceNo = root["seq"];
+		int sequenceNo = atoi(sequence);
 		snprintf(replyBuffer,REPLY_ELEMENT_SIZE, "\"error\":%d,\"message\":\"%s\",\"seq\":%d", errorNo, errorDescription, sequenceNo);
 	}
 	else
@@ -375,17 +375,17 @@ void build_command_reply(int errorNo, JsonObject &root, char *resultBuffer)
 	strcat(resultBuffer, replyBuffer);
 }
 
-void build_text_value_command_reply(int errorNo, const char *result, JsonObject &root, char *resultBuffer)
+void build_text_value_command_reply(int errorNo, const char *result, parsedCommand *root, char *resultBuffer)
 {
 	char replyBuffer[REPLY_ELEMENT_SIZE];
 
-	const char *sequence = root["seq"];
+	const char *sequence = getCommandText(root, "seq");
 
 	if (sequence)
 	{
 		// Got a sequence number in the command - must return the same number
 		// so that the sender can identify the command that was sent
-		int sequenceNo = root["seq"];
+		int sequenceNo = atoi(sequence);
 		sprintf(replyBuffer, "\"val\":%s\",\"error\":%d,\"seq\":%d", result, errorNo, sequenceNo);
 	}
 	else
@@ -396,7 +396,7 @@ void build_text_value_command_reply(int errorNo, const char *result, JsonObject
 	strcat(resultBuffer, replyBuffer);
 }
 
-void abort_json_command(int error, JsonObject &root, void (*deliverResult)(char *resultText))
+void abort_json_command(int error, parsedCommand *root, void (*deliverResult)(char *resultText))
 {
 	build_command_reply(error, root, command_reply_buffer);
 	// append the version number to the invalid command message
@@ -404,9 +404,9 @@ void abort_json_command(int error, JsonObject &root, void (*deliverResult)(char
 	deliverResult(command_reply_buffer);
 }
 
-void do_Json_setting(JsonObject &root, void (*deliverResult)(char *resultText))
+void do_Json_setting(parsedCommand *root, void (*deliverResult)(char *resultText))
 {
-	const char *setting = root["setting"];
+	const char *setting = getCommandText(root, "setting");
 
 	TRACE("Received setting: ");
 	TRACELN(setting);
@@ -421,7 +421,9 @@ void do_Json_setting(JsonObject &root, void (*deliverResult)(char *resultText))
 	{
 		char buffer[120];
 
-		if (!root.containsKey("value"))
+		commandMember *value = findCommandMember(root, "value");
+
+		if (value == NULL)
 		{
 			// no value - just a status request
 			TRACELN("  No value part");
@@ -430,31 +432,18 @@ void do_Json_setting(JsonObject &root, void (*deliverResult)(char *resultText))
 		}
 		else
 		{
-			// got a value part
+			// got a value part - the setting validators parse the text as sent
 			const char *inputSource = NULL;
 
-			if (root["value"].is<int>())
+			if (value->type == integerCommandValue || value->type == stringCommandValue)
 			{
-				// need to convert the input value into a string
-				// as our value parser uses strings as inputs
-				int v = root["value"];
-				TRACE("  Setting int ");
-				TRACELN(v);
-				snprintf(buffer, 120, "%d", v);
-				inputSource = buffer;
+				inputSource = value->text;
+				TRACE("  Setting ");
+				TRACELN(inputSource);
 			}
 			else
 			{
-				if (root["value"].is<char *>())
-				{
-					inputSource = root["value"];
-					TRACE("  Setting string ");
-					TRACELN(inputSource);
-				}
-				else
-				{
-					TRACELN("  Unrecognised setting");
-				}
+				TRACELN("  Unrecognised setting");
 			}
 
 			if (inputSource == NULL)
@@ -764,11 +753,11 @@ bool buildStoreFilename(char *dest, int length, const char *store, const char *n
 // This function checks for a store property and puts the command in that store
 // If the store (folder) does not exist it will be created
 
-int checkAndAddToStore(JsonObject &root)
+int checkAndAddToStore(parsedCommand *root)
 {
 	TRACELN("Checking if a command should be added to a store:");
 
-	const char *commandStoreName = root["store"];
+	const char *commandStoreName = getCommandText(root, "store");
 
 	if (commandStoreName == NULL)
 	{
@@ -776,7 +765,7 @@ int checkAndAddToStore(JsonObject &root)
 		return WORKED_OK;
 	}
 
-	const char *commandID = root["id"];
+	const char *commandID = getCommandText(root, "id");
 
 	if (commandID == NULL)
 	{
@@ -831,12 +820,12 @@ int checkAndAddToStore(JsonObject &root)
 	File outputFile = LittleFS.open(fullFileName, "w");
 	
 	// Remove these tags from the saved command
-	root.remove("store");
-	root.remove("id");
+	removeCommandMember(root, "store");
+	removeCommandMember(root, "id");
 
 	char rawCommandText[500];
 
-	root.printTo(rawCommandText, 500);
+	printCommandJson(root, rawCommandText, 500);
 
 	TRACE("    storing the command:");
 	TRACELN(rawCommandText);
@@ -899,23 +888,277 @@ float commandParameterBufferf[OPTION_STORAGE_SIZE/sizeof(float)];
 
 unsigned char * commandParameterBuffer = (unsigned char *) commandParameterBufferf;
 
-int decodeCommand(const char *rawCommandText, process *process, Command *command,
-				  unsigned char *parameterBuffer, JsonObject &root)
+// Command dispatch index
+// Every command of every process is held in a table sorted by the hash of
+// the process and command names, so a received command is found with a
+// binary search rather than walking the process list and the command list.
+// Each entry refers to a run of dispatch items, one per CommandItem, holding
+// the hash of the item name as it appears in the JSON and the item itself.
+
+struct commandDispatchItem
+{
+	uint32_t nameHash;
+	CommandItem *item;
+	bool optionalWithSensor; // "value" and "text" can come from a sensor
+};
+
+struct commandDispatchEntry
+{
+	uint32_t keyHash;
+	struct process *commandProcess;
+	Command *command;
+	int firstItem;
+};
+
+struct commandDispatchEntry *commandDispatchIndex = NULL;
+int commandDispatchCount;
+struct commandDispatchItem *commandDispatchItems = NULL;
+int commandDispatchItemCount;
+
+// when false commands are decoded and validated but not performed
+// used by the command benchmark in test/host
+bool performDecodedCommands = true;
+
+#define COMMAND_DISPATCH_HASH_START 2166136261UL
+#define COMMAND_DISPATCH_HASH_PRIME 16777619UL
+
+uint32_t addToCommandHash(uint32_t hash, const char *text, bool ignoreCase)
+{
+	while (*text)
+	{
+		char ch = *text;
+		if (ignoreCase)
+		{
+			ch = tolower(ch);
+		}
+		hash = (hash ^ (unsigned char)ch) * COMMAND_DISPATCH_HASH_PRIME;
+		text++;
+	}
+	return hash;
+}
+
+// process and command names are not case sensitive
+
+uint32_t hashCommandKey(const char *processName, const char *commandName)
+{
+	uint32_t hash = addToCommandHash(COMMAND_DISPATCH_HASH_START, processName, true);
+	// separator so that "ab"+"c" and "a"+"bc" hash differently
+	hash = (hash ^ '.') * COMMAND_DISPATCH_HASH_PRIME;
+	return addToCommandHash(hash, commandName, true);
+}
+
+// item names are matched exactly, as they are by the JSON parser
+
+uint32_t hashCommandItemName(const char *itemName)
+{
+	return addToCommandHash(COMMAND_DISPATCH_HASH_START, itemName, false);
+}
+
+void countProcessCommands(process *p)
+{
+	if (p->commands == NULL)
+	{
+		return;
+	}
+
+	for (int i = 0; i < p->commands->noOfCommands; i++)
+	{
+		Command *command = p->commands->commands[i];
+
+		if (command->noOfItems > COMMAND_MAX_ITEMS)
+		{
+			Serial.printf("Command %s %s has too many items\n", p->processName, command->name);
+			continue;
+		}
+
+		commandDispatchCount++;
+		commandDispatchItemCount = commandDispatchItemCount + command->noOfItems;
+	}
+}
+
+int commandDispatchEntriesAdded;
+int commandDispatchItemsAdded;
+
+void addProcessCommandsToDispatchIndex(process *p)
+{
+	if (p->commands == NULL)
+	{
+		return;
+	}
+
+	for (int i = 0; i < p->commands->noOfCommands; i++)
+	{
+		Command *command = p->commands->commands[i];
+
+		if (command->noOfItems > COMMAND_MAX_ITEMS)
+		{
+			continue;
+		}
+
+		int firstItem = commandDispatchItemsAdded;
+
+		for (int itemNo = 0; itemNo < command->noOfItems; itemNo++)
+		{
+			CommandItem *item = command->items[itemNo];
+			commandDispatchItem *dispatchItem = &commandDispatchItems[commandDispatchItemsAdded];
+			dispatchItem->nameHash = hashCommandItemName(item->name);
+			dispatchItem->item = item;
+			dispatchItem->optionalWithSensor = strcasecmp(item->name, "value") == 0 || strcasecmp(item->name, "text") == 0;
+			commandDispatchItemsAdded++;
+		}
+
+		uint32_t keyHash = hashCommandKey(p->processName, command->name);
+
+		// insertion sort keeps entries with the same hash in process list order
+		int pos = commandDispatchEntriesAdded;
+		while (pos > 0 && commandDispatchIndex[pos - 1].keyHash > keyHash)
+		{
+			commandDispatchIndex[pos] = commandDispatchIndex[pos - 1];
+			pos--;
+		}
+		commandDispatchIndex[pos].keyHash = keyHash;
+		commandDispatchIndex[pos].commandProcess = p;
+		commandDispatchIndex[pos].command = command;
+		commandDispatchIndex[pos].firstItem = firstItem;
+		commandDispatchEntriesAdded++;
+	}
+}
+
+void buildCommandDispatchIndex()
+{
+	if (commandDispatchIndex != NULL)
+	{
+		delete[] commandDispatchIndex;
+		delete[] commandDispatchItems;
+	}
+
+	commandDispatchCount = 0;
+	commandDispatchItemCount = 0;
+	iterateThroughAllProcesses(countProcessCommands);
+
+	commandDispatchIndex = new commandDispatchEntry[commandDispatchCount];
+	commandDispatchItems = new commandDispatchItem[commandDispatchItemCount];
+
+	commandDispatchEntriesAdded = 0;
+	commandDispatchItemsAdded = 0;
+	iterateThroughAllProcesses(addProcessCommandsToDispatchIndex);
+}
+
+commandDispatchEntry *findCommandDispatchEntry(const char *processName, const char *commandName)
+{
+	if (commandDispatchIndex == NULL)
+	{
+		buildCommandDispatchIndex();
+	}
+
+	uint32_t keyHash = hashCommandKey(processName, commandName);
+
+	// find the first entry with this hash
+	int low = 0;
+	int high = commandDispatchCount;
+
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		if (commandDispatchIndex[mid].keyHash < keyHash)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	// check the names in case two commands share a hash
+	while (low < commandDispatchCount && commandDispatchIndex[low].keyHash == keyHash)
+	{
+		commandDispatchEntry *entry = &commandDispatchIndex[low];
+		if (strcasecmp(entry->commandProcess->processName, processName) == 0 &&
+			strcasecmp(entry->command->name, commandName) == 0)
+		{
+			return entry;
+		}
+		low++;
+	}
+
+	return NULL;
+}
+
+// Decodes the command in a single pass over the members of the parsed command.
+// Each member is matched against the items of the command and the values
+// picked out, after which the items are validated in order. Numbers and
+// strings are passed to the validators as the text that was received, apart
+// from numbers with an exponent, which are written out in full.
+
+int decodeCommand(const char *rawCommandText, commandDispatchEntry *entry,
+				  unsigned char *parameterBuffer, parsedCommand *root)
 {
 	TRACELN("Decoding a command");
-	char buffer[120];
 
 	char destination[DESTINATION_NAME_LENGTH];
 
 	int failcount = 0;
 
-	const char *sensorName = root["sensor"];
+	struct process *process = entry->commandProcess;
+	Command *command = entry->command;
+	commandDispatchItem *dispatchItems = &commandDispatchItems[entry->firstItem];
+
+	commandMember *itemValues[COMMAND_MAX_ITEMS];
 
 	for (int i = 0; i < command->noOfItems; i++)
 	{
-		CommandItem *item = command->items[i];
+		itemValues[i] = NULL;
+	}
+
+	const char *sensorName = NULL;
+	const char *trigger = NULL;
+	const char *destSource = NULL;
+
+	for (int memberNo = 0; memberNo < root->noOfMembers; memberNo++)
+	{
+		commandMember *member = &root->members[memberNo];
+		const char *key = member->key;
+
+		if (strcmp(key, "sensor") == 0)
+		{
+			sensorName = getCommandMemberText(member);
+			continue;
+		}
+
+		if (strcmp(key, "trigger") == 0)
+		{
+			trigger = getCommandMemberText(member);
+			continue;
+		}
+
+		if (strcmp(key, "to") == 0)
+		{
+			destSource = getCommandMemberText(member);
+			continue;
+		}
+
+		uint32_t keyHash = hashCommandItemName(key);
+
+		for (int i = 0; i < command->noOfItems; i++)
+		{
+			// the first of a repeated name is used, as with a lookup by name
+			if (itemValues[i] == NULL &&
+				dispatchItems[i].nameHash == keyHash &&
+				strcmp(dispatchItems[i].item->name, key) == 0)
+			{
+				itemValues[i] = member;
+				break;
+			}
+		}
+	}
+
+	for (int i = 0; i < command->noOfItems; i++)
+	{
+		CommandItem *item = dispatchItems[i].item;
 
-		const char *option = root[item->name];
+		char numberText[COMMAND_NUMBER_TEXT_LENGTH];
+		const char *option = getCommandMemberValueText(itemValues[i], numberText, COMMAND_NUMBER_TEXT_LENGTH);
 
 		TRACE("Handling option:");
 		TRACELN(item->name);
@@ -933,11 +1176,10 @@ int decodeCommand(const char *rawCommandText, process *process, Command *command
 			else
 			{
 				TRACE("    Not got a default option - ");
-				if (strcasecmp(item->name, "value")==0 || strcasecmp(item->name, "text")==0 ){
-					if(sensorName != NULL){
-						TRACELN("no need for default as it is a sensor command");
-						continue;
-					}
+				if (dispatchItems[i].optionalWithSensor && sensorName != NULL)
+				{
+					TRACELN("no need for default as it is a sensor command");
+					continue;
 				}
 				TRACELN("command failed");
 				TRACELN(item->name);
@@ -945,64 +1187,22 @@ int decodeCommand(const char *rawCommandText, process *process, Command *command
 			}
 		}
 
-		const char *inputSource = NULL;
-
-		if (root[item->name].is<int>())
+		if (itemValues[i]->type == booleanCommandValue)
 		{
-			TRACE("Got an int:");
-			// need to convert the input value into a string
-			// as our value parser uses strings as inputs
-			int iv = root[item->name];
-			TRACE(iv);
-			TRACE(" for ");
+			TRACE("Command item invalid:");
 			TRACELN(item->name);
-			snprintf(buffer, 120, "%d", iv);
-			inputSource = buffer;
-		}
-		else
-		{
-			if (root[item->name].is<float>())
-			{
-				TRACELN("Got a float:");
-				// need to convert the input value into a string
-				// as our value parser uses strings as inputs
-				float fv = root[item->name];
-				TRACE(fv);
-				TRACE(" for ");
-				TRACELN(item->name);
-				snprintf(buffer, 120, "%f", fv);
-				inputSource = buffer;
-			}
-			else
-			{
-				if (root[item->name].is<char *>())
-				{
-					inputSource = root[item->name];
-					TRACE("Got a string:");
-					TRACE(inputSource);
-					TRACE(" for ");
-					TRACELN(item->name);
-				}
-				else
-				{
-					TRACE("Command item invalid:");
-					TRACELN(item->name);
-					return JSON_MESSAGE_COMMAND_ITEM_INVALID;
-				}
-			}
+			return JSON_MESSAGE_COMMAND_ITEM_INVALID;
 		}
 
-		if (inputSource == NULL)
+		TRACE("Got:");
+		TRACE(option);
+		TRACE(" for ");
+		TRACELN(item->name);
+
+		if (!item->validateValue(parameterBuffer + item->commandSettingOffset, option))
 		{
 			failcount++;
 		}
-		else
-		{
-			if (!item->validateValue(parameterBuffer + item->commandSettingOffset, inputSource))
-			{
-				failcount++;
-			}
-		}
 	}
 
 	if (failcount != 0)
@@ -1012,8 +1212,6 @@ int decodeCommand(const char *rawCommandText, process *process, Command *command
 
 	// need to get the destination of this command
 
-	const char *destSource = root["to"];
-
 	if (destSource == NULL)
 	{
 		// empty destination string
@@ -1031,13 +1229,16 @@ int decodeCommand(const char *rawCommandText, process *process, Command *command
 
 	int result = WORKED_OK;
 
+	if (!performDecodedCommands)
+	{
+		return WORKED_OK;
+	}
+
 	if (sensorName != NULL)
 	{
 		TRACELN("   adding a listener");
 		// Creating and adding a sensor with a trigger
 		// The command will not be performed now
-		const char *trigger = root["trigger"];
-
 		if (trigger == NULL)
 		{
 			return JSON_MESSAGE_SENSOR_MISSING_TRIGGER;
@@ -1078,13 +1279,13 @@ int decodeCommand(const char *rawCommandText, process *process, Command *command
 	return result;
 }
 
-void do_Json_command(const char *rawCommandText, JsonObject &root, void (*deliverResult)(char *resultText))
+void do_Json_command(const char *rawCommandText, parsedCommand *root, void (*deliverResult)(char *resultText))
 {
 	TRACELN();
 	TRACELN("Doing JSON command");
-	const char *processName = root["process"];
-	Command *command = NULL;
-	struct process *process = NULL;
+	const char *processName = getCommandText(root, "process");
+	const char *commandName = getCommandText(root, "command");
+	commandDispatchEntry *entry = NULL;
 
 	int error = WORKED_OK;
 
@@ -1096,40 +1297,29 @@ void do_Json_command(const char *rawCommandText, JsonObject &root, void (*delive
 	{
 		TRACE("  for process: ");
 		TRACE(processName);
+		TRACE(" command: ");
+		TRACELN(commandName);
 
-		process = findProcessByName(processName);
+		entry = findCommandDispatchEntry(processName, commandName);
 
-		if (process == NULL)
+		if (entry == NULL)
 		{
-			TRACELN("   Process name invalid");
-			error = JSON_MESSAGE_PROCESS_NAME_INVALID;
-		}
-		else
-		{
-			const char *commandName = root["command"];
-
-			if (commandName == NULL)
+			// only need to find out which name is wrong when the lookup fails
+			if (findProcessByName(processName) == NULL)
 			{
-				TRACELN("   Process command missing command");
-				error = JSON_MESSAGE_COMMAND_MISSING_COMMAND;
+				TRACELN("   Process name invalid");
+				error = JSON_MESSAGE_PROCESS_NAME_INVALID;
 			}
 			else
 			{
-				TRACE(" command: ");
-				TRACELN(commandName);
-				TRACE("  ");
-				command = FindCommandInProcess(process, commandName);
-				if (command == NULL)
-				{
-					error = JSON_MESSAGE_COMMAND_COMMAND_NOT_FOUND;
-				}
+				error = JSON_MESSAGE_COMMAND_COMMAND_NOT_FOUND;
 			}
 		}
 	}
 
 	if (error == WORKED_OK)
 	{
-		error = decodeCommand(rawCommandText, process, command, commandParameterBuffer, root);
+		error = decodeCommand(rawCommandText, entry, commandParameterBuffer, root);
 	}
 
 	build_command_reply(error, root, command_reply_buffer);
@@ -1151,20 +1341,18 @@ void act_onJson_message(const char *json, void (*deliverResult)(char *resultText
 
 	strcat(command_reply_buffer, "{");
 
-	// Clear any previous elements from the buffer
-
-	jsonBuffer.clear();
+	parsedCommand *root = &receivedCommand;
 
-	JsonObject &root = jsonBuffer.parseObject(json);
-
-	if (!root.success())
+	if (!parseCommand(root, json))
 	{
 		TRACELN("JSON could not be parsed");
+		// don't reply with anything from a partly parsed command
+		root->noOfMembers = 0;
 		abort_json_command(JSON_MESSAGE_COULD_NOT_BE_PARSED, root, deliverResult);
 		return;
 	}
 
-	const char *setting = root["setting"];
+	const char *setting = getCommandText(root, "setting");
 
 	if (setting)
 	{
@@ -1172,7 +1360,7 @@ void act_onJson_message(const char *json, void (*deliverResult)(char *resultText
 		return;
 	}
 
-	const char *command = root["command"];
+	const char *command = getCommandText(root, "command");
 
 	if (command)
 	{
@@ -1312,12 +1500,16 @@ void startcontroller()
 {
 	controllerProcess.status = CONTROLLER_OK;
 
+	buildCommandDispatchIndex();
+
 	// Look for sensors and bind a message controller to each
 	// need to iterate through all the controllers and add to each sensor.
 	iterateThroughListenerConfigurations(startSensorListener);
 
 	performCommandsInStore(BOOT_FOLDER_NAME);
 
+	// commands arrive through the other processes, there is nothing to update
+	setProcessEventDriven(&controllerProcess);
 }
 
 void updatecontroller()
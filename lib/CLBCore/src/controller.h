@@ -29,6 +29,9 @@ enum CommandItem_Type { textCommand, integerCommand, floatCommand};
 
 #define COMMAND_PARAMETER_BUFFER_LENGTH 150
 
+// largest number of items a command can have
+#define COMMAND_MAX_ITEMS 16
+
 struct CommandItem 
 {
     char * name;
@@ -57,6 +60,9 @@ struct CommandItemCollection
 
 void act_onJson_message(const char *json, void (*deliverResult)(char *resultText));
 
+void buildCommandDispatchIndex();
+extern bool performDecodedCommands;
+
 bool setDefaultEmptyString(void * dest);
 bool noDefaultAvailable(void * dest);
 bool setDefaultIntZero(void * dest);
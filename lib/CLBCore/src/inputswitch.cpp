@@ -109,6 +109,10 @@ unsigned long millisAtLastInputChange;
 
 #define INPUT_DEBOUNCE_TIME 10
 
+// read the switch twice in each debounce time
+
+#define INPUT_SWITCH_POLL_MILLIS (INPUT_DEBOUNCE_TIME / 2)
+
 void initInputSwitch()
 {
 	inputSwitchProcess.status = INPUT_SWITCH_STOPPED;
@@ -144,9 +148,12 @@ void updateInputSwitch()
 {
 	if(inputSwitchProcess.status == INPUT_SWITCH_STOPPED)
 	{
+		setProcessEventDriven(&inputSwitchProcess);
 		return;
 	}
 
+	scheduleProcessWakeup(&inputSwitchProcess, INPUT_SWITCH_POLL_MILLIS);
+
 	int newInputValue = digitalRead(inputSwitchSettings.inputPin);
 
 	if (newInputValue == lastInputValue)
@@ -0,0 +1,275 @@
+#include <Arduino.h>
+
+#include "utils.h"
+#include "settings.h"
+#include "processes.h"
+#include "sensors.h"
+#include "mqtt.h"
+#include "latency.h"
+
+void resetLatency(struct latencyHistogram *h)
+{
+	h->samples = 0;
+	h->minMicros = 0;
+	h->maxMicros = 0;
+	h->totalMicros = 0;
+
+	for (int i = 0; i < LATENCY_BUCKETS; i++)
+	{
+		h->buckets[i] = 0;
+	}
+}
+
+int getLatencyBucket(unsigned long sampleMicros)
+{
+	int bucket = 0;
+
+	while (sampleMicros != 0)
+	{
+		bucket++;
+		sampleMicros = sampleMicros >> 1;
+	}
+
+	if (bucket >= LATENCY_BUCKETS)
+	{
+		bucket = LATENCY_BUCKETS - 1;
+	}
+
+	return bucket;
+}
+
+void addLatencySample(struct latencyHistogram *h, unsigned long sampleMicros)
+{
+	if (h->samples == 0 || sampleMicros < h->minMicros)
+	{
+		h->minMicros = sampleMicros;
+	}
+
+	if (sampleMicros > h->maxMicros)
+	{
+		h->maxMicros = sampleMicros;
+	}
+
+	h->samples++;
+	h->totalMicros = h->totalMicros + sampleMicros;
+	h->buckets[getLatencyBucket(sampleMicros)]++;
+}
+
+// returns the top of the bucket holding the given percentile,
+// clamped to the smallest and largest samples seen
+
+unsigned long getLatencyPercentile(struct latencyHistogram *h, int percent)
+{
+	if (h->samples == 0)
+	{
+		return 0;
+	}
+
+	unsigned long long target = ((unsigned long long)h->samples * percent + 99) / 100;
+	unsigned long long count = 0;
+	int bucket;
+
+	for (bucket = 0; bucket < LATENCY_BUCKETS - 1; bucket++)
+	{
+		count = count + h->buckets[bucket];
+		if (count >= target)
+		{
+			break;
+		}
+	}
+
+	unsigned long result;
+
+	if (bucket == 0)
+	{
+		result = 0;
+	}
+	else
+	{
+		result = (1UL << bucket) - 1;
+	}
+
+	if (result > h->maxMicros)
+	{
+		result = h->maxMicros;
+	}
+
+	if (result < h->minMicros)
+	{
+		result = h->minMicros;
+	}
+
+	return result;
+}
+
+unsigned long getLatencyAverage(struct latencyHistogram *h)
+{
+	if (h->samples == 0)
+	{
+		return 0;
+	}
+
+	return (unsigned long)(h->totalMicros / h->samples);
+}
+
+void printLatency(const char *name, struct latencyHistogram *h)
+{
+	Serial.printf("    %-16s updates:%10lu average:%8lu min:%8lu p50:%8lu p99:%8lu max:%8lu\n",
+				  name, h->samples, getLatencyAverage(h), h->minMicros,
+				  getLatencyPercentile(h, 50), getLatencyPercentile(h, 99), h->maxMicros);
+}
+
+void appendLatencyJson(const char *name, struct latencyHistogram *h, char *buffer, int bufferSize)
+{
+	snprintf(buffer, bufferSize, "%s{\"name\":\"%s\",\"n\":%lu,\"avg\":%lu,\"min\":%lu,\"p50\":%lu,\"p99\":%lu,\"max\":%lu}",
+			 buffer, name, h->samples, getLatencyAverage(h), h->minMicros,
+			 getLatencyPercentile(h, 50), getLatencyPercentile(h, 99), h->maxMicros);
+}
+
+// Whole loop timing, fed from the main loop once per pass
+// work is the time spent in updates, period is the time from the start of one pass to the next
+
+struct latencyHistogram loopWorkLatency;
+struct latencyHistogram loopPeriodLatency;
+unsigned long lastLoopStartMicros;
+bool lastLoopStartValid = false;
+unsigned long loopTimingStartMillis = 0;
+
+void recordLoopCycle(unsigned long loopStartMicros, unsigned long loopMicros)
+{
+	addLatencySample(&loopWorkLatency, loopMicros);
+
+	if (lastLoopStartValid)
+	{
+		addLatencySample(&loopPeriodLatency, ulongDiff(loopStartMicros, lastLoopStartMicros));
+	}
+
+	lastLoopStartMicros = loopStartMicros;
+	lastLoopStartValid = true;
+}
+
+void dumpLoopTimings()
+{
+	if (loopWorkLatency.samples == 0)
+	{
+		Serial.println("Loop: no cycles recorded");
+		return;
+	}
+
+	unsigned long elapsedMillis = ulongDiff(millis(), loopTimingStartMillis);
+	unsigned long cyclesPerSec = 0;
+
+	if (elapsedMillis > 0)
+	{
+		cyclesPerSec = (unsigned long)(((unsigned long long)loopWorkLatency.samples * 1000) / elapsedMillis);
+	}
+
+	Serial.printf("Loop cycles:%lu over %lu millisecs (%lu per sec)\n",
+				  loopWorkLatency.samples, elapsedMillis, cyclesPerSec);
+	printLatency("work", &loopWorkLatency);
+	printLatency("period", &loopPeriodLatency);
+	Serial.printf("    period jitter p99-p50:%lu max-min:%lu\n",
+				  getLatencyPercentile(&loopPeriodLatency, 99) - getLatencyPercentile(&loopPeriodLatency, 50),
+				  loopPeriodLatency.maxMicros - loopPeriodLatency.minMicros);
+}
+
+void resetLoopTimings()
+{
+	resetLatency(&loopWorkLatency);
+	resetLatency(&loopPeriodLatency);
+	lastLoopStartValid = false;
+	loopTimingStartMillis = millis();
+}
+
+// The timings are sent as a series of JSON messages, each small enough for an MQTT packet
+// {"dev":"CLB-xxxx","loop":[{"name":"work",...},{"name":"period",...}],"cycles":1234,"millis":5678}
+// {"dev":"CLB-xxxx","processes":[{"name":"pixel","n":..,"avg":..,"min":..,"p50":..,"p99":..,"max":..},...]}
+// {"dev":"CLB-xxxx","sensors":[...]}
+
+#define LATENCY_JSON_ITEM_SIZE 120
+
+char latencyJsonBuffer[LATENCY_JSON_BUFFER_SIZE];
+char latencyDeviceName[DEVICE_NAME_LENGTH];
+const char *latencySectionName;
+bool latencyFirstItem;
+void (*latencyDeliverMessage)(char *json);
+
+void startLatencyMessage()
+{
+	snprintf(latencyJsonBuffer, LATENCY_JSON_BUFFER_SIZE, "{\"dev\":\"%s\",\"%s\":[",
+			 latencyDeviceName, latencySectionName);
+	latencyFirstItem = true;
+}
+
+void endLatencyMessage()
+{
+	snprintf(latencyJsonBuffer, LATENCY_JSON_BUFFER_SIZE, "%s]}", latencyJsonBuffer);
+	latencyDeliverMessage(latencyJsonBuffer);
+}
+
+void addLatencyItem(const char *name, struct latencyHistogram *h)
+{
+	if (h->samples == 0)
+	{
+		return;
+	}
+
+	if ((int)strlen(latencyJsonBuffer) + LATENCY_JSON_ITEM_SIZE >= LATENCY_JSON_BUFFER_SIZE)
+	{
+		// no room for another item - send this message and start a new one
+		endLatencyMessage();
+		startLatencyMessage();
+	}
+
+	if (!latencyFirstItem)
+	{
+		snprintf(latencyJsonBuffer, LATENCY_JSON_BUFFER_SIZE, "%s,", latencyJsonBuffer);
+	}
+
+	appendLatencyJson(name, h, latencyJsonBuffer, LATENCY_JSON_BUFFER_SIZE);
+	latencyFirstItem = false;
+}
+
+void addProcessLatencyItem(process *p)
+{
+	addLatencyItem(p->processName, &p->latency);
+}
+
+void addSensorLatencyItem(sensor *s)
+{
+	addLatencyItem(s->sensorName, &s->latency);
+}
+
+void buildTimingMessages(void (*deliverMessage)(char *json))
+{
+	latencyDeliverMessage = deliverMessage;
+	PrintSystemDetails(latencyDeviceName, DEVICE_NAME_LENGTH);
+
+	snprintf(latencyJsonBuffer, LATENCY_JSON_BUFFER_SIZE, "{\"dev\":\"%s\",\"loop\":[", latencyDeviceName);
+	appendLatencyJson("work", &loopWorkLatency, latencyJsonBuffer, LATENCY_JSON_BUFFER_SIZE);
+	snprintf(latencyJsonBuffer, LATENCY_JSON_BUFFER_SIZE, "%s,", latencyJsonBuffer);
+	appendLatencyJson("period", &loopPeriodLatency, latencyJsonBuffer, LATENCY_JSON_BUFFER_SIZE);
+	snprintf(latencyJsonBuffer, LATENCY_JSON_BUFFER_SIZE, "%s],\"cycles\":%lu,\"millis\":%lu}",
+			 latencyJsonBuffer, loopWorkLatency.samples, ulongDiff(millis(), loopTimingStartMillis));
+	deliverMessage(latencyJsonBuffer);
+
+	latencySectionName = "processes";
+	startLatencyMessage();
+	iterateThroughActiveProcesses(addProcessLatencyItem);
+	endLatencyMessage();
+
+	latencySectionName = "sensors";
+	startLatencyMessage();
+	iterateThroughSensors(addSensorLatencyItem);
+	endLatencyMessage();
+}
+
+void publishTimingMessage(char *json)
+{
+	publishBufferToMQTTTopic(json, LATENCY_MQTT_TOPIC);
+}
+
+void publishTimings()
+{
+	buildTimingMessages(publishTimingMessage);
+}
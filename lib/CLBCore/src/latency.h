@@ -0,0 +1,33 @@
+#pragma once
+
+// Log bucketed latency histograms for process and sensor updates and the main loop
+// Bucket 0 holds times of 0 microseconds, bucket n holds times from 2^(n-1) to 2^n - 1
+// The last bucket also collects anything longer
+
+#define LATENCY_BUCKETS 22
+
+#define LATENCY_JSON_BUFFER_SIZE 600
+#define LATENCY_MQTT_TOPIC "timing"
+
+struct latencyHistogram
+{
+	unsigned long samples;
+	unsigned long minMicros;
+	unsigned long maxMicros;
+	unsigned long long totalMicros;
+	unsigned long buckets[LATENCY_BUCKETS];
+};
+
+void resetLatency(struct latencyHistogram *h);
+void addLatencySample(struct latencyHistogram *h, unsigned long sampleMicros);
+unsigned long getLatencyPercentile(struct latencyHistogram *h, int percent);
+unsigned long getLatencyAverage(struct latencyHistogram *h);
+void printLatency(const char *name, struct latencyHistogram *h);
+void appendLatencyJson(const char *name, struct latencyHistogram *h, char *buffer, int bufferSize);
+
+void recordLoopCycle(unsigned long loopStartMicros, unsigned long loopMicros);
+void dumpLoopTimings();
+void resetLoopTimings();
+
+void buildTimingMessages(void (*deliverMessage)(char *json));
+void publishTimings();
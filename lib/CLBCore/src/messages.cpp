@@ -100,6 +100,9 @@ void initMessages()
 
 void startMessages()
 {
+    // messages are delivered by the handler, there is nothing to do in update
+    setProcessEventDriven(&messagesProcess);
+
     if(messagesSettings.messagesEnabled){
         messagesProcess.status = MESSAGES_OK;
     }
@@ -160,9 +160,6 @@ unsigned long mqtt_timer_start;
 
 PubSubClient *mqttPubSubClient = NULL;
 
-#define MQTT_RECEIVE_BUFFER_SIZE 240
-char mqtt_receive_buffer[MQTT_RECEIVE_BUFFER_SIZE];
-
 #define MQTT_SEND_BUFFER_SIZE 240
 
 char mqtt_send_buffer[MQTT_SEND_BUFFER_SIZE];
@@ -172,47 +169,195 @@ boolean first_mqtt_message = true;
 int messagesSent;
 int messagesReceived;
 
+unsigned long mqttReceiveOverflows = 0;
+unsigned long mqttReceiveTooLong = 0;
+unsigned int mqttReceivePeakBytes = 0;
+
 void mqtt_deliver_command_result(char *result)
 {
 	publishBufferToMQTT(result);
 }
 
+// Incoming message ring
+// The callback is the only writer of mqttReceiveHead and updateMQTT the only
+// writer of mqttReceiveTail, so no locking is needed. The ring is empty when
+// they are equal, which means a record may never fill the last free byte.
+// A record is never split across the end of the ring - if it won't fit
+// a wrap marker is written (when there is room for one) and it starts at 0.
+
+char mqttReceiveRing[MQTT_RECEIVE_RING_SIZE];
+volatile unsigned int mqttReceiveHead = 0;
+volatile unsigned int mqttReceiveTail = 0;
+
+unsigned int getMQTTReceiveBytesUsed()
+{
+	unsigned int head = mqttReceiveHead;
+	unsigned int tail = mqttReceiveTail;
+
+	if (head >= tail)
+	{
+		return head - tail;
+	}
+
+	return MQTT_RECEIVE_RING_SIZE - tail + head;
+}
+
+bool addIncomingMQTTMessage(byte *payload, unsigned int length)
+{
+	if (length >= MQTT_RECEIVE_BUFFER_SIZE)
+	{
+		mqttReceiveTooLong++;
+		return false;
+	}
+
+	unsigned int recordSize = MQTT_RECEIVE_RECORD_HEADER_SIZE + length + 1;
+	unsigned int head = mqttReceiveHead;
+	unsigned int tail = mqttReceiveTail;
+	unsigned int start;
+
+	if (head >= tail)
+	{
+		if (MQTT_RECEIVE_RING_SIZE - head > recordSize)
+		{
+			start = head;
+		}
+		else if (tail > recordSize)
+		{
+			// room at the start of the ring
+			if (MQTT_RECEIVE_RING_SIZE - head >= MQTT_RECEIVE_RECORD_HEADER_SIZE)
+			{
+				mqttReceiveRing[head] = MQTT_RECEIVE_WRAP_MARKER & 0xFF;
+				mqttReceiveRing[head + 1] = MQTT_RECEIVE_WRAP_MARKER >> 8;
+			}
+			start = 0;
+		}
+		else
+		{
+			mqttReceiveOverflows++;
+			return false;
+		}
+	}
+	else
+	{
+		if (tail - head > recordSize)
+		{
+			start = head;
+		}
+		else
+		{
+			mqttReceiveOverflows++;
+			return false;
+		}
+	}
+
+	mqttReceiveRing[start] = length & 0xFF;
+	mqttReceiveRing[start + 1] = length >> 8;
+
+	char *dest = mqttReceiveRing + start + MQTT_RECEIVE_RECORD_HEADER_SIZE;
+
+	for (unsigned int i = 0; i < length; i++)
+	{
+		dest[i] = (char)payload[i];
+	}
+
+	// Put the terminator on the string
+	dest[length] = 0;
+
+	// the record must be complete before the reader can see it
+	__sync_synchronize();
+	mqttReceiveHead = start + recordSize;
+
+	unsigned int used = getMQTTReceiveBytesUsed();
+
+	if (used > mqttReceivePeakBytes)
+	{
+		mqttReceivePeakBytes = used;
+	}
+
+	return true;
+}
+
 // do not process incoming messages on this thread because it is a callback from the MQTT driver
 // that might fire from a network interrupt
 
 void callback(char *topic, byte *payload, unsigned int length)
 {
-	unsigned int i;
+	if (addIncomingMQTTMessage(payload, length))
+	{
+		messagesReceived++;
+	}
+}
 
-	for (i = 0; i < length; i++)
+// Returns the next message in the ring, or NULL if it is empty.
+// The message stays in the ring until it is released.
+
+char *peekIncomingMQTTMessage(unsigned int *recordSize)
+{
+	unsigned int tail = mqttReceiveTail;
+
+	if (tail == mqttReceiveHead)
 	{
-		mqtt_receive_buffer[i] = (char)payload[i];
+		return NULL;
 	}
 
-	// Put the terminator on the string
-	mqtt_receive_buffer[i] = 0;
+	unsigned int length = MQTT_RECEIVE_WRAP_MARKER;
+
+	if (MQTT_RECEIVE_RING_SIZE - tail >= MQTT_RECEIVE_RECORD_HEADER_SIZE)
+	{
+		length = (unsigned char)mqttReceiveRing[tail] + ((unsigned char)mqttReceiveRing[tail + 1] << 8);
+	}
 
-	messagesReceived++;
+	if (length == MQTT_RECEIVE_WRAP_MARKER)
+	{
+		// the writer has moved on to the start of the ring
+		tail = 0;
+		mqttReceiveTail = 0;
+		length = (unsigned char)mqttReceiveRing[0] + ((unsigned char)mqttReceiveRing[1] << 8);
+	}
+
+	*recordSize = MQTT_RECEIVE_RECORD_HEADER_SIZE + length + 1;
+
+	return mqttReceiveRing + tail + MQTT_RECEIVE_RECORD_HEADER_SIZE;
 }
 
-void clearIncomingMQTTMessage()
+void releaseIncomingMQTTMessage(unsigned int recordSize)
 {
-	mqtt_receive_buffer[0] = 0;
+	mqttReceiveTail = mqttReceiveTail + recordSize;
 }
 
-bool receivedIncomingMQTTMessage()
+void clearIncomingMQTTMessages()
 {
-	return mqtt_receive_buffer[0] != 0;
+	mqttReceiveTail = mqttReceiveHead;
 }
 
-void handleIncomingMQTTMessage()
+// Handles up to budget messages from the ring and returns the number handled
+
+int handleIncomingMQTTMessages(int budget, void (*handleMessage)(char *message))
 {
-	if (receivedIncomingMQTTMessage())
+	int handled = 0;
+
+	while (handled < budget)
 	{
-		Serial.printf("Received from MQTT: %s\n", mqtt_receive_buffer);
-		act_onJson_message(mqtt_receive_buffer, mqtt_deliver_command_result);
-		clearIncomingMQTTMessage();
+		unsigned int recordSize;
+		char *message = peekIncomingMQTTMessage(&recordSize);
+
+		if (message == NULL)
+		{
+			break;
+		}
+
+		handleMessage(message);
+		releaseIncomingMQTTMessage(recordSize);
+		handled++;
 	}
+
+	return handled;
+}
+
+void actOnIncomingMQTTMessage(char *message)
+{
+	Serial.printf("Received from MQTT: %s\n", message);
+	act_onJson_message(message, mqtt_deliver_command_result);
 }
 
 int mqttConnectErrorNumber;
@@ -240,7 +385,7 @@ void restartMQTT()
 {
 	messagesReceived = 0;
 	messagesSent = 0;
-	clearIncomingMQTTMessage();
+	clearIncomingMQTTMessages();
 
 	if (mqttSettings.mqttServer[0]==0)
 	{
@@ -339,48 +484,219 @@ void restartMQTT()
 
 int mqttRetries = 0;
 
-int publishBufferToMQTTTopic(char *buffer, char *topic)
+// Outgoing message queue
+// Messages are queued by publishBufferToMQTTTopic and sent by updateMQTT, a
+// limited number on each pass. Messages stay in the queue while the connection
+// is down and are sent once it has been restored. A reading sent by a sensor
+// listener replaces any reading from the same listener to the same topic which
+// is still waiting, so a slow broker gets the latest value rather than a backlog.
+// When the queue is full the oldest message is dropped.
+
+struct mqttPublishEntry
+{
+	char *topic;
+	char *payload;
+	const void *coalesceKey; // the listener that sent the reading, NULL for other messages
+	int attempts;
+};
+
+struct mqttPublishEntry mqttPublishQueue[MQTT_PUBLISH_QUEUE_LENGTH];
+int mqttPublishQueueStart = 0;
+int mqttPublishQueueCount = 0;
+int mqttPublishQueueBytes = 0;
+
+unsigned long mqttPublishCoalesced = 0;
+unsigned long mqttPublishDropped = 0;
+unsigned long mqttPublishFailed = 0;
+
+struct mqttPublishEntry *getQueuedMQTTMessage(int position)
 {
+	return &mqttPublishQueue[(mqttPublishQueueStart + position) % MQTT_PUBLISH_QUEUE_LENGTH];
+}
+
+int getMQTTPublishEntrySize(const char *topic, const char *payload)
+{
+	return strlen(topic) + 1 + strlen(payload) + 1;
+}
 
-	if (MQTTProcessDescriptor.status == MQTT_OK)
+// the topic and payload are held in a single block
+
+void fillMQTTPublishEntry(struct mqttPublishEntry *entry, const char *topic, const char *payload)
+{
+	int topicSize = strlen(topic) + 1;
+	char *block = new char[getMQTTPublishEntrySize(topic, payload)];
+	strcpy(block, topic);
+	strcpy(block + topicSize, payload);
+	entry->topic = block;
+	entry->payload = block + topicSize;
+	entry->attempts = 0;
+	mqttPublishQueueBytes = mqttPublishQueueBytes + getMQTTPublishEntrySize(topic, payload);
+}
+
+void emptyMQTTPublishEntry(struct mqttPublishEntry *entry)
+{
+	mqttPublishQueueBytes = mqttPublishQueueBytes - getMQTTPublishEntrySize(entry->topic, entry->payload);
+	delete[] entry->topic;
+	entry->topic = NULL;
+	entry->payload = NULL;
+}
+
+void removeOldestQueuedMQTTMessage()
+{
+	emptyMQTTPublishEntry(getQueuedMQTTMessage(0));
+	mqttPublishQueueStart = (mqttPublishQueueStart + 1) % MQTT_PUBLISH_QUEUE_LENGTH;
+	mqttPublishQueueCount--;
+}
+
+// removes the message at a position in the queue, closing up the gap
+
+void removeQueuedMQTTMessage(int position)
+{
+	if (position == 0)
+	{
+		removeOldestQueuedMQTTMessage();
+		return;
+	}
+
+	emptyMQTTPublishEntry(getQueuedMQTTMessage(position));
+
+	for (int i = position; i < mqttPublishQueueCount - 1; i++)
 	{
-		messagesSent++;
+		*getQueuedMQTTMessage(i) = *getQueuedMQTTMessage(i + 1);
+	}
+
+	mqttPublishQueueCount--;
+}
+
+int queueMQTTMessage(const char *topic, const char *payload, const void *coalesceKey)
+{
+	int size = getMQTTPublishEntrySize(topic, payload);
 
-		char topicBuffer [MQTT_TOPIC_PREFIX_LENGTH+MQTT_TOPIC_LENGTH];
+	if (size > MQTT_PUBLISH_QUEUE_BYTES)
+	{
+		mqttPublishFailed++;
+		displayMessage(MQTT_STATUS_PUBLISH_FAILED_MESSAGE_NUMBER, ledFlashAlertState, MQTT_STATUS_PUBLISH_FAILED_MESSAGE_TEXT);
+		return MQTT_STATUS_PUBLISH_FAILED_MESSAGE_NUMBER;
+	}
 
-		if( mqttSettings.mqttTopicPrefix[0]==0)
+	if (coalesceKey != NULL)
+	{
+		for (int i = 0; i < mqttPublishQueueCount; i++)
 		{
-			// no prefix - just send the topic
-			snprintf(topicBuffer,MQTT_TOPIC_PREFIX_LENGTH+MQTT_TOPIC_LENGTH,"%s", topic);
-		}
-		else {
-			// send the prefix separated from the topic by a /
-			snprintf(topicBuffer,MQTT_TOPIC_PREFIX_LENGTH+MQTT_TOPIC_LENGTH,"%s/%s", mqttSettings.mqttTopicPrefix,topic);
+			struct mqttPublishEntry *entry = getQueuedMQTTMessage(i);
+
+			if (entry->coalesceKey == coalesceKey && strcmp(entry->topic, topic) == 0)
+			{
+				// a larger reading may need room - drop the oldest of the other messages
+				int position = i;
+
+				while (mqttPublishQueueBytes - getMQTTPublishEntrySize(entry->topic, entry->payload) + size >
+					   MQTT_PUBLISH_QUEUE_BYTES)
+				{
+					int dropPosition = (position == 0) ? 1 : 0;
+					removeQueuedMQTTMessage(dropPosition);
+					mqttPublishDropped++;
+					if (dropPosition < position)
+					{
+						position--;
+					}
+					entry = getQueuedMQTTMessage(position);
+				}
+
+				// replace the waiting reading, keeping its place in the queue
+				emptyMQTTPublishEntry(entry);
+				fillMQTTPublishEntry(entry, topic, payload);
+				mqttPublishCoalesced++;
+				return MQTT_STATUS_TRANSMIT_OK_MESSAGE_NUMBER;
+			}
 		}
+	}
 
-		Serial.printf("MQTT publishing:%s to topic:%s\n", buffer, topicBuffer);
+	while (mqttPublishQueueCount == MQTT_PUBLISH_QUEUE_LENGTH ||
+		   mqttPublishQueueBytes + size > MQTT_PUBLISH_QUEUE_BYTES)
+	{
+		removeOldestQueuedMQTTMessage();
+		mqttPublishDropped++;
+	}
+
+	struct mqttPublishEntry *entry = getQueuedMQTTMessage(mqttPublishQueueCount);
+	fillMQTTPublishEntry(entry, topic, payload);
+	entry->coalesceKey = coalesceKey;
+	mqttPublishQueueCount++;
+
+	// a queued message counts as sent as far as the caller is concerned
+	return MQTT_STATUS_TRANSMIT_OK_MESSAGE_NUMBER;
+}
 
-		boolean result = mqttPubSubClient->publish(topicBuffer, buffer);
+// Sends up to budget messages from the queue. Stops at the first failure so
+// that messages are sent in order. A failure with the connection still up
+// counts as an attempt and the message is dropped after MQTT_NO_OF_RETRIES.
 
-		if(result)
+void sendQueuedMQTTMessages(int budget)
+{
+	while (budget > 0 && mqttPublishQueueCount > 0 && MQTTProcessDescriptor.status == MQTT_OK)
+	{
+		struct mqttPublishEntry *entry = getQueuedMQTTMessage(0);
+
+		Serial.printf("MQTT publishing %d bytes to topic:%s", (int)strlen(entry->payload), entry->topic);
+
+		if (mqttPubSubClient->publish(entry->topic, entry->payload))
 		{
 			Serial.println();
+			messagesSent++;
+			removeOldestQueuedMQTTMessage();
 			displayMessage(MQTT_STATUS_TRANSMIT_OK_MESSAGE_NUMBER, ledFlashNormalState, MQTT_STATUS_TRANSMIT_OK_MESSAGE_TEXT);
-			return MQTT_STATUS_TRANSMIT_OK_MESSAGE_NUMBER;
+			budget--;
+			continue;
 		}
-		else
+
+		Serial.println(" - Failed");
+		displayMessage(MQTT_STATUS_PUBLISH_FAILED_MESSAGE_NUMBER, ledFlashAlertState, MQTT_STATUS_PUBLISH_FAILED_MESSAGE_TEXT);
+
+		if (mqttPubSubClient->connected())
 		{
-			Serial.println(" - Failed");
-			displayMessage(MQTT_STATUS_PUBLISH_FAILED_MESSAGE_NUMBER, ledFlashAlertState, MQTT_STATUS_PUBLISH_FAILED_MESSAGE_TEXT);
-			return MQTT_STATUS_PUBLISH_FAILED_MESSAGE_NUMBER;
+			entry->attempts++;
+			if (entry->attempts >= MQTT_NO_OF_RETRIES)
+			{
+				mqttPublishFailed++;
+				removeOldestQueuedMQTTMessage();
+			}
 		}
+
+		// try again on the next update, or once the connection is back
+		break;
 	}
+}
 
-	Serial.println("Not publishing message");
+int publishBufferToMQTTTopic(char *buffer, char *topic)
+{
+	if (!mqttSettings.mqtt_enabled || MQTTProcessDescriptor.status == MQTT_ERROR_NOT_CONFIGURED)
+	{
+		Serial.println("Not publishing message");
+
+		displayMessage(MQTT_STATUS_MESSAGE_CANT_SEND_MESSAGE_NUMBER, ledFlashAlertState, MQTT_STATUS_MESSAGE_CANT_SEND_MESSAGE_TEXT);
+
+		return MQTT_STATUS_MESSAGE_CANT_SEND_MESSAGE_NUMBER;
+	}
 
-	displayMessage(MQTT_STATUS_MESSAGE_CANT_SEND_MESSAGE_NUMBER, ledFlashAlertState, MQTT_STATUS_MESSAGE_CANT_SEND_MESSAGE_TEXT);
+	char topicBuffer [MQTT_TOPIC_PREFIX_LENGTH+MQTT_TOPIC_LENGTH];
+
+	if( mqttSettings.mqttTopicPrefix[0]==0)
+	{
+		// no prefix - just send the topic
+		snprintf(topicBuffer,MQTT_TOPIC_PREFIX_LENGTH+MQTT_TOPIC_LENGTH,"%s", topic);
+	}
+	else {
+		// send the prefix separated from the topic by a /
+		snprintf(topicBuffer,MQTT_TOPIC_PREFIX_LENGTH+MQTT_TOPIC_LENGTH,"%s/%s", mqttSettings.mqttTopicPrefix,topic);
+	}
 
-	return MQTT_STATUS_MESSAGE_CANT_SEND_MESSAGE_NUMBER;
+	int result = queueMQTTMessage(topicBuffer, buffer, activeSensorListener);
+
+	// send it on the next pass rather than the next service of the client
+	wakeProcess(&MQTTProcessDescriptor);
+
+	return result;
 }
 
 int publishCommandToRemoteDevice(char *buffer, char *remoteDeviceName)
@@ -410,9 +726,45 @@ void stopMQTT()
 
 unsigned long timeOfLastMQTTsuccess = 0;
 
+// sleep until there are messages to move, the client needs servicing
+// or a reconnect is due
+
+void scheduleMQTTUpdate()
+{
+	unsigned int recordSize;
+
+	if (peekIncomingMQTTMessage(&recordSize) != NULL ||
+		(mqttPublishQueueCount > 0 && MQTTProcessDescriptor.status == MQTT_OK))
+	{
+		wakeProcess(&MQTTProcessDescriptor);
+		return;
+	}
+
+	switch (MQTTProcessDescriptor.status)
+	{
+	case MQTT_OK:
+		scheduleProcessWakeup(&MQTTProcessDescriptor, MQTT_LOOP_INTERVAL_MILLIS);
+		break;
+
+	case MQTT_STARTING:
+		wakeProcess(&MQTTProcessDescriptor);
+		break;
+
+	case MQTT_OFF:
+	case MQTT_ERROR_NOT_CONFIGURED:
+	case MQTT_ERROR_NO_WIFI:
+		scheduleProcessWakeup(&MQTTProcessDescriptor, MQTT_STATE_POLL_MILLIS);
+		break;
+
+	default:
+		scheduleProcessAt(&MQTTProcessDescriptor, timeOfLastMQTTsuccess + MQTT_CONNECT_RETRY_INTERVAL_MSECS + 1);
+		break;
+	}
+}
+
 void updateMQTT()
 {
-	handleIncomingMQTTMessage();
+	handleIncomingMQTTMessages(MQTT_RECEIVE_MESSAGES_PER_UPDATE, actOnIncomingMQTTMessage);
 
 	switch (MQTTProcessDescriptor.status)
 	{
@@ -433,6 +785,8 @@ void updateMQTT()
 			MQTTProcessDescriptor.status = MQTT_ERROR_LOOP_FAILED;
 		}
 
+		sendQueuedMQTTMessages(MQTT_PUBLISH_MESSAGES_PER_UPDATE);
+
 		if(!mqttStartCommandsPerformed)
 		{
 			performCommandsInStore(MQTT_CONNECTED_COMMAND_STORE);
@@ -454,7 +808,7 @@ void updateMQTT()
 		if (mqttSettings.mqttServer[0]!=0)
 		{
 			MQTTProcessDescriptor.status = MQTT_STARTING;
-			return;
+			break;
 		}
 
 	case MQTT_ERROR_NO_WIFI:
@@ -483,6 +837,8 @@ void updateMQTT()
 	default:
 		break;
 	}
+
+	scheduleMQTTUpdate();
 }
 
 bool MQTTStatusOK()
@@ -495,7 +851,9 @@ void mqttStatusMessage(char *buffer, int bufferLength)
 	switch (MQTTProcessDescriptor.status)
 	{
 	case MQTT_OK:
-		snprintf(buffer, bufferLength, "MQTT OK sent: %d rec: %d", messagesSent, messagesReceived);
+		snprintf(buffer, bufferLength, "MQTT OK sent: %d rec: %d queued: %d coalesced: %lu dropped in: %lu out: %lu",
+				 messagesSent, messagesReceived, mqttPublishQueueCount, mqttPublishCoalesced,
+				 mqttReceiveOverflows + mqttReceiveTooLong, mqttPublishDropped + mqttPublishFailed);
 		break;
 	case MQTT_STARTING:
 		snprintf(buffer, bufferLength, "MQTT Starting");
@@ -25,6 +25,11 @@
 
 #define MQTT_CONNECT_RETRY_INTERVAL_MSECS 60000
 
+// how often the client is serviced while connected
+#define MQTT_LOOP_INTERVAL_MILLIS 10
+// how often the process checks for WiFi or settings while waiting to connect
+#define MQTT_STATE_POLL_MILLIS 250
+
 #define MQTT_USER_NAME_LENGTH 100
 #define MQTT_PASSWORD_LENGTH 200
 #define MQTT_TOPIC_LENGTH 150
@@ -52,6 +57,26 @@
 
 #define MQTT_BUFFER_SIZE_MAX 1000
 
+// Incoming messages are queued by the MQTT callback in a ring of variable length
+// records and handled by updateMQTT, a limited number on each pass.
+// A record is a two byte length followed by the message and a terminator.
+
+// largest message that will be accepted, including the terminator
+#define MQTT_RECEIVE_BUFFER_SIZE 240
+
+#define MQTT_RECEIVE_RING_SIZE 2048
+#define MQTT_RECEIVE_RECORD_HEADER_SIZE 2
+#define MQTT_RECEIVE_WRAP_MARKER 0xFFFF
+#define MQTT_RECEIVE_MESSAGES_PER_UPDATE 4
+
+// Outgoing messages are queued and sent by updateMQTT.
+// The queue holds at most MQTT_PUBLISH_QUEUE_LENGTH messages using
+// at most MQTT_PUBLISH_QUEUE_BYTES of topic and payload text.
+
+#define MQTT_PUBLISH_QUEUE_LENGTH 8
+#define MQTT_PUBLISH_QUEUE_BYTES 2048
+#define MQTT_PUBLISH_MESSAGES_PER_UPDATE 2
+
 struct MqttSettings
 {
 	char mqttDeviceName[DEVICE_NAME_LENGTH];
@@ -78,6 +103,13 @@ int publishBufferToMQTT(char * buffer);
 int publishCommandToRemoteDevice(char *buffer, char * topic);
 int publishBufferToMQTTTopic(char *buffer, char * topic);
 
+extern unsigned long mqttReceiveOverflows;
+extern unsigned long mqttReceiveTooLong;
+extern unsigned int mqttReceivePeakBytes;
+
+int handleIncomingMQTTMessages(int budget, void (*handleMessage)(char *message));
+unsigned int getMQTTReceiveBytesUsed();
+
 
 boolean validateMQTTtopic(void *dest, const char *newValueStr);
 
@@ -3,6 +3,7 @@
 #include "settings.h"
 #include "pixels.h"
 #include "otaupdate.h"
+#include "settingsstore.h"
 
 #if defined(ARDUINO_ARCH_ESP8266)
 #include <ESP8266httpUpdate.h>
@@ -95,6 +96,8 @@ void makeUpdateURL( char * buffer, int bufferLength)
 
 void performOTAUpdate()
 {
+	// the update restarts the device
+	flushSettings();
 
 	WiFiClient client;
 	
@@ -152,6 +155,8 @@ void initOtaUpdate()
 void startOtaUpdate()
 {
 	otaUpdateProcessDescriptor.status = OTAUPDATE_OK;
+	// updates are started by command, there is nothing to do in update
+	setProcessEventDriven(&otaUpdateProcessDescriptor);
 }
 
 void updateOtaUpdate()
@@ -251,6 +251,7 @@ int doPulseOutPinCommand(char * destination, unsigned char * settingBase)
     // haven't set the pin to the new state yet - record the current state
     outpinHoldOriginalState = outpinState;
     outpinHoldActive=true;
+    scheduleProcessWakeup(&outPinProcess, outPinHoldTime);
 
     setOutPinUsingActiveHigh(newState);
 
@@ -331,6 +332,9 @@ void startOutPin()
     {
         outPinProcess.status = OUTPIN_STOPPED;
     }
+
+    // only needs updating when a pulse hold is running
+    setProcessEventDriven(&outPinProcess);
 }
 
 void updateOutPin()
@@ -350,8 +354,9 @@ void updateOutPin()
     // Get the time since the hold started
     unsigned long elapsedTime = ulongDiff(millis(),outPinHoldMillisStart);
 
-    // Quit if the hold is not over yet
+    // Sleep until the end of the hold if it is not over yet
     if(elapsedTime<outPinHoldTime){
+        scheduleProcessWakeup(&outPinProcess, outPinHoldTime - elapsedTime);
         return;
     }
 
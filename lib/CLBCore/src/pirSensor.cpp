@@ -123,7 +123,7 @@ void updatePIRSensor()
 				snprintf(messageBuffer, MAX_MESSAGE_LENGTH, "clear");
 			}
 
-			pos->receiveMessage(config->destination, config->optionBuffer);
+			sendToSensorListener(pos);
 			pos->lastReadingMillis = pirSensor.millisAtLastReading;
 			pos = pos->nextMessageListener;
 			continue;
@@ -133,7 +133,7 @@ void updatePIRSensor()
 		{
 			if (pirSensoractiveReading->triggered)
 			{
-				pos->receiveMessage(config->destination, config->optionBuffer);
+				sendToSensorListener(pos);
 				pos->lastReadingMillis = pirSensor.millisAtLastReading;
 				pos = pos->nextMessageListener;
 				continue;
@@ -144,7 +144,7 @@ void updatePIRSensor()
 		{
 			if (!pirSensoractiveReading->triggered)
 			{
-				pos->receiveMessage(config->destination, config->optionBuffer);
+				sendToSensorListener(pos);
 				pos->lastReadingMillis = pirSensor.millisAtLastReading;
 				pos = pos->nextMessageListener;
 				continue;
@@ -225,9 +225,11 @@ void updatePirSensorReading()
 	{
 	case SENSOR_OK:
 		updatePIRSensor();
+		scheduleSensorWakeup(&pirSensor, PIR_POLL_INTERVAL_MILLIS);
 		break;
 
 	case PIRSENSOR_NOT_FITTED:
+		setSensorEventDriven(&pirSensor);
 		break;
 	}
 }
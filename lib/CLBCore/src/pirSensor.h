@@ -5,6 +5,8 @@
 
 #define PIR_READING_LIFETIME_MSECS 5000
 
+#define PIR_POLL_INTERVAL_MILLIS 20
+
 #define PIRSENSOR_NOT_FITTED -1
 #define PIRSENSOR_NOT_CONNECTED -2
 
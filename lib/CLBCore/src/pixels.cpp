@@ -147,6 +147,34 @@ struct SettingItem pixelBrightnessSetting = {"Default pixel brightness",
 											 setDefaultPixelBrightness,
 											 validatePixelBrightness};
 
+boolean validatePixelGammaDither(void *dest, const char *newValueStr)
+{
+	if (!validateYesNo(dest, newValueStr))
+	{
+		return false;
+	}
+
+	if (leds != NULL)
+	{
+		leds->gammaDither = *(bool *)dest;
+
+		if (frame != NULL)
+		{
+			frame->markChanged();
+		}
+	}
+
+	return true;
+}
+
+struct SettingItem pixelGammaDitherSetting = {"Gamma correct and dither pixels",
+											  "pixelgamma",
+											  &pixelSettings.gammaDither,
+											  ONOFF_INPUT_LENGTH,
+											  yesNo,
+											  setTrue,
+											  validatePixelGammaDither};
+
 void setDefaultPixelConfig(void *dest)
 {
 	int *destConfig = (int *)dest;
@@ -187,6 +215,7 @@ struct SettingItem *pixelSettingItemPointers[] =
 		&pixelNoOfYPixelsSetting,
 		&pixelPixelConfig,
 		&pixelBrightnessSetting,
+		&pixelGammaDitherSetting,
 		&pixelNameSetting};
 
 struct SettingItemCollection pixelSettingItems = {
@@ -197,6 +226,8 @@ struct SettingItemCollection pixelSettingItems = {
 
 unsigned long millisOfLastPixelUpdate;
 
+neoPixelType pixelStripType;
+
 void startPixelStrip()
 {
 	int noOfPixels = pixelSettings.noOfXPixels * pixelSettings.noOfYPixels;
@@ -209,12 +240,14 @@ void startPixelStrip()
 	switch (pixelSettings.pixelConfig)
 	{
 	case 1:
+		pixelStripType = NEO_GRB + NEO_KHZ800;
 		strip = new Adafruit_NeoPixel(noOfPixels, pixelSettings.pixelControlPinNo,
-									  NEO_GRB + NEO_KHZ800);
+									  pixelStripType);
 		break;
 	case 2:
+		pixelStripType = NEO_KHZ400 + NEO_RGB;
 		strip = new Adafruit_NeoPixel(noOfPixels, pixelSettings.pixelControlPinNo,
-									  NEO_KHZ400 + NEO_RGB);
+									  pixelStripType);
 		break;
 	default:
 		strip = NULL;
@@ -475,7 +508,7 @@ int doSetNamedColour(char *destination, unsigned char *settingBase)
 		return publishCommandToRemoteDevice(buffer, destination);
 	}
 
-	struct colourNameLookup *col;
+	const struct colourNameLookup *col;
 
 	char *colourName = (char *)(settingBase + COLOURNAME_PIXEL_COMMAND_OFFSET);
 
@@ -558,7 +591,7 @@ int doSetRandomColour(char *destination, unsigned char *settingBase)
 		seedRandomFromClock();
 	}
 
-	struct colourNameLookup *randomColour = findRandomColour();
+	const struct colourNameLookup *randomColour = findRandomColour();
 
 	int steps = getUnalignedInt(settingBase + SPEED_PIXEL_COMMAND_OFFSET);
 
@@ -707,6 +740,8 @@ struct Command setPixelValueInColourMap
 		doPixelMapValue
 };
 
+struct ColourMask mapColourMask = {"", 0, true, false};
+
 int doPixelMapValue(char *destination, unsigned char *settingBase)
 {
 	TRACELN("Mapping a pixel value to a mask");
@@ -737,9 +772,15 @@ int doPixelMapValue(char *destination, unsigned char *settingBase)
 	TRACE(" Option:");
 	TRACE(option);
 
-	int maskLength = strlen(colourMask);
-	TRACE(" Mask:");
-	TRACE(colourMask);
+	// sensors can send map commands at a high rate, usually with the same
+	// mask each time, which is only compiled when it changes
+	if (!compileColourMask(&mapColourMask, colourMask) || !mapColourMask.allColours)
+	{
+		TRACELN(" Invalid mask");
+		return JSON_MESSAGE_INVALID_COLOUR_NAME;
+	}
+
+	int maskLength = mapColourMask.length;
 
 	if (value < 0)
 		value = 0;
@@ -748,15 +789,15 @@ int doPixelMapValue(char *destination, unsigned char *settingBase)
 
 	struct Colour colour;
 
-	if (value == 0)
+	if (value == 0 || maskLength == 1)
 	{
-		colour = findColourByChar(colourMask[0])->col;
+		colour = colourChars[mapColourMask.entries[0]].col;
 	}
 	else
 	{
 		if (value == 1)
 		{
-			colour = findColourByChar(colourMask[maskLength - 1])->col;
+			colour = colourChars[mapColourMask.entries[maskLength - 1]].col;
 		}
 		else
 		{
@@ -767,19 +808,16 @@ int doPixelMapValue(char *destination, unsigned char *settingBase)
 			if (strcasecmp(option, "mix") == 0)
 			{
 				int lowCol = (int)colourPos;
-				int highCol = lowCol + 1;
 				TRACE(" LowCol:");
 				TRACE(lowCol);
-				TRACE(" HighCol:");
-				TRACE(highCol);
-				getColourInbetweenMask(colourMask[lowCol], colourMask[highCol], colourPos - lowCol, &colour);
+				getColourInbetweenMask(&mapColourMask, lowCol, colourPos - lowCol, &colour);
 			}
 			else
 			{
 				int intPos = int(colourPos + 0.5);
 				TRACE(" IntPos:");
 				TRACE(intPos);
-				colour = findColourByChar(colourMask[intPos])->col;
+				colour = colourChars[mapColourMask.entries[intPos]].col;
 			}
 		}
 	}
@@ -821,16 +859,44 @@ void setPixel(int no, float r, float g, float b)
 	strip->setPixelColor(rasterLookup[no], rs, gs, bs);
 }
 
-// status display doesn't use the animated leds
-// this means that it can overlay the display
+void setPixelBytes(int no, uint8_t r, uint8_t g, uint8_t b)
+{
+	strip->setPixelColor(rasterLookup[no], r, g, b);
+}
+
+// The status display shows a row of coloured pixels, one for each item
+// added, on a dim background. Once the frame has been started the status
+// is shown by the frame over the animated display for a while, otherwise
+// the pixels are written straight to the strip. Neither waits, the
+// status just stays up until the frame times it out or it is replaced.
 
 int statusPixelNo = 0;
 
+Colour statusItemColours[MAX_NO_OF_STATUS_ITEMS];
+
 #define STATUS_DISPLAY_BACKGROUND \
 	{                             \
 		0.01, 0.01, 0.01          \
 	}
 
+int getNoOfStatusPixels()
+{
+	int noOfPixels = pixelSettings.noOfXPixels * pixelSettings.noOfYPixels;
+
+	if (noOfPixels > MAX_NO_OF_STATUS_ITEMS)
+	{
+		return MAX_NO_OF_STATUS_ITEMS;
+	}
+
+	return noOfPixels;
+}
+
+void showStatusItems()
+{
+	Colour background = STATUS_DISPLAY_BACKGROUND;
+	frame->showStatus(statusItemColours, statusPixelNo, background, STATUS_DISPLAY_MILLIS);
+}
+
 void resetStatusDisplay()
 {
 	Colour col = STATUS_DISPLAY_BACKGROUND;
@@ -842,6 +908,9 @@ void resetStatusDisplay()
 
 	statusPixelNo = 0;
 
+	if (frame != NULL)
+		return;
+
 	for (int i = 0; i < noOfPixels; i++)
 	{
 		setPixel(i, col.Red, col.Green, col.Blue);
@@ -856,45 +925,55 @@ void beginStatusDisplay()
 
 boolean setStatusDisplayPixel(int pixelNumber, PixelStatusLevels status)
 {
-	int noOfPixels = pixelSettings.noOfXPixels * pixelSettings.noOfYPixels;
-
-	if (noOfPixels == 0)
+	if (pixelNumber >= getNoOfStatusPixels())
 		return false;
 
-	if (pixelNumber >= noOfPixels)
-		return false;
+	Colour *col = &statusItemColours[pixelNumber];
 
 	switch (status)
 	{
 	case PIXEL_STATUS_OK:
-		setPixel(pixelNumber, 0, 0.5, 0); // green
+		*col = {0, 0.5, 0}; // green
 		break;
 	case PIXEL_STATUS_NOTIFICATION:
-		setPixel(pixelNumber, 0, 0, 0.5); // blue
+		*col = {0, 0, 0.5}; // blue
 		break;
 	case PIXEL_STATUS_WARNING:
-		setPixel(pixelNumber, 0.5, 0.5, 0); // yellow
+		*col = {0.5, 0.5, 0}; // yellow
 		break;
 	case PIXEL_STATUS_ERROR:
-		setPixel(pixelNumber, 0.5, 0, 0);
+		*col = {0.5, 0, 0};
 		break;
 	}
 
+	if (frame == NULL)
+	{
+		setPixel(pixelNumber, col->Red, col->Green, col->Blue);
+	}
+
 	return true;
 }
 
 void renderStatusDisplay()
 {
+	if (frame != NULL)
+	{
+		// render now as well as leaving the status up, as this may be
+		// called from something that blocks the pixel process
+		showStatusItems();
+		frame->render();
+		return;
+	}
+
 	if (strip == NULL)
 		return;
 
 	strip->show();
-	delay(200);
 }
 
 void addStatusItem(PixelStatusLevels status)
 {
-	int noOfPixels = pixelSettings.noOfXPixels * pixelSettings.noOfYPixels;
+	int noOfPixels = getNoOfStatusPixels();
 
 	if (noOfPixels == 0)
 		return;
@@ -909,56 +988,63 @@ void addStatusItem(PixelStatusLevels status)
 	return;
 }
 
-void initPixel()
-{
-	pixelProcess.status = PIXEL_OFF;
-
-	int noOfPixels = pixelSettings.noOfXPixels * pixelSettings.noOfYPixels;
-
-	if (noOfPixels == 0)
-	{
-		pixelProcess.status = PIXEL_NO_PIXELS;
-		return;
-	}
-
-	rasterLookup = new int[noOfPixels];
+// maps the row major led number to the position of that pixel on the strip
 
+void buildRasterLookup(int *lookup, int width, int height)
+{
 	// if we have a string of pixels just build a flat decode array
 
-	if (pixelSettings.noOfYPixels == 1)
+	if (height == 1)
 	{
-		for (int i = 0; i < pixelSettings.noOfXPixels; i++)
+		for (int i = 0; i < width; i++)
 		{
-			rasterLookup[i] = i;
+			lookup[i] = i;
 		}
 	}
 	else
 	{
-		int dest = (pixelSettings.noOfYPixels * pixelSettings.noOfXPixels) - 1;
+		int dest = (height * width) - 1;
 
-		for (int y = 0; y < pixelSettings.noOfYPixels; y++)
+		for (int y = 0; y < height; y++)
 		{
-			for (int x = 0; x < pixelSettings.noOfXPixels; x++)
+			for (int x = 0; x < width; x++)
 			{
-				int rowStart = y * pixelSettings.noOfXPixels;
+				int rowStart = y * width;
 				int pos;
 
 				if ((y & 1))
 				{
 					// even row - ascending order
 					pos = rowStart + x;
-					rasterLookup[dest] = pos;
+					lookup[dest] = pos;
 				}
 				else
 				{
 					// odd row - descending order
-					pos = rowStart + (pixelSettings.noOfXPixels - x - 1);
+					pos = rowStart + (width - x - 1);
 				}
-				rasterLookup[dest] = pos;
+				lookup[dest] = pos;
 				dest--;
 			}
 		}
 	}
+}
+
+void initPixel()
+{
+	pixelProcess.status = PIXEL_OFF;
+
+	int noOfPixels = pixelSettings.noOfXPixels * pixelSettings.noOfYPixels;
+
+	if (noOfPixels == 0)
+	{
+		pixelProcess.status = PIXEL_NO_PIXELS;
+		return;
+	}
+
+	rasterLookup = new int[noOfPixels];
+
+	buildRasterLookup(rasterLookup, pixelSettings.noOfXPixels, pixelSettings.noOfYPixels);
 
 	startPixelStrip();
 }
@@ -982,16 +1068,32 @@ void startPixel()
 		return;
 	}
 
-	leds = new Leds(pixelSettings.noOfXPixels, pixelSettings.noOfYPixels, show, setPixel);
+	leds = new Leds(pixelSettings.noOfXPixels, pixelSettings.noOfYPixels, show, setPixel, setPixelBytes);
+	leds->gammaDither = pixelSettings.gammaDither;
+
+	if (strip != NULL)
+	{
+		// let the fixed point display write straight into the strip buffer
+		// the colour offsets are packed into the low byte of the strip type
+		leds->setOutputBuffer(strip->getPixels(), rasterLookup,
+							  (pixelStripType >> 4) & 3, (pixelStripType >> 2) & 3, pixelStripType & 3);
+	}
 
-	frame = new Frame(leds, BLACK_COLOUR);
+	frame = new Frame(leds, BLACK_COLOUR, Frame::getSpritePoolSize(noOfPixels));
 	frame->fadeUp(1000);
 
 	millisOfLastPixelUpdate = millis();
 	pixelProcess.status = PIXEL_OK;
+	scheduleProcessAt(&pixelProcess, millisOfLastPixelUpdate);
 
 	frame->fadeSpritesToWalkingColours("RGBYMC", 10);
 	frame->fadeToBrightness(pixelSettings.brightness, 10);
+
+	// keep showing any status from before the frame started
+	if (statusPixelNo > 0)
+	{
+		showStatusItems();
+	}
 }
 
 void showDeviceStatus();	   // declared in control.h
@@ -1000,14 +1102,24 @@ boolean getInputSwitchValue(); // declared in inputswitch.h
 void updateFrame()
 {
 	unsigned long currentMillis = millis();
-	unsigned long millisSinceLastUpdate = ulongDiff(currentMillis, millisOfLastPixelUpdate);
 
-	if (millisSinceLastUpdate >= MILLIS_BETWEEN_UPDATES)
+	// the animations are worked out from the time, so a late update
+	// catches up rather than slowing them down
+	frame->update(currentMillis);
+	frame->renderIfChanged();
+	millisOfLastPixelUpdate = currentMillis;
+
+	// step the wake time on by one frame so that frames stay periodic
+	// if we have fallen more than a frame behind start again from now
+
+	unsigned long nextFrameMillis = pixelProcess.wakeMillis + MILLIS_BETWEEN_UPDATES;
+
+	if (millisReached(nextFrameMillis, currentMillis))
 	{
-		frame->update();
-		frame->render();
-		millisOfLastPixelUpdate = currentMillis;
+		nextFrameMillis = currentMillis + MILLIS_BETWEEN_UPDATES;
 	}
+
+	scheduleProcessAt(&pixelProcess, nextFrameMillis);
 }
 
 void updatePixel()
@@ -1046,7 +1158,8 @@ void pixelStatusMessage(char *buffer, int bufferLength)
 		snprintf(buffer, bufferLength, "No pixels connected");
 		break;
 	case PIXEL_OK:
-		snprintf(buffer, bufferLength, "PIXEL OK");
+		snprintf(buffer, bufferLength, "PIXEL OK rendered:%lu skipped:%lu dithered:%lu",
+				 frame->framesRendered, frame->framesSkipped, frame->framesDithered);
 		break;
 	case PIXEL_OFF:
 		snprintf(buffer, bufferLength, "PIXEL OFF");
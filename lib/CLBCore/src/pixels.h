@@ -20,6 +20,12 @@
 #define PIXEL_STRING_CONFIG NEO_KHZ400+NEO_RGB
 
 #define MAX_NO_OF_PIXELS 200
+
+// status items wrap around after this many pixels and stay on the
+// display for this long after the last one is rendered
+#define MAX_NO_OF_STATUS_ITEMS 32
+#define STATUS_DISPLAY_MILLIS 1500
+
 #define MAX_PIXEL_NAME_LENGTH 32
 
 #define MILLIS_BETWEEN_UPDATES 20
@@ -51,6 +57,7 @@ struct PixelSettings
 	int noOfYPixels;
 	int pixelConfig;
 	float brightness;
+	bool gammaDither;
 	char pixelName[MAX_PIXEL_NAME_LENGTH];
 };
 
@@ -58,7 +65,7 @@ extern Leds *leds;
 extern Frame *frame;
 
 extern struct PixelSettings pixelSettings;
-extern struct colourNameLookup colourNames[];
+extern const struct colourNameLookup colourNames[];
 extern int noOfColours;
 
 extern struct SettingItemCollection pixelSettingItems;
@@ -66,4 +73,7 @@ extern struct SettingItemCollection pixelSettingItems;
 extern struct process pixelProcess;
 
 void fadeWalkingColour(Colour newColour, int noOfSteps);
-struct colourNameLookup * findColourByName(const char * name);
\ No newline at end of file
+
+void buildRasterLookup(int *lookup, int width, int height);
+
+const struct colourNameLookup * findColourByName(const char * name);
\ No newline at end of file
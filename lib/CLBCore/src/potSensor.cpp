@@ -146,7 +146,7 @@ void updatePOTSensor()
 			char *messageBuffer = (char *)pos->config->optionBuffer + MESSAGE_START_POSITION;
 			snprintf(messageBuffer, MAX_MESSAGE_LENGTH, "%.2f", resultValue);
 
-			pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+			sendToSensorListener(pos);
 			pos->lastReadingMillis = buttonSensor.millisAtLastReading;
 			// move on to the next one
 			pos = pos->nextMessageListener;
@@ -219,9 +219,11 @@ void updatePotSensorReading()
 	{
 	case SENSOR_OK:
 		updatePOTSensor();
+		scheduleSensorWakeup(&potSensor, potSensorSettings.millisBetweenReadings);
 		break;
 
 	case POTSENSOR_NOT_FITTED:
+		setSensorEventDriven(&potSensor);
 		break;
 	}
 }
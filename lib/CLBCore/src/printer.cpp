@@ -244,6 +244,9 @@ void startPrinter()
 {
     // all the hardware is set up in the init function. We just display the default message here
 
+    // printing happens when messages arrive, there is nothing to do in update
+    setProcessEventDriven(&printerProcess);
+
     if (printerSettings.printerEnabled)
     {
     	char deviceNameBuffer [DEVICE_NAME_LENGTH];
@@ -176,20 +176,148 @@ void startProcesses()
 	}
 }
 
+// A timed process gets one update when its wake time arrives and then
+// sleeps until it schedules another wakeup or something wakes it
+
+void scheduleProcessAt(struct process *proc, unsigned long wakeMillis)
+{
+	proc->wakeMillis = wakeMillis;
+	proc->scheduleMode = SCHEDULE_TIMED;
+}
+
+void scheduleProcessWakeup(struct process *proc, unsigned long delayMillis)
+{
+	scheduleProcessAt(proc, millis() + delayMillis);
+}
+
+void setProcessEventDriven(struct process *proc)
+{
+	proc->scheduleMode = SCHEDULE_EVENT_DRIVEN;
+}
+
+void setProcessPolled(struct process *proc)
+{
+	proc->scheduleMode = SCHEDULE_POLLED;
+}
+
+void wakeProcess(struct process *proc)
+{
+	scheduleProcessAt(proc, millis());
+}
+
+// returns true if the process should be updated on this pass
+
+bool processDue(struct process *procPtr, unsigned long now)
+{
+	switch (procPtr->scheduleMode)
+	{
+	case SCHEDULE_POLLED:
+		return true;
+
+	case SCHEDULE_TIMED:
+		if (!millisReached(procPtr->wakeMillis, now))
+		{
+			return false;
+		}
+		unsigned long lateMillis = ulongDiff(now, procPtr->wakeMillis);
+		if (lateMillis > SCHEDULE_DEADLINE_TOLERANCE_MILLIS)
+		{
+			procPtr->missedDeadlines++;
+		}
+		if (lateMillis > procPtr->maxLateMillis)
+		{
+			procPtr->maxLateMillis = lateMillis;
+		}
+		// one shot - the update must schedule the next wakeup
+		procPtr->scheduleMode = SCHEDULE_EVENT_DRIVEN;
+		return true;
+	}
+
+	return false;
+}
+
+// the number of milliseconds before any active process needs an update
+
+unsigned long getProcessSleepMillis(unsigned long now)
+{
+	unsigned long sleepMillis = SCHEDULE_MAX_SLEEP_MILLIS;
+
+	struct process *procPtr = activeProcessList;
+
+	while (procPtr != NULL)
+	{
+		switch (procPtr->scheduleMode)
+		{
+		case SCHEDULE_POLLED:
+			return 0;
+
+		case SCHEDULE_TIMED:
+			if (millisReached(procPtr->wakeMillis, now))
+			{
+				return 0;
+			}
+			if (ulongDiff(procPtr->wakeMillis, now) < sleepMillis)
+			{
+				sleepMillis = ulongDiff(procPtr->wakeMillis, now);
+			}
+			break;
+		}
+		procPtr = procPtr->nextActiveProcess;
+	}
+
+	return sleepMillis;
+}
+
 void updateProcesses()
 {
 	struct process *procPtr = activeProcessList;
+	unsigned long now = millis();
 
 	while (procPtr != NULL)
 	{
+		if (!processDue(procPtr, now))
+		{
+			procPtr = procPtr->nextActiveProcess;
+			continue;
+		}
+
 		unsigned long startMicros = micros();
 		procPtr->udpateProcess();
 		procPtr->activeTime = ulongDiff(micros(), startMicros);
 		procPtr->totalTime = procPtr->totalTime + procPtr->activeTime/1000;
+		addLatencySample(&procPtr->latency, procPtr->activeTime);
+		procPtr = procPtr->nextActiveProcess;
+	}
+}
+
+void dumpProcessTimings()
+{
+	Serial.println("Process timings (microsecs)");
+
+	struct process *procPtr = activeProcessList;
+
+	while (procPtr != NULL)
+	{
+		printLatency(procPtr->processName, &procPtr->latency);
+		Serial.printf("        missed deadlines:%lu latest(millisecs):%lu\n",
+					  procPtr->missedDeadlines, procPtr->maxLateMillis);
 		procPtr = procPtr->nextActiveProcess;
 	}
 }
 
+void resetProcessTimings()
+{
+	struct process *procPtr = allProcessList;
+
+	while (procPtr != NULL)
+	{
+		resetLatency(&procPtr->latency);
+		procPtr->missedDeadlines = 0;
+		procPtr->maxLateMillis = 0;
+		procPtr = procPtr->nextAllProcesses;
+	}
+}
+
 void dumpProcessStatus()
 {
 	Serial.println("Processes");
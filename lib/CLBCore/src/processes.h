@@ -4,6 +4,8 @@
 #include "sensors.h"
 #include "settings.h"
 #include "controller.h"
+#include "schedule.h"
+#include "latency.h"
 
 #define BOOT_PROCESS 1
 #define ACTIVE_PROCESS 2
@@ -45,6 +47,11 @@ struct process
 	processMessageListener * listeners;
 	unsigned char * commandItems;
 	int commandItemSize;
+	unsigned char scheduleMode;		   // SCHEDULE_POLLED, SCHEDULE_TIMED or SCHEDULE_EVENT_DRIVEN
+	unsigned long wakeMillis;		   // when a timed process wants its next update
+	unsigned long missedDeadlines;	   // timed updates that ran late
+	unsigned long maxLateMillis;	   // the latest a timed update has run
+	struct latencyHistogram latency; // update times since the timings were reset
 };
 
 void addProcessToAllProcessList(struct process *newProcess);
@@ -59,6 +66,14 @@ struct process *startProcessByName(char *name);
 void startProcesses();
 void updateProcesses();
 void dumpProcessStatus();
+void dumpProcessTimings();
+void resetProcessTimings();
+void scheduleProcessAt(struct process *proc, unsigned long wakeMillis);
+void scheduleProcessWakeup(struct process *proc, unsigned long delayMillis);
+void setProcessEventDriven(struct process *proc);
+void setProcessPolled(struct process *proc);
+void wakeProcess(struct process *proc);
+unsigned long getProcessSleepMillis(unsigned long now);
 void updateProcess(struct process *process);
 void iterateThroughAllProcesses(void (*func)(process *p));
 void iterateThroughActiveProcesses(void (*func)(process *p));
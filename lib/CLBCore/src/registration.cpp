@@ -42,6 +42,7 @@ void initRegistration()
 void startRegistration()
 {
 	RegistrationProcess.status = REGISTRATION_WAITING_FOR_MQTT;
+	wakeProcess(&RegistrationProcess);
 }
 
 void stopRegistration()
@@ -182,6 +183,13 @@ void updateRegistration()
 
 		break;
 	}
+
+	// only keep checking while we are waiting for something
+	if (RegistrationProcess.status == REGISTRATION_WAITING_FOR_MQTT ||
+		RegistrationProcess.status == WAITING_FOR_REGISTRATION_REPLY)
+	{
+		scheduleProcessWakeup(&RegistrationProcess, REGISTRATION_POLL_INTERVAL_MILLIS);
+	}
 }
 
 bool registrationStatusOK()
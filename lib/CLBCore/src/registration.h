@@ -20,6 +20,8 @@
 #define REGISTRATION_WAITING_FOR_MQTT 1002
 #define WAITING_FOR_REGISTRATION_REPLY 1003
 
+#define REGISTRATION_POLL_INTERVAL_MILLIS 100
+
 #define FRIENDLY_NAME_LENGTH 30
 
 extern struct process RegistrationProcess;
@@ -217,7 +217,7 @@ void updateROTARYSensor()
 				// send on pressed - is the button pressed now?
 				if (rotarySensoractiveReading->pressed)
 				{
-					pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+					sendToSensorListener(pos);
 					pos->lastReadingMillis = buttonSensor.millisAtLastReading;
 					// move on to the next one
 					pos = pos->nextMessageListener;
@@ -230,7 +230,7 @@ void updateROTARYSensor()
 				// send on released - is the button released now?
 				if (!rotarySensoractiveReading->pressed)
 				{
-					pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+					sendToSensorListener(pos);
 					pos->lastReadingMillis = buttonSensor.millisAtLastReading;
 					// move on to the next one
 					pos = pos->nextMessageListener;
@@ -253,7 +253,7 @@ void updateROTARYSensor()
 				char *messageBuffer = (char *)pos->config->optionBuffer + MESSAGE_START_POSITION;
 				snprintf(messageBuffer, MAX_MESSAGE_LENGTH, "%.2f", resultValue);
 
-				pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+				sendToSensorListener(pos);
 				pos->lastReadingMillis = buttonSensor.millisAtLastReading;
 				// move on to the next one
 				pos = pos->nextMessageListener;
@@ -323,9 +323,11 @@ void updateRotarySensorReading()
 	{
 	case SENSOR_OK:
 		updateROTARYSensor();
+		scheduleSensorWakeup(&rotarySensor, ROTARY_POLL_INTERVAL_MILLIS);
 		break;
 
 	case ROTARYSENSOR_NOT_FITTED:
+		setSensorEventDriven(&rotarySensor);
 		break;
 	}
 }
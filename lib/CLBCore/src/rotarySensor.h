@@ -5,6 +5,9 @@
 
 #define ROTARY_READING_LIFETIME_MSECS 5000
 
+// The count is kept by the interrupt handler, the button is debounced by polling
+#define ROTARY_POLL_INTERVAL_MILLIS 5
+
 #define ROTARYSENSOR_NOT_FITTED -1
 #define ROTARYSENSOR_NOT_CONNECTED -2
 
@@ -0,0 +1,13 @@
+#pragma once
+
+// How the loop decides when to call the update function of a process or sensor
+
+#define SCHEDULE_POLLED 0		// updated on every pass of the loop (the default)
+#define SCHEDULE_TIMED 1		// updated once when the wake time is reached
+#define SCHEDULE_EVENT_DRIVEN 2 // only updated after something wakes it
+
+// A timed update that runs more than this late counts as a missed deadline
+#define SCHEDULE_DEADLINE_TOLERANCE_MILLIS 5
+
+// Longest time the loop will sleep, even if nothing is due
+#define SCHEDULE_MAX_SLEEP_MILLIS 10
@@ -194,12 +194,12 @@ struct sensor *findSensorSettingCollectionByName(const char *name)
 
 	while (allSensorPtr != NULL)
 	{
-		if (allSensorPtr->settingItems == NULL)
-			continue;
-
-		if (strcasecmp(allSensorPtr->settingItems->collectionName, name) == 0)
+		if (allSensorPtr->settingItems != NULL)
 		{
-			return allSensorPtr;
+			if (strcasecmp(allSensorPtr->settingItems->collectionName, name) == 0)
+			{
+				return allSensorPtr;
+			}
 		}
 		allSensorPtr = allSensorPtr->nextAllSensors;
 	}
@@ -224,6 +224,8 @@ void startSensors()
 	while (activeSensorPtr != NULL)
 	{
 		Serial.printf("   %s: ", activeSensorPtr->sensorName);
+		// every sensor gets a first update, which can then schedule the next one
+		activeSensorPtr->scheduleMode = SCHEDULE_POLLED;
 		activeSensorPtr->startSensor();
 		activeSensorPtr->getStatusMessage(sensorStatusBuffer, SENSOR_STATUS_BUFFER_SIZE);
 		Serial.printf("%s\n", sensorStatusBuffer);
@@ -268,22 +270,142 @@ void startSensorsReading()
 	}
 }
 
-void updateSensors()
+// A timed sensor gets one update when its wake time arrives and then
+// sleeps until it schedules another wakeup or something wakes it
+
+void scheduleSensorAt(struct sensor *s, unsigned long wakeMillis)
+{
+	s->wakeMillis = wakeMillis;
+	s->scheduleMode = SCHEDULE_TIMED;
+}
+
+void scheduleSensorWakeup(struct sensor *s, unsigned long delayMillis)
+{
+	scheduleSensorAt(s, millis() + delayMillis);
+}
+
+void setSensorEventDriven(struct sensor *s)
+{
+	s->scheduleMode = SCHEDULE_EVENT_DRIVEN;
+}
+
+void wakeSensor(struct sensor *s)
+{
+	scheduleSensorAt(s, millis());
+}
+
+// returns true if the sensor should be updated on this pass
+
+bool sensorDue(struct sensor *s, unsigned long now)
 {
+	switch (s->scheduleMode)
+	{
+	case SCHEDULE_POLLED:
+		return true;
+
+	case SCHEDULE_TIMED:
+		if (!millisReached(s->wakeMillis, now))
+		{
+			return false;
+		}
+		unsigned long lateMillis = ulongDiff(now, s->wakeMillis);
+		if (lateMillis > SCHEDULE_DEADLINE_TOLERANCE_MILLIS)
+		{
+			s->missedDeadlines++;
+		}
+		if (lateMillis > s->maxLateMillis)
+		{
+			s->maxLateMillis = lateMillis;
+		}
+		// one shot - the update must schedule the next wakeup
+		s->scheduleMode = SCHEDULE_EVENT_DRIVEN;
+		return true;
+	}
+
+	return false;
+}
+
+// the number of milliseconds before any active sensor needs an update
+
+unsigned long getSensorSleepMillis(unsigned long now)
+{
+	unsigned long sleepMillis = SCHEDULE_MAX_SLEEP_MILLIS;
+
 	sensor *activeSensorPtr = activeSensorList;
 
 	while (activeSensorPtr != NULL)
 	{
 		if (activeSensorPtr->beingUpdated)
+		{
+			switch (activeSensorPtr->scheduleMode)
+			{
+			case SCHEDULE_POLLED:
+				return 0;
+
+			case SCHEDULE_TIMED:
+				if (millisReached(activeSensorPtr->wakeMillis, now))
+				{
+					return 0;
+				}
+				if (ulongDiff(activeSensorPtr->wakeMillis, now) < sleepMillis)
+				{
+					sleepMillis = ulongDiff(activeSensorPtr->wakeMillis, now);
+				}
+				break;
+			}
+		}
+		activeSensorPtr = activeSensorPtr->nextActiveSensor;
+	}
+
+	return sleepMillis;
+}
+
+void updateSensors()
+{
+	sensor *activeSensorPtr = activeSensorList;
+	unsigned long now = millis();
+
+	while (activeSensorPtr != NULL)
+	{
+		if (activeSensorPtr->beingUpdated && sensorDue(activeSensorPtr, now))
 		{
 			unsigned long startMicros = micros();
 			activeSensorPtr->updateSensor();
 			activeSensorPtr->activeTime = ulongDiff(micros(), startMicros);
+			addLatencySample(&activeSensorPtr->latency, activeSensorPtr->activeTime);
 		}
 		activeSensorPtr = activeSensorPtr->nextActiveSensor;
 	}
 }
 
+void dumpSensorTimings()
+{
+	Serial.println("Sensor timings (microsecs)");
+
+	sensor *activeSensorPtr = activeSensorList;
+
+	while (activeSensorPtr != NULL)
+	{
+		printLatency(activeSensorPtr->sensorName, &activeSensorPtr->latency);
+		Serial.printf("        missed deadlines:%lu latest(millisecs):%lu\n",
+					  activeSensorPtr->missedDeadlines, activeSensorPtr->maxLateMillis);
+		activeSensorPtr = activeSensorPtr->nextActiveSensor;
+	}
+}
+
+void resetSensorTimings()
+{
+	sensor *sensorPtr = allSensorList;
+
+	while (sensorPtr != NULL)
+	{
+		resetLatency(&sensorPtr->latency);
+		sensorPtr->missedDeadlines = 0;
+		sensorPtr->maxLateMillis = 0;
+		sensorPtr = sensorPtr->nextAllSensors;
+	}
+}
+
 void createSensorJson(char *name, char *buffer, int bufferLength)
 {
 	snprintf(buffer, bufferLength, "{ \"dev\":\"%s\"", name);
@@ -425,8 +547,8 @@ SettingItem *FindSensorSettingByFormName(const char *settingName)
 					return testSetting;
 				}
 			}
-			allSensorPtr = allSensorPtr->nextAllSensors;
 		}
+		allSensorPtr = allSensorPtr->nextAllSensors;
 	}
 	return NULL;
 }
@@ -465,6 +587,19 @@ void iterateThroughSensorListeners(struct sensor *sensor, void (*func)(struct se
 	}
 }
  
+// The listener being sent a reading, NULL at any other time.
+// Lets a publish made by the command tell readings from one-off messages.
+
+struct sensorListener *activeSensorListener = NULL;
+
+void sendToSensorListener(struct sensorListener *listener)
+{
+	struct sensorListener *previousListener = activeSensorListener;
+	activeSensorListener = listener;
+	listener->receiveMessage(listener->config->destination, listener->config->optionBuffer);
+	activeSensorListener = previousListener;
+}
+
 void fireSensorListenersOnTrigger(struct sensor *sensor, int trigger)
 {
 	struct sensorListener *pos = sensor->listeners;
@@ -479,7 +614,7 @@ void fireSensorListenersOnTrigger(struct sensor *sensor, int trigger)
 			//Serial.println("Got a match");
 			// dumpCommand(pos->config->commandProcess, pos->config->commandName, pos->config->optionBuffer);
 
-			pos->receiveMessage(pos->config->destination, pos->config->optionBuffer);
+			sendToSensorListener(pos);
 			//Serial.println("command performed");
 		}
 		pos = pos->nextMessageListener;
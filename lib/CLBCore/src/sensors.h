@@ -3,6 +3,8 @@
 #include <Arduino.h>
 #include "settings.h"
 #include "controller.h"
+#include "schedule.h"
+#include "latency.h"
 
 #define SENSOR_OK 0
 #define SENSOR_OFF 1
@@ -68,6 +70,11 @@ struct sensor
 	struct sensorListener * listeners;
 	struct sensorEventBinder * sensorListenerFunctions;
 	int noOfSensorListenerFunctions;
+	unsigned char scheduleMode;     // SCHEDULE_POLLED, SCHEDULE_TIMED or SCHEDULE_EVENT_DRIVEN
+	unsigned long wakeMillis;       // when a timed sensor wants its next update
+	unsigned long missedDeadlines;  // timed updates that ran late
+	unsigned long maxLateMillis;    // the latest a timed update has run
+	struct latencyHistogram latency; // update times since the timings were reset
 };
 
 void addSensorToAllSensorsList(struct sensor *newSensor);
@@ -77,6 +84,13 @@ struct sensor * findSensorByName( const char * name);
 struct sensor * findSensorSettingCollectionByName(const char * name);
 void startSensors();
 void dumpSensorStatus();
+void dumpSensorTimings();
+void resetSensorTimings();
+void scheduleSensorAt(struct sensor *s, unsigned long wakeMillis);
+void scheduleSensorWakeup(struct sensor *s, unsigned long delayMillis);
+void setSensorEventDriven(struct sensor *s);
+void wakeSensor(struct sensor *s);
+unsigned long getSensorSleepMillis(unsigned long now);
 void startSensorsReading();
 void updateSensors();
 void createSensorJson(char * name, char * buffer, int bufferLength);
@@ -91,6 +105,8 @@ SettingItem* FindSensorSettingByFormName(const char* settingName);
 void addMessageListenerToSensor(struct sensor *sensor, struct sensorListener * listener);
 void iterateThroughSensorListeners(struct sensor * sensor, void (*func) (struct sensorListener * listener));
 void fireSensorListenersOnTrigger(struct sensor *sensor, int mask);
+void sendToSensorListener(struct sensorListener *listener);
+extern struct sensorListener *activeSensorListener;
 struct sensorEventBinder *findSensorListenerByName(struct sensor *s, const char *name);
 struct sensorEventBinder * findSensorEventBinderByTrigger(struct sensor * s, int mask);
 
@@ -261,6 +261,7 @@ int doPulseServoPositionCommand(char * destination, unsigned char * settingBase)
     servoHoldTime = hold*1000;
     servoHoldOriginalPosition = oldServoPosition;
     servoHoldActive=true;
+    scheduleProcessWakeup(&ServoProcess, servoHoldTime);
 
     return WORKED_OK;
 }
@@ -342,6 +343,9 @@ void startServo()
     {
         ServoProcess.status = SERVO_STOPPED;
     }
+
+    // only needs updating when a pulse hold is running
+    setProcessEventDriven(&ServoProcess);
 }
 
 void updateServo()
@@ -361,8 +365,9 @@ void updateServo()
     // Get the time since the hold started
     unsigned long elapsedTime = ulongDiff(millis(),servoHoldMillisStart);
 
-    // Quit if the hold is not over yet
+    // Sleep until the end of the hold if it is not over yet
     if(elapsedTime<servoHoldTime){
+        scheduleProcessWakeup(&ServoProcess, servoHoldTime - elapsedTime);
         return;
     }
 
@@ -21,6 +21,7 @@
 #include "controller.h"
 #include "registration.h"
 #include "HullOS.h"
+#include "settingsstore.h"
 
 // These functions are called to encrypt/decrypt fields of type password
 // They are identical at the momement, but if you want to add some extra
@@ -926,14 +927,38 @@ void iterateThroughAllSettings(void (*func)(unsigned char *settings, int size))
 	iterateThroughSensorSettings(func);
 }
 
+// the save is coalesced with any others that follow - see flushSettings
+
 void saveSettings()
 {
-	saveAllSettingsToFile(SETTINGS_FILENAME);
+	requestSettingsSave();
 }
 
 bool loadSettings()
 {
-	return loadAllSettingsFromFile(SETTINGS_FILENAME);
+	if (LittleFS.exists(SETTINGS_FILENAME))
+	{
+		// settings saved as text by older firmware - move them into the store
+
+		Serial.println("Migrating text settings to the settings store");
+
+		if (!loadAllSettingsFromFile(SETTINGS_FILENAME))
+		{
+			return false;
+		}
+
+		markAllSettingsDirty();
+		saveAllSettingsToStore();
+
+		if (LittleFS.exists(SETTINGS_MIGRATED_FILENAME))
+		{
+			LittleFS.remove(SETTINGS_MIGRATED_FILENAME);
+		}
+		LittleFS.rename(SETTINGS_FILENAME, SETTINGS_MIGRATED_FILENAME);
+		return true;
+	}
+
+	return loadAllSettingsFromStore() > 0;
 }
 
 boolean matchSettingCollectionName(SettingItemCollection *settingCollection, const char *name)
@@ -1000,7 +1025,98 @@ SettingItem *findSettingByNameInCollection(SettingItemCollection settingCollecti
 	return NULL;
 }
 
-SettingItem *findSettingByName(const char *settingName)
+// Index of every setting sorted by the hash of its formName, built once the
+// sensor and process lists are complete. Sensors are added first so that
+// a name used twice finds the same setting as the linear search.
+
+struct settingIndexEntry
+{
+	uint32_t nameHash;
+	SettingItem *setting;
+};
+
+struct settingIndexEntry *settingIndex = NULL;
+int settingIndexSize = 0;
+int settingIndexCount;
+
+void countSettingCollection(SettingItemCollection *settingCollection)
+{
+	settingIndexSize = settingIndexSize + settingCollection->noOfSettings;
+}
+
+void addSettingCollectionToIndex(SettingItemCollection *settingCollection)
+{
+	for (int settingNo = 0; settingNo < settingCollection->noOfSettings; settingNo++)
+	{
+		SettingItem *setting = settingCollection->settings[settingNo];
+		uint32_t nameHash = hashSettingName(setting->formName);
+
+		// insertion sort keeps entries with the same hash in the order they were added
+		int pos = settingIndexCount;
+		while (pos > 0 && settingIndex[pos - 1].nameHash > nameHash)
+		{
+			settingIndex[pos] = settingIndex[pos - 1];
+			pos--;
+		}
+		settingIndex[pos].nameHash = nameHash;
+		settingIndex[pos].setting = setting;
+		settingIndexCount++;
+	}
+}
+
+void buildSettingIndex()
+{
+	if (settingIndex != NULL)
+	{
+		delete[] settingIndex;
+		settingIndex = NULL;
+	}
+
+	settingIndexSize = 0;
+	iterateThroughSensorSettingCollections(countSettingCollection);
+	iterateThroughProcessSettingCollections(countSettingCollection);
+
+	settingIndex = new settingIndexEntry[settingIndexSize];
+	settingIndexCount = 0;
+	iterateThroughSensorSettingCollections(addSettingCollectionToIndex);
+	iterateThroughProcessSettingCollections(addSettingCollectionToIndex);
+}
+
+SettingItem *findSettingByNameInIndex(const char *settingName)
+{
+	uint32_t nameHash = hashSettingName(settingName);
+
+	// find the first entry with this hash
+	int low = 0;
+	int high = settingIndexCount;
+
+	while (low < high)
+	{
+		int mid = (low + high) / 2;
+		if (settingIndex[mid].nameHash < nameHash)
+		{
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+
+	// check the name in case two names share a hash
+	while (low < settingIndexCount && settingIndex[low].nameHash == nameHash)
+	{
+		if (matchSettingName(settingIndex[low].setting, settingName))
+		{
+			return settingIndex[low].setting;
+		}
+		low++;
+	}
+
+	return NULL;
+}
+
+SettingItem *findSettingByNameLinear(const char *settingName)
 {
 	SettingItem *result;
 
@@ -1016,6 +1132,23 @@ SettingItem *findSettingByName(const char *settingName)
 	return NULL;
 }
 
+bool settingIndexEnabled = true;
+
+SettingItem *findSettingByName(const char *settingName)
+{
+	if (!settingIndexEnabled)
+	{
+		return findSettingByNameLinear(settingName);
+	}
+
+	if (settingIndex == NULL)
+	{
+		buildSettingIndex();
+	}
+
+	return findSettingByNameInIndex(settingName);
+}
+
 processSettingCommandResult processSettingCommand(char *commandStart)
 {
 	char *command = (char *)commandStart;
@@ -1127,11 +1260,15 @@ SettingsSetupStatus setupSettings()
 
 #endif
 
+	buildSettingIndex();
+
 	resetSettings();
 
+	unsigned long loadStartMicros = micros();
+
 	if (loadSettings())
 	{
-		Serial.println("Settings loaded OK");
+		Serial.printf("Settings loaded OK in %lu microsecs\n", ulongDiff(micros(), loadStartMicros));
 		result = SETTINGS_SETUP_OK;
 	}
 	else
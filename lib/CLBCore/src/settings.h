@@ -72,6 +72,7 @@ struct SettingItemCollection
 	char * collectionDescription;
 	SettingItem ** settings;
 	int noOfSettings;
+	unsigned long storedCRC; // CRC of the block last written to or read from the settings store
 };
 
 enum processSettingCommandResult { displayedOK, setOK, settingNotFound, settingValueInvalid };
@@ -86,6 +87,14 @@ void DumpSomeSettings(char * filter);
 void PrintStorage();
 
 SettingItem* findSettingByName(const char* settingName);
+SettingItem* findSettingByNameLinear(const char* settingName);
+void buildSettingIndex();
+
+// false makes findSettingByName search the setting lists, for the settings bench
+extern bool settingIndexEnabled;
+
+void saveAllSettingsToFile(char *path);
+bool loadAllSettingsFromFile(char *path);
 
 SettingItemCollection * findSettingItemCollectionByName(const char * name);
 boolean matchSettingCollectionName(SettingItemCollection* settingCollection, const char* name);
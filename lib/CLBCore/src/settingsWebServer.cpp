@@ -358,6 +358,8 @@ void initWebServer()
 void startWebServer()
 {
 	WebServerProcess.status = WEBSERVER_READY;
+	// only needs updating once it is hosting the config website
+	setProcessEventDriven(&WebServerProcess);
 }
 
 bool startHostingConfigWebsite()
@@ -389,6 +391,7 @@ bool startHostingConfigWebsite()
 	webServer->onNotFound(std::bind(pageNotFound, webServer));
 	webServer->begin();
 	WebServerProcess.status = WEBSERVER_HOSTING;
+	wakeProcess(&WebServerProcess);
 
 	return true;
 }
@@ -398,8 +401,11 @@ void updateWebServer()
 	if (WebServerProcess.status == WEBSERVER_HOSTING)
 	{
 		webServer->handleClient();
+		scheduleProcessWakeup(&WebServerProcess, WEBSERVER_POLL_MILLIS);
+		return;
 	}
 
+	setProcessEventDriven(&WebServerProcess);
 }
 
 void stopWebserver()
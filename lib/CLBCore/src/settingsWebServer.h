@@ -8,6 +8,8 @@
 #define WEBSERVER_OFF 1101
 #define WEBSERVER_READY 1002
 
+#define WEBSERVER_POLL_MILLIS 10
+
 bool startHostingConfigWebsite();
 
 extern struct process WebServerProcess;
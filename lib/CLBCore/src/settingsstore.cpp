@@ -0,0 +1,574 @@
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_ESP8266)
+#include "LittleFS.h"
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include "FS.h"
+#endif
+
+#include "utils.h"
+#include "debug.h"
+#include "settings.h"
+#include "sensors.h"
+#include "processes.h"
+#include "settingsstore.h"
+
+void encryptString(char *destination, int destLength, char *source);
+void decryptString(char *destination, int destLength, char *source);
+
+unsigned long settingsStoreBlocksWritten = 0;
+unsigned long settingsStoreBytesWritten = 0;
+
+// CRC32 (the zip one) - the settings blocks are small so we don't bother with a table
+
+uint32_t updateSettingsCRC(uint32_t crc, const uint8_t *bytes, int length)
+{
+	for (int i = 0; i < length; i++)
+	{
+		crc = crc ^ bytes[i];
+		for (int bit = 0; bit < 8; bit++)
+		{
+			if (crc & 1)
+			{
+				crc = (crc >> 1) ^ 0xEDB88320;
+			}
+			else
+			{
+				crc = crc >> 1;
+			}
+		}
+	}
+	return crc;
+}
+
+// FNV-1a hashes
+
+#define SETTINGS_HASH_START 2166136261UL
+#define SETTINGS_HASH_PRIME 16777619UL
+
+uint32_t addToSettingsHash(uint32_t hash, uint8_t value)
+{
+	return (hash ^ value) * SETTINGS_HASH_PRIME;
+}
+
+// the hash stops at the end of the string or an = so that it can
+// be used on setting commands such as mqttdevicename=Rob
+
+uint32_t hashSettingName(const char *name)
+{
+	uint32_t hash = SETTINGS_HASH_START;
+
+	while (*name && *name != '=')
+	{
+		hash = addToSettingsHash(hash, tolower(*name));
+		name++;
+	}
+
+	return hash;
+}
+
+uint32_t getSettingCollectionSchemaHash(SettingItemCollection *settingCollection)
+{
+	uint32_t hash = SETTINGS_HASH_START;
+
+	for (int settingNo = 0; settingNo < settingCollection->noOfSettings; settingNo++)
+	{
+		SettingItem *item = settingCollection->settings[settingNo];
+
+		for (const char *ch = item->formName; *ch; ch++)
+		{
+			hash = addToSettingsHash(hash, tolower(*ch));
+		}
+		hash = addToSettingsHash(hash, 0);
+		hash = addToSettingsHash(hash, item->settingType);
+		hash = addToSettingsHash(hash, item->maxLength & 0xFF);
+		hash = addToSettingsHash(hash, item->maxLength >> 8);
+	}
+
+	return hash;
+}
+
+// returns the number of bytes stored for a fixed size setting, or -1 for strings
+
+int getSettingValueSize(Setting_Type settingType)
+{
+	switch (settingType)
+	{
+	case integerValue:
+		return sizeof(int);
+	case floatValue:
+		return sizeof(float);
+	case doubleValue:
+		return sizeof(double);
+	case yesNo:
+		return sizeof(boolean);
+	case loraKey:
+		return LORA_KEY_LENGTH;
+	case loraID:
+		return sizeof(uint32_t);
+	default:
+		return -1;
+	}
+}
+
+void buildSettingsStoreFilename(SettingItemCollection *settingCollection, char *buffer, int bufferLength)
+{
+	snprintf(buffer, bufferLength, SETTINGS_STORE_FILENAME_FORMAT,
+			 (unsigned long)hashSettingName(settingCollection->collectionName));
+}
+
+// Records are generated twice when a block is saved, once to find the CRC and length
+// and then, if the block has changed, again to write them into the file
+
+File settingsStoreFile;
+bool settingsStoreWriting;
+uint32_t settingsStoreCRC;
+int settingsStoreLength;
+
+void emitSettingsStoreBytes(const uint8_t *bytes, int length)
+{
+	settingsStoreCRC = updateSettingsCRC(settingsStoreCRC, bytes, length);
+	settingsStoreLength = settingsStoreLength + length;
+
+	if (settingsStoreWriting)
+	{
+		settingsStoreFile.write(bytes, length);
+	}
+}
+
+void emitSettingRecord(SettingItem *item)
+{
+	char passwordBuffer[MAX_SETTING_LENGTH + 1];
+	const uint8_t *valueBytes = (const uint8_t *)item->value;
+	int valueLength;
+
+	switch (item->settingType)
+	{
+	case text:
+		valueLength = strlen((char *)item->value);
+		break;
+
+	case password:
+		encryptString(passwordBuffer, MAX_SETTING_LENGTH + 1, (char *)item->value);
+		valueBytes = (const uint8_t *)passwordBuffer;
+		valueLength = strlen(passwordBuffer);
+		break;
+
+	default:
+		valueLength = getSettingValueSize(item->settingType);
+		if (valueLength < 0)
+		{
+			// unknown type - store it empty
+			valueLength = 0;
+		}
+	}
+
+	uint32_t nameHash = hashSettingName(item->formName);
+
+	uint8_t recordHeader[SETTINGS_STORE_RECORD_HEADER_SIZE];
+	recordHeader[0] = nameHash & 0xFF;
+	recordHeader[1] = (nameHash >> 8) & 0xFF;
+	recordHeader[2] = (nameHash >> 16) & 0xFF;
+	recordHeader[3] = (nameHash >> 24) & 0xFF;
+	recordHeader[4] = item->settingType;
+	recordHeader[5] = valueLength & 0xFF;
+	recordHeader[6] = (valueLength >> 8) & 0xFF;
+
+	emitSettingsStoreBytes(recordHeader, SETTINGS_STORE_RECORD_HEADER_SIZE);
+	emitSettingsStoreBytes(valueBytes, valueLength);
+}
+
+void emitSettingCollectionRecords(SettingItemCollection *settingCollection, bool writing)
+{
+	settingsStoreWriting = writing;
+	settingsStoreCRC = 0xFFFFFFFF;
+	settingsStoreLength = 0;
+
+	for (int settingNo = 0; settingNo < settingCollection->noOfSettings; settingNo++)
+	{
+		emitSettingRecord(settingCollection->settings[settingNo]);
+	}
+
+	settingsStoreCRC = settingsStoreCRC ^ 0xFFFFFFFF;
+}
+
+// returns true if the collection had changed and was written
+
+bool saveSettingCollectionToStore(SettingItemCollection *settingCollection)
+{
+	emitSettingCollectionRecords(settingCollection, false);
+
+	if (settingsStoreCRC == settingCollection->storedCRC)
+	{
+		// nothing has changed since the block was last stored
+		return false;
+	}
+
+	char filename[SETTINGS_STORE_FILENAME_LENGTH];
+	buildSettingsStoreFilename(settingCollection, filename, SETTINGS_STORE_FILENAME_LENGTH);
+
+	TRACE("  Storing setting collection: ");
+	TRACE(settingCollection->collectionName);
+	TRACE(" in ");
+	TRACELN(filename);
+
+	struct settingsStoreHeader header;
+	header.magic = SETTINGS_STORE_MAGIC;
+	header.version = SETTINGS_STORE_VERSION;
+	header.payloadLength = settingsStoreLength;
+	header.schemaHash = getSettingCollectionSchemaHash(settingCollection);
+	header.crc = settingsStoreCRC;
+
+	settingsStoreFile = LittleFS.open(filename, "w");
+
+	if (!settingsStoreFile)
+	{
+		Serial.printf("Settings store open failed for %s\n", settingCollection->collectionName);
+		return false;
+	}
+
+	settingsStoreFile.write((uint8_t *)&header, sizeof(struct settingsStoreHeader));
+	emitSettingCollectionRecords(settingCollection, true);
+	settingsStoreFile.close();
+
+	settingCollection->storedCRC = header.crc;
+	settingsStoreBlocksWritten++;
+	settingsStoreBytesWritten = settingsStoreBytesWritten + sizeof(struct settingsStoreHeader) + header.payloadLength;
+
+	return true;
+}
+
+int settingsStoreBlockCount;
+
+void saveSettingCollectionAndCount(SettingItemCollection *settingCollection)
+{
+	if (saveSettingCollectionToStore(settingCollection))
+	{
+		settingsStoreBlockCount++;
+	}
+}
+
+// returns the number of collections that were written
+
+int saveAllSettingsToStore()
+{
+	TRACELN("Saving settings to the store");
+	settingsStoreBlockCount = 0;
+	iterateThroughSensorSettingCollections(saveSettingCollectionAndCount);
+	iterateThroughProcessSettingCollections(saveSettingCollectionAndCount);
+	return settingsStoreBlockCount;
+}
+
+void applySettingValue(SettingItem *item, char *value, int length)
+{
+	switch (item->settingType)
+	{
+	case text:
+		if (length >= item->maxLength)
+		{
+			return;
+		}
+		memcpy(item->value, value, length);
+		((char *)item->value)[length] = 0;
+		break;
+
+	case password:
+		value[length] = 0;
+		decryptString((char *)item->value, item->maxLength, value);
+		break;
+
+	default:
+		if (length != getSettingValueSize(item->settingType))
+		{
+			return;
+		}
+		memcpy(item->value, value, length);
+	}
+}
+
+SettingItem *findSettingInCollectionByHash(SettingItemCollection *settingCollection, uint32_t nameHash)
+{
+	for (int settingNo = 0; settingNo < settingCollection->noOfSettings; settingNo++)
+	{
+		SettingItem *item = settingCollection->settings[settingNo];
+		if (hashSettingName(item->formName) == nameHash)
+		{
+			return item;
+		}
+	}
+	return NULL;
+}
+
+#define SETTINGS_STORE_READ_CHUNK 32
+
+bool loadSettingCollectionFromStore(SettingItemCollection *settingCollection)
+{
+	char filename[SETTINGS_STORE_FILENAME_LENGTH];
+	buildSettingsStoreFilename(settingCollection, filename, SETTINGS_STORE_FILENAME_LENGTH);
+
+	if (!LittleFS.exists(filename))
+	{
+		return false;
+	}
+
+	File blockFile = LittleFS.open(filename, "r");
+
+	if (!blockFile)
+	{
+		return false;
+	}
+
+	struct settingsStoreHeader header;
+
+	if (blockFile.read((uint8_t *)&header, sizeof(struct settingsStoreHeader)) != sizeof(struct settingsStoreHeader) ||
+		header.magic != SETTINGS_STORE_MAGIC ||
+		header.version != SETTINGS_STORE_VERSION ||
+		blockFile.size() != sizeof(struct settingsStoreHeader) + header.payloadLength)
+	{
+		Serial.printf("Settings store block for %s invalid\n", settingCollection->collectionName);
+		blockFile.close();
+		return false;
+	}
+
+	// check the CRC before we change any settings
+
+	uint8_t chunk[SETTINGS_STORE_READ_CHUNK];
+	uint32_t crc = 0xFFFFFFFF;
+	int remaining = header.payloadLength;
+
+	while (remaining > 0)
+	{
+		int chunkLength = remaining > SETTINGS_STORE_READ_CHUNK ? SETTINGS_STORE_READ_CHUNK : remaining;
+		if (blockFile.read(chunk, chunkLength) != (size_t)chunkLength)
+		{
+			break;
+		}
+		crc = updateSettingsCRC(crc, chunk, chunkLength);
+		remaining = remaining - chunkLength;
+	}
+
+	if (remaining != 0 || (crc ^ 0xFFFFFFFF) != header.crc)
+	{
+		Serial.printf("Settings store block for %s failed CRC\n", settingCollection->collectionName);
+		blockFile.close();
+		return false;
+	}
+
+	blockFile.seek(sizeof(struct settingsStoreHeader));
+
+	// if the schema is unchanged the records are in the same order as the settings
+
+	bool schemaMatches = header.schemaHash == getSettingCollectionSchemaHash(settingCollection);
+
+	char valueBuffer[MAX_SETTING_LENGTH + 1];
+	uint8_t recordHeader[SETTINGS_STORE_RECORD_HEADER_SIZE];
+	int settingNo = 0;
+	remaining = header.payloadLength;
+
+	while (remaining >= SETTINGS_STORE_RECORD_HEADER_SIZE)
+	{
+		blockFile.read(recordHeader, SETTINGS_STORE_RECORD_HEADER_SIZE);
+
+		uint32_t nameHash = recordHeader[0] | (recordHeader[1] << 8) |
+							((uint32_t)recordHeader[2] << 16) | ((uint32_t)recordHeader[3] << 24);
+		Setting_Type settingType = (Setting_Type)recordHeader[4];
+		int valueLength = recordHeader[5] | (recordHeader[6] << 8);
+
+		remaining = remaining - SETTINGS_STORE_RECORD_HEADER_SIZE - valueLength;
+
+		if (valueLength > MAX_SETTING_LENGTH || remaining < 0)
+		{
+			break;
+		}
+
+		blockFile.read((uint8_t *)valueBuffer, valueLength);
+
+		SettingItem *item = NULL;
+
+		if (schemaMatches && settingNo < settingCollection->noOfSettings)
+		{
+			item = settingCollection->settings[settingNo];
+		}
+		else
+		{
+			item = findSettingInCollectionByHash(settingCollection, nameHash);
+		}
+
+		if (item != NULL && item->settingType == settingType)
+		{
+			applySettingValue(item, valueBuffer, valueLength);
+		}
+
+		settingNo++;
+	}
+
+	blockFile.close();
+
+	// if the schema has changed the block will be rewritten at the next save
+	if (schemaMatches)
+	{
+		settingCollection->storedCRC = header.crc;
+	}
+	else
+	{
+		settingCollection->storedCRC = 0;
+	}
+
+	return true;
+}
+
+void loadSettingCollectionAndCount(SettingItemCollection *settingCollection)
+{
+	if (loadSettingCollectionFromStore(settingCollection))
+	{
+		settingsStoreBlockCount++;
+	}
+}
+
+// returns the number of collections that were loaded
+
+int loadAllSettingsFromStore()
+{
+	TRACELN("Loading settings from the store");
+	settingsStoreBlockCount = 0;
+	iterateThroughSensorSettingCollections(loadSettingCollectionAndCount);
+	iterateThroughProcessSettingCollections(loadSettingCollectionAndCount);
+	return settingsStoreBlockCount;
+}
+
+void markSettingCollectionDirty(SettingItemCollection *settingCollection)
+{
+	settingCollection->storedCRC = 0;
+}
+
+// forces every collection to be written at the next save, for example after the file system is formatted
+
+void markAllSettingsDirty()
+{
+	iterateThroughSensorSettingCollections(markSettingCollectionDirty);
+	iterateThroughProcessSettingCollections(markSettingCollectionDirty);
+}
+
+// Write behind
+
+unsigned long settingsSaveRequests = 0;
+unsigned long settingsFlushes = 0;
+unsigned long firstSaveRequestMillis;
+unsigned long lastSaveRequestMillis;
+
+void scheduleSettingsFlush()
+{
+	unsigned long quietEndMillis = lastSaveRequestMillis + SETTINGS_SAVE_QUIET_MILLIS;
+	unsigned long latestMillis = firstSaveRequestMillis + SETTINGS_SAVE_MAX_DELAY_MILLIS;
+
+	if (millisReached(latestMillis, quietEndMillis))
+	{
+		scheduleProcessAt(&settingsStoreProcess, latestMillis);
+	}
+	else
+	{
+		scheduleProcessAt(&settingsStoreProcess, quietEndMillis);
+	}
+}
+
+void requestSettingsSave()
+{
+	unsigned long now = millis();
+
+	settingsSaveRequests++;
+
+	if (settingsStoreProcess.status != SETTINGS_STORE_SAVE_PENDING)
+	{
+		firstSaveRequestMillis = now;
+		settingsStoreProcess.status = SETTINGS_STORE_SAVE_PENDING;
+	}
+
+	lastSaveRequestMillis = now;
+	scheduleSettingsFlush();
+}
+
+// writes any pending changes straight away - call this before a restart
+
+void flushSettings()
+{
+	if (settingsStoreProcess.status != SETTINGS_STORE_SAVE_PENDING)
+	{
+		return;
+	}
+
+	settingsStoreProcess.status = SETTINGS_STORE_OK;
+	settingsFlushes++;
+	saveAllSettingsToStore();
+	setProcessEventDriven(&settingsStoreProcess);
+}
+
+void initSettingsStore()
+{
+	if (settingsStoreProcess.status != SETTINGS_STORE_SAVE_PENDING)
+	{
+		settingsStoreProcess.status = SETTINGS_STORE_OK;
+		setProcessEventDriven(&settingsStoreProcess);
+	}
+}
+
+void startSettingsStore()
+{
+}
+
+void updateSettingsStore()
+{
+	if (settingsStoreProcess.status != SETTINGS_STORE_SAVE_PENDING)
+	{
+		return;
+	}
+
+	unsigned long now = millis();
+
+	if (ulongDiff(now, lastSaveRequestMillis) >= SETTINGS_SAVE_QUIET_MILLIS ||
+		ulongDiff(now, firstSaveRequestMillis) >= SETTINGS_SAVE_MAX_DELAY_MILLIS)
+	{
+		flushSettings();
+		return;
+	}
+
+	scheduleSettingsFlush();
+}
+
+void stopSettingsStore()
+{
+	flushSettings();
+}
+
+bool settingsStoreStatusOK()
+{
+	return true;
+}
+
+void settingsStoreStatusMessage(char *buffer, int bufferLength)
+{
+	snprintf(buffer, bufferLength, "Settings save requests:%lu flushes:%lu blocks written:%lu bytes written:%lu%s",
+			 settingsSaveRequests, settingsFlushes, settingsStoreBlocksWritten, settingsStoreBytesWritten,
+			 settingsStoreProcess.status == SETTINGS_STORE_SAVE_PENDING ? " (save pending)" : "");
+}
+
+struct process settingsStoreProcess = {
+	"settingsstore",
+	initSettingsStore,
+	startSettingsStore,
+	updateSettingsStore,
+	stopSettingsStore,
+	settingsStoreStatusOK,
+	settingsStoreStatusMessage,
+	false,
+	0,
+	0,
+	0,
+	NULL,
+	NULL, 0, NULL, // no settings
+	NULL,		   // no commands
+	BOOT_PROCESS + ACTIVE_PROCESS + CONFIG_PROCESS + WIFI_CONFIG_PROCESS,
+	NULL,
+	NULL,
+	NULL};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "settings.h"
+
+// Binary settings store
+// Each setting collection is held in its own file so that only collections
+// which have changed are rewritten. A file holds a header followed by one
+// record per setting:
+//     uint32 hash of the lower case formName
+//     uint8  Setting_Type
+//     uint16 length of the value in bytes
+//     the value bytes (text without a terminator, passwords encrypted)
+// All values are little endian.
+
+#define SETTINGS_STORE_MAGIC 0x53424C43 // "CLBS"
+#define SETTINGS_STORE_VERSION 1
+
+#define SETTINGS_STORE_FILENAME_FORMAT "/set_%08lx.bin"
+#define SETTINGS_STORE_FILENAME_LENGTH 20
+
+#define SETTINGS_MIGRATED_FILENAME "/Settings.old"
+
+#define SETTINGS_STORE_RECORD_HEADER_SIZE 7
+
+// saveSettings only requests a save, the settings store process writes the
+// changed collections once there have been no more requests for the quiet
+// period, or when the oldest request reaches the maximum delay
+
+#define SETTINGS_SAVE_QUIET_MILLIS 2000
+#define SETTINGS_SAVE_MAX_DELAY_MILLIS 10000
+
+#define SETTINGS_STORE_OK 1600
+#define SETTINGS_STORE_SAVE_PENDING 1601
+
+extern struct process settingsStoreProcess;
+
+struct settingsStoreHeader
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t payloadLength;
+	uint32_t schemaHash; // changes when settings are added, removed or altered
+	uint32_t crc;		 // CRC32 of the payload
+};
+
+extern unsigned long settingsStoreBlocksWritten;
+extern unsigned long settingsStoreBytesWritten;
+extern unsigned long settingsSaveRequests;
+extern unsigned long settingsFlushes;
+
+uint32_t hashSettingName(const char *name);
+uint32_t updateSettingsCRC(uint32_t crc, const uint8_t *bytes, int length);
+uint32_t getSettingCollectionSchemaHash(SettingItemCollection *settingCollection);
+
+bool saveSettingCollectionToStore(SettingItemCollection *settingCollection);
+int saveAllSettingsToStore();
+
+bool loadSettingCollectionFromStore(SettingItemCollection *settingCollection);
+int loadAllSettingsFromStore();
+
+void markAllSettingsDirty();
+
+void requestSettingsSave();
+void flushSettings();
+void settingsStoreStatusMessage(char *buffer, int bufferLength);
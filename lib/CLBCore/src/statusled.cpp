@@ -104,6 +104,8 @@ void startstatusLedFlash(int flashLength)
     millisAtLastFlash = millis();
 
     flashDurationInMillis = flashLength;
+
+    wakeProcess(&statusLedProcess);
 }
 
 void updateStatusLedFlash()
@@ -111,6 +113,8 @@ void updateStatusLedFlash()
     if (flashDurationInMillis == 0)
     {
         statusLedOff();
+        // stays off until the next flash is set
+        setProcessEventDriven(&statusLedProcess);
         return;
     }
 
@@ -118,6 +122,9 @@ void updateStatusLedFlash()
 
     if (millisSinceLastFlash > flashDurationInMillis)
         ledToggle();
+
+    // sleep until the next toggle
+    scheduleProcessAt(&statusLedProcess, millisAtLastFlash + flashDurationInMillis + 1);
 }
 
 #define DIGIT_FLASH_INTERVAL 400
@@ -159,6 +166,7 @@ void setFlashLength(int flashLength)
     millisAtLastFlash = millis();
     flashDurationInMillis = flashLength;
     statusLedOn();
+    wakeProcess(&statusLedProcess);
 }
 
 void displayMessageOnStatusLed(int messageNumber, ledFlashBehaviour severity, char *messageText)
@@ -233,6 +241,7 @@ void updateStatusLed()
 {
     if (statusLedProcess.status == STATUS_LED_STOPPED)
     {
+        setProcessEventDriven(&statusLedProcess);
         return ;
     }
 
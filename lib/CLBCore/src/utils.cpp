@@ -43,6 +43,13 @@ unsigned long ulongDiff(unsigned long end, unsigned long start)
     }
 }
 
+// true if now is at or after target, allowing for millis wrap around
+
+bool millisReached(unsigned long target, unsigned long now)
+{
+    return (long)(now - target) >= 0;
+}
+
 bool strContains(char *searchMe, char *findMe)
 {
     while (*searchMe != 0)
@@ -11,6 +11,8 @@ int srtcasecmp(const char *string1, const char *string2);
 
 unsigned long ulongDiff(unsigned long end, unsigned long start);
 
+bool millisReached(unsigned long target, unsigned long now);
+
 bool strContains(char* searchMe,char* findMe);
 
 int getUnalignedInt(unsigned char * source);
@@ -0,0 +1,60 @@
+#include "Animation.h"
+
+void startAnimation(Animation *animation, unsigned long startMillis, int noOfSteps, Easing easing)
+{
+	if (noOfSteps < 0)
+	{
+		noOfSteps = 0;
+	}
+
+	animation->startMillis = startMillis;
+	animation->durationMillis = (unsigned long)noOfSteps * MILLIS_PER_ANIMATION_STEP;
+	animation->easing = easing;
+	animation->active = true;
+}
+
+void stopAnimation(Animation *animation)
+{
+	animation->active = false;
+}
+
+float getAnimationProgress(Animation *animation, unsigned long currentMillis)
+{
+	// unsigned subtraction copes with the millisecond counter wrapping
+	unsigned long elapsedMillis = currentMillis - animation->startMillis;
+
+	if (elapsedMillis >= animation->durationMillis)
+	{
+		animation->active = false;
+		return 1;
+	}
+
+	float t = (float)elapsedMillis / (float)animation->durationMillis;
+
+	return applyEasing(animation->easing, t);
+}
+
+// quadratic easing curves
+
+float applyEasing(Easing easing, float t)
+{
+	switch (easing)
+	{
+	case EASE_IN:
+		return t * t;
+	case EASE_OUT:
+		return t * (2 - t);
+	case EASE_IN_OUT:
+		if (t < 0.5)
+			return 2 * t * t;
+		return -1 + ((4 - (2 * t)) * t);
+	case EASE_LINEAR:
+	default:
+		return t;
+	}
+}
+
+float interpolate(float from, float to, float progress)
+{
+	return from + ((to - from) * progress);
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+// Animations run from a start time for a length of time rather than for a
+// number of frames, so the state is worked out from the time at each update.
+// A slow loop then drops frames without stretching the animation.
+// Lengths are still given in steps, the 50Hz frame steps that the commands
+// have always used, and converted to milliseconds when an animation starts.
+
+#define MILLIS_PER_ANIMATION_STEP 20
+
+enum Easing
+{
+	EASE_LINEAR,
+	EASE_IN,
+	EASE_OUT,
+	EASE_IN_OUT
+};
+
+struct Animation
+{
+	unsigned long startMillis;
+	unsigned long durationMillis;
+	Easing easing;
+	bool active;
+};
+
+void startAnimation(Animation *animation, unsigned long startMillis, int noOfSteps, Easing easing);
+
+void stopAnimation(Animation *animation);
+
+// returns how far through the animation the given time is, from 0 to 1 after
+// easing, and stops the animation once it has run its course
+float getAnimationProgress(Animation *animation, unsigned long currentMillis);
+
+float applyEasing(Easing easing, float t);
+
+float interpolate(float from, float to, float progress);
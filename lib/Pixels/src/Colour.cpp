@@ -4,7 +4,7 @@
 #include <string.h>
 #include <Arduino.h>
 
-struct colourNameLookup colourNames[] = {
+constexpr struct colourNameLookup colourNames[] = {
 { "black",BLACK_COLOUR },
 { "red",RED_COLOUR },
 { "green",GREEN_COLOUR },
@@ -136,7 +136,7 @@ struct colourNameLookup colourNames[] = {
 //{ "whitesmoke",WHITE_SMOKE_COLOUR }
 };
 
-struct colourCharLookup colourChars[] = {
+constexpr struct colourCharLookup colourChars[] = {
 { 'K',BLACK_COLOUR },
 { 'R',RED_COLOUR },
 { 'G',GREEN_COLOUR },
@@ -152,47 +152,246 @@ struct colourCharLookup colourChars[] = {
 { 'T',TEAL_COLOUR }
 };
 
-int noOfColours = sizeof(colourNames)/sizeof(struct colourNameLookup);
+#define NO_OF_COLOUR_NAMES (int)(sizeof(colourNames) / sizeof(struct colourNameLookup))
+#define NO_OF_COLOUR_CHARS (int)(sizeof(colourChars) / sizeof(struct colourCharLookup))
 
-struct colourNameLookup *findColourByName(const char *name)
+int noOfColours = NO_OF_COLOUR_NAMES;
+
+// Colour names are found through a perfect hash. Each name is hashed
+// (FNV-1a, ignoring case) from a seed, and the seed is the first one that
+// puts every name in a different slot of the table. The seed and the
+// table are worked out by the compiler, so finding a name is a hash, one
+// table read and one string compare to make sure the name matched. If a
+// new name makes the seed search fail the number of slots needs to go up.
+
+#define COLOUR_NAME_SLOTS 256
+#define COLOUR_NAME_SEED_LIMIT 1024
+#define COLOUR_NAME_NO_SEED COLOUR_NAME_SEED_LIMIT
+
+constexpr char colourNameLowerCase(char ch)
+{
+	return (ch >= 'A' && ch <= 'Z') ? ch + ('a' - 'A') : ch;
+}
+
+constexpr uint32_t colourNameHash(const char *name, uint32_t hash)
 {
-	for (unsigned int i = 0; i < sizeof(colourNames) / sizeof(struct colourNameLookup); i++)
+	return *name == 0 ? hash : colourNameHash(name + 1, (hash ^ (uint8_t)colourNameLowerCase(*name)) * 16777619u);
+}
+
+constexpr int colourNameSlot(const char *name, uint32_t seed)
+{
+	return (int)((colourNameHash(name, 2166136261u ^ (seed * 0x9E3779B9u)) >> 8) % COLOUR_NAME_SLOTS);
+}
+
+// true if no name after name i shares its slot
+
+constexpr bool colourNameSlotUnique(uint32_t seed, int i, int j)
+{
+	return j >= NO_OF_COLOUR_NAMES ||
+		   (colourNameSlot(colourNames[i].name, seed) != colourNameSlot(colourNames[j].name, seed) &&
+			colourNameSlotUnique(seed, i, j + 1));
+}
+
+constexpr bool colourNameSeedWorks(uint32_t seed, int i)
+{
+	return i >= NO_OF_COLOUR_NAMES ||
+		   (colourNameSlotUnique(seed, i, i + 1) && colourNameSeedWorks(seed, i + 1));
+}
+
+// searches the seeds from low to high, splitting the range in half each
+// time to keep the compiler's recursion shallow
+
+constexpr uint32_t findColourNameSeed(uint32_t low, uint32_t high);
+
+constexpr uint32_t pickColourNameSeed(uint32_t lowerSeed, uint32_t middle, uint32_t high)
+{
+	return lowerSeed != COLOUR_NAME_NO_SEED ? lowerSeed : findColourNameSeed(middle + 1, high);
+}
+
+constexpr uint32_t findColourNameSeed(uint32_t low, uint32_t high)
+{
+	return low == high ? (colourNameSeedWorks(low, 0) ? low : COLOUR_NAME_NO_SEED)
+					   : pickColourNameSeed(findColourNameSeed(low, (low + high) / 2), (low + high) / 2, high);
+}
+
+constexpr uint32_t colourNameSeed = findColourNameSeed(0, COLOUR_NAME_SEED_LIMIT - 1);
+
+static_assert(colourNameSeed != COLOUR_NAME_NO_SEED, "no perfect hash seed for the colour names");
+
+constexpr int8_t findColourNameInSlot(int slot, int i)
+{
+	return i >= NO_OF_COLOUR_NAMES ? -1 : colourNameSlot(colourNames[i].name, colourNameSeed) == slot ? i : findColourNameInSlot(slot, i + 1);
+}
+
+constexpr int8_t findColourCharCode(int ch, int i)
+{
+	return i >= NO_OF_COLOUR_CHARS ? -1 : colourChars[i].ch == ch ? i : findColourCharCode(ch, i + 1);
+}
+
+#define COLOUR_SLOTS4(f, n) f(n), f(n + 1), f(n + 2), f(n + 3)
+#define COLOUR_SLOTS16(f, n) COLOUR_SLOTS4(f, n), COLOUR_SLOTS4(f, n + 4), COLOUR_SLOTS4(f, n + 8), COLOUR_SLOTS4(f, n + 12)
+#define COLOUR_SLOTS64(f, n) COLOUR_SLOTS16(f, n), COLOUR_SLOTS16(f, n + 16), COLOUR_SLOTS16(f, n + 32), COLOUR_SLOTS16(f, n + 48)
+
+#define COLOUR_NAME_SLOT(n) findColourNameInSlot(n, 0)
+#define COLOUR_CHAR_CODE(n) findColourCharCode(n, 0)
+
+// offset in colourNames of the name in each slot, -1 for an empty slot
+
+constexpr int8_t colourNameSlots[COLOUR_NAME_SLOTS] = {
+	COLOUR_SLOTS64(COLOUR_NAME_SLOT, 0),
+	COLOUR_SLOTS64(COLOUR_NAME_SLOT, 64),
+	COLOUR_SLOTS64(COLOUR_NAME_SLOT, 128),
+	COLOUR_SLOTS64(COLOUR_NAME_SLOT, 192)};
+
+// offset in colourChars of each 7 bit character, -1 if it isn't a colour
+
+constexpr int8_t colourCharCodes[128] = {
+	COLOUR_SLOTS64(COLOUR_CHAR_CODE, 0),
+	COLOUR_SLOTS64(COLOUR_CHAR_CODE, 64)};
+
+const struct colourNameLookup *findColourByName(const char *name)
+{
+	int pos = colourNameSlots[colourNameSlot(name, colourNameSeed)];
+
+	if (pos < 0 || strcasecmp(name, colourNames[pos].name) != 0)
 	{
-		if (strcasecmp(name, colourNames[i].name) == 0)
-		{
-			return &colourNames[i];
-		}
+		return NULL;
 	}
-	return NULL;
+
+	return &colourNames[pos];
+}
+
+const struct colourCharLookup *findColourByChar(const char ch)
+{
+	if ((uint8_t)ch >= 128)
+	{
+		return NULL;
+	}
+
+	int pos = colourCharCodes[(uint8_t)ch];
+
+	if (pos < 0)
+	{
+		return NULL;
+	}
+
+	return &colourChars[pos];
 }
 
-struct colourCharLookup *findColourByChar(const char ch)
+void clearColourMask(ColourMask *mask)
 {
-	for (unsigned int i = 0; i < sizeof(colourChars) / sizeof(struct colourCharLookup); i++)
+	mask->source[0] = 0;
+	mask->length = 0;
+	mask->valid = true;
+	mask->allColours = false;
+}
+
+// returns true if every character in the source is a colour, * or +.
+// Anything else is compiled as + so that patterns skip over it
+
+bool compileColourMask(ColourMask *mask, const char *source)
+{
+	if (strcmp(mask->source, source) == 0)
+	{
+		return mask->valid;
+	}
+
+	int length = strlen(source);
+
+	if (length > MAX_COLOUR_MASK_LENGTH)
+	{
+		clearColourMask(mask);
+		mask->valid = false;
+		return false;
+	}
+
+	strcpy(mask->source, source);
+	mask->length = length;
+	mask->valid = true;
+	mask->allColours = length > 0;
+
+	for (int i = 0; i < length; i++)
 	{
-		if (colourChars[i].ch == ch)
+		switch (source[i])
+		{
+		case '*':
+			mask->entries[i] = COLOUR_MASK_RANDOM;
+			mask->allColours = false;
+			break;
+
+		case '+':
+			mask->entries[i] = COLOUR_MASK_KEEP;
+			mask->allColours = false;
+			break;
+
+		default:
 		{
-			return &colourChars[i];
+			const struct colourCharLookup *colour = findColourByChar(source[i]);
+
+			if (colour == NULL)
+			{
+				mask->entries[i] = COLOUR_MASK_KEEP;
+				mask->valid = false;
+				mask->allColours = false;
+			}
+			else
+			{
+				mask->entries[i] = colour - colourChars;
+			}
+			break;
+		}
 		}
 	}
-	return NULL;
+
+	return mask->valid;
+}
+
+uint16_t floatToFixedColour(float value)
+{
+	if (value <= 0)
+		return 0;
+
+	if (value >= 1)
+		return FIXED_COLOUR_ONE;
+
+	return (uint16_t)((value * FIXED_COLOUR_ONE) + 0.5);
+}
+
+uint32_t floatToFixedFraction(float value)
+{
+	if (value <= 0)
+		return 0;
+
+	if (value >= 1)
+		return FIXED_FRACTION_ONE;
+
+	return (uint32_t)((value * FIXED_FRACTION_ONE) + 0.5);
+}
+
+void colourToFixed(Colour *source, FixedColour *dest)
+{
+	dest->Red = floatToFixedColour(source->Red);
+	dest->Green = floatToFixedColour(source->Green);
+	dest->Blue = floatToFixedColour(source->Blue);
 }
 
 int localRand(int low, int high);
 
-struct colourNameLookup *findRandomColour()
+const struct colourNameLookup *findRandomColour()
 {
 	// never picks black - which is at location 0 in the array
-	int pos = localRand(1, sizeof(colourNames) / sizeof(struct colourNameLookup));
+	int pos = localRand(1, NO_OF_COLOUR_NAMES);
 	return &colourNames[pos];
 }
 
-void getColourInbetweenMask(char lowChar, char highChar, float distance, Colour * result)
+// mixes the colour at lowPos in a mask with the one after it. The mask
+// must hold only colours
+
+void getColourInbetweenMask(ColourMask *mask, int lowPos, float distance, Colour *result)
 {
-	struct Colour from = findColourByChar(lowChar)->col;
-	struct Colour to = findColourByChar(highChar)->col;
-	result->Red = from.Red + (to.Red - from.Red * distance);
-	result->Green = from.Green + (to.Green - from.Green * distance);
-	result->Blue = from.Blue + (to.Blue - from.Blue * distance);
+	Colour from = colourChars[mask->entries[lowPos]].col;
+	Colour to = colourChars[mask->entries[lowPos + 1]].col;
+	result->Red = from.Red + ((to.Red - from.Red) * distance);
+	result->Green = from.Green + ((to.Green - from.Green) * distance);
+	result->Blue = from.Blue + ((to.Blue - from.Blue) * distance);
 }
-
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdint.h>
+
 #define BLACK_COLOUR {0,0,0}
 #define RED_COLOUR {1,0,0}
 #define GREEN_COLOUR {0,1,0}
@@ -138,6 +140,25 @@ struct Colour
 	float Blue;
 };
 
+// Fixed point colours are held as Q8.8 values. The top byte of each channel
+// is the value sent to the pixel, so 0xFF00 is full intensity and converting
+// for display is a round and a shift. Fractions (brightness, opacity and
+// distance factors) are Q16, with 0x10000 standing for 1.
+
+#define FIXED_COLOUR_ONE 0xFF00
+#define FIXED_FRACTION_ONE 0x10000
+
+struct FixedColour
+{
+	uint16_t Red;
+	uint16_t Green;
+	uint16_t Blue;
+};
+
+uint16_t floatToFixedColour(float value);
+uint32_t floatToFixedFraction(float value);
+void colourToFixed(Colour *source, FixedColour *dest);
+
 struct colourNameLookup{
 	const char * name;
 	Colour col;
@@ -148,11 +169,37 @@ struct colourCharLookup{
 	Colour col;
 };
 
-extern struct colourNameLookup colourNames[];
+// The colour tables are built at compile time along with the tables that
+// find the entries in them, so they can't be changed while running
 
-struct colourNameLookup *findRandomColour();
+extern const struct colourNameLookup colourNames[];
+extern const struct colourCharLookup colourChars[];
+
+const struct colourNameLookup *findRandomColour();
+
+const struct colourCharLookup *findColourByChar(const char ch);
+const struct colourNameLookup *findColourByName(const char *name);
+
+// A colour mask is a string of colour characters, with * for a random
+// colour and + to leave a colour alone. It is compiled into the offset of
+// each colour in colourChars so that applying it doesn't need the
+// characters to be looked up again. The source is kept so that a mask
+// that is used again isn't compiled again.
+
+#define MAX_COLOUR_MASK_LENGTH 20
+#define COLOUR_MASK_RANDOM -1
+#define COLOUR_MASK_KEEP -2
+
+struct ColourMask
+{
+	char source[MAX_COLOUR_MASK_LENGTH + 1];
+	int length;
+	bool valid;
+	bool allColours;
+	int8_t entries[MAX_COLOUR_MASK_LENGTH];
+};
 
-struct colourCharLookup *findColourByChar(const char ch);
-struct colourNameLookup *findColourByName(const char *name);
-void getColourInbetweenMask(char lowChar, char highChar, float distance, Colour * result);
+void clearColourMask(ColourMask *mask);
+bool compileColourMask(ColourMask *mask, const char *source);
+void getColourInbetweenMask(ColourMask *mask, int lowPos, float distance, Colour *result);
 
@@ -3,7 +3,9 @@
 #include "Frame.h"
 #include <math.h>
 
-Frame::Frame(Leds *inLeds, Colour inBackground)
+int localRand(int low, int high);
+
+Frame::Frame(Leds *inLeds, Colour inBackground, int inNoOfSprites)
 {
 	leds = inLeds;
 
@@ -11,26 +13,83 @@ Frame::Frame(Leds *inLeds, Colour inBackground)
 	height = inLeds->ledHeight;
 	noOfPixels = width * height;
 	overlayActive=false;
+	statusActive = false;
+	noOfStatusItems = 0;
 
 	background = inBackground;
-	noOfBrightnessSteps = 0;
 	brightness = 0;
+	targetBrightness = 0;
+	renderedBrightness = 0;
+	stopAnimation(&brightnessAnimation);
+	animationMillis = millis();
+
+	changed = true;
+	framesRendered = 0;
+	framesSkipped = 0;
+	framesDithered = 0;
+
+	clearColourMask(&patternMask);
 
-	for (int i = 0; i < MAX_NO_OF_SPRITES; i++)
+	noOfSprites = inNoOfSprites;
+	sprites = new Sprite[noOfSprites];
+	activeSprites = new int[noOfSprites];
+	noOfActiveSprites = 0;
+
+	for (int i = 0; i < noOfSprites; i++)
 	{
-		sprites[i] = new Sprite(this);
+		sprites[i].frame = this;
+		sprites[i].poolIndex = i;
 	}
 }
 
+Frame::~Frame()
+{
+	delete[] sprites;
+	delete[] activeSprites;
+}
+
+int Frame::getSpritePoolSize(int noOfPixels)
+{
+	if (noOfPixels < MIN_NO_OF_SPRITES)
+		return MIN_NO_OF_SPRITES;
+
+	if (noOfPixels > MAX_NO_OF_SPRITES)
+		return MAX_NO_OF_SPRITES;
+
+	return noOfPixels;
+}
+
 Sprite *Frame::getSprite(int spriteNo)
 {
 
-	if (spriteNo >= MAX_NO_OF_SPRITES || spriteNo < 0)
+	if (spriteNo >= noOfSprites || spriteNo < 0)
 	{
 		return NULL;
 	}
 
-	return sprites[spriteNo];
+	return &sprites[spriteNo];
+}
+
+void Frame::activateSprite(Sprite *sprite)
+{
+	sprite->activeSlot = noOfActiveSprites;
+	activeSprites[noOfActiveSprites] = sprite->poolIndex;
+	noOfActiveSprites++;
+	changed = true;
+}
+
+// the last sprite in the list takes the place of the one removed
+
+void Frame::deactivateSprite(Sprite *sprite)
+{
+	noOfActiveSprites--;
+
+	int lastIndex = activeSprites[noOfActiveSprites];
+	activeSprites[sprite->activeSlot] = lastIndex;
+	sprites[lastIndex].activeSlot = sprite->activeSlot;
+
+	sprite->activeSlot = -1;
+	changed = true;
 }
 
 void Frame::overlayColour(Colour col, int timeMins)
@@ -38,62 +97,155 @@ void Frame::overlayColour(Colour col, int timeMins)
 	overlay = col;
 	overlayActive = true;
 	overlayEndTicks = millis() + ((60 * timeMins)*1000);
+	changed = true;
+}
+
+void Frame::showStatus(const Colour *colours, int noOfItems, Colour inBackground, unsigned long timeMillis)
+{
+	statusColours = colours;
+	noOfStatusItems = noOfItems;
+	statusBackground = inBackground;
+	statusStartMillis = millis();
+	statusMillis = timeMillis;
+	statusActive = true;
+	changed = true;
+}
+
+void Frame::markChanged()
+{
+	changed = true;
 }
 
 void Frame::render()
 {
+	if (statusActive)
+	{
+		// the status is always shown at full brightness
+		leds->clear(statusBackground);
+
+		for (int i = 0; i < noOfStatusItems && i < noOfPixels; i++)
+		{
+			leds->setLedColour(i, statusColours[i]);
+		}
+
+		renderedBrightness = 1;
+		leds->display(renderedBrightness);
+
+		changed = false;
+		framesRendered++;
+		return;
+	}
+
 	leds->clear(background);
 
 	if(overlayActive){
-		for (int i = 0; i < MAX_NO_OF_SPRITES; i++)
+		for (int i = 0; i < noOfActiveSprites; i++)
 		{
-			sprites[i]->renderColour(overlay);
+			sprites[activeSprites[i]].renderColour(overlay);
 		}
 	}
 	else {
-		for (int i = 0; i < MAX_NO_OF_SPRITES; i++)
+		for (int i = 0; i < noOfActiveSprites; i++)
+		{
+			sprites[activeSprites[i]].render();
+		}
+	}
+	renderedBrightness = brightness;
+	leds->display(renderedBrightness);
+
+	changed = false;
+	framesRendered++;
+}
+
+// skips the render, and the show which goes with it, when nothing has
+// changed since the last frame was sent to the pixels
+
+bool Frame::renderIfChanged()
+{
+	if (!changed)
+	{
+		if (leds->ditherPending)
 		{
-			sprites[i]->render();
+			// the led colours are unchanged, just show them again to
+			// move the dither on
+			leds->display(renderedBrightness);
+			framesDithered++;
+			return true;
 		}
+
+		framesSkipped++;
+		return false;
 	}
-	leds->display(brightness);
+
+	render();
+	return true;
 }
 
 void Frame::dump()
 {
 
 	Serial.println("\nFrame");
-	Serial.printf("Width:%d Height:%d brightness:%f brightness change:%f brightnessSteps:%d\n",
-	width, height, brightness, brightnessStep, noOfBrightnessSteps);
+	Serial.printf("Width:%d Height:%d brightness:%f target brightness:%f fading:%d\n",
+	width, height, brightness, targetBrightness, brightnessAnimation.active);
 
 	leds->dump();
 
-	for (int i = 0; i < MAX_NO_OF_SPRITES; i++)
+	Serial.printf("Sprites:%d enabled:%d\n", noOfSprites, noOfActiveSprites);
+
+	for (int i = 0; i < noOfActiveSprites; i++)
 	{
-		sprites[i]->dump();
+		sprites[activeSprites[i]].dump();
 	}
 }
 
 void Frame::update()
 {
-	for (int i = 0; i < MAX_NO_OF_SPRITES; i++)
+	update(millis());
+}
+
+// brings everything up to the given time, however long it has been since
+// the last update
+
+void Frame::update(unsigned long currentMillis)
+{
+	animationMillis = currentMillis;
+
+	// work down the list, a sprite which fades out disables itself and is
+	// replaced by the last one in the list, which has already been updated
+	for (int i = noOfActiveSprites - 1; i >= 0; i--)
 	{
-		sprites[i]->update();
+		if (sprites[activeSprites[i]].update(currentMillis))
+		{
+			changed = true;
+		}
 	}
 
-	if (noOfBrightnessSteps != 0)
+	if (brightnessAnimation.active)
 	{
-		brightness += brightnessStep;
-		noOfBrightnessSteps--;
-		if (noOfBrightnessSteps == 0)
+		changed = true;
+		float progress = getAnimationProgress(&brightnessAnimation, currentMillis);
+		brightness = interpolate(startBrightness, targetBrightness, progress);
+		if (!brightnessAnimation.active)
 		{
 			brightness = targetBrightness;
 		}
 	}
 
 	if(overlayActive){
-		if(millis()>overlayEndTicks){
+		if(currentMillis>overlayEndTicks){
 			overlayActive = false;
+			changed = true;
+		}
+	}
+
+	if (statusActive)
+	{
+		// signed so that an update timed just before the status was
+		// started doesn't see it as long finished
+		if ((long)(currentMillis - statusStartMillis) >= (long)statusMillis)
+		{
+			statusActive = false;
+			changed = true;
 		}
 	}
 }
@@ -115,18 +267,20 @@ void Frame::fadeToColour(Colour target, int noOfSteps)
 		noOfSteps = 10;
 	}
 
-	for (int i = 0; i < MAX_NO_OF_SPRITES; i++)
+	for (int i = 0; i < noOfSprites; i++)
 	{
-		sprites[i]->fadeToColour(target, noOfSteps);
+		sprites[i].fadeToColour(target, noOfSteps);
 	}
 }
 
 void Frame::setColour(Colour target)
 {
-	for (int i = 0; i < MAX_NO_OF_SPRITES; i++)
+	for (int i = 0; i < noOfSprites; i++)
 	{
-		sprites[i]->setColour(target);
+		sprites[i].setColour(target);
 	}
+
+	changed = true;
 }
 
 
@@ -147,11 +301,9 @@ void Frame::fadeToBrightness(float inTargetBrightness, int noOfSteps)
 		inTargetBrightness = 1;
 	}
 
-	brightnessStep = (inTargetBrightness - brightness) / noOfSteps;
-
+	startBrightness = brightness;
 	targetBrightness = inTargetBrightness;
-
-	noOfBrightnessSteps = noOfSteps;
+	startAnimation(&brightnessAnimation, animationMillis, noOfSteps, EASE_LINEAR);
 }
 
 void Frame::fadeSpritesToColourCharMask(char *colourMask, int steps)
@@ -163,40 +315,44 @@ void Frame::fadeSpritesToColourCharMask(char *colourMask, int steps)
 
 	disableAllSprites();
 
-	char *pos = colourMask;
+	compileColourMask(&patternMask, colourMask);
+
+	int maskPos = 0;
 	int row = 0, col = 0;
 
 	int pixelLimit;
 
-	if (MAX_NO_OF_SPRITES > noOfPixels)
+	if (noOfSprites > noOfPixels)
 	{
 		pixelLimit = noOfPixels;
 	}
 	else
 	{
-		pixelLimit = MAX_NO_OF_SPRITES;
+		pixelLimit = noOfSprites;
 	}
 
 	for (int i = 0; i < pixelLimit; i++)
 	{
-		Sprite *sprite = sprites[i];
+		Sprite *sprite = &sprites[i];
 
 		float newX = row + 0.5;
 		float newY = col + 0.5;
-		// move to the specified position and then stop
-		sprite->moveToPosition(newX, newY, steps, Sprite::SPRITE_STOPPED);
-		sprite->enabled = true;
+		// glide to the specified position and then stop
+		sprite->moveToPosition(newX, newY, steps, Sprite::SPRITE_STOPPED, EASE_IN_OUT);
+		sprite->enable();
 		sprite->fadeToBrightness(1, steps);
 		sprite->opacity = 1.0;
 
-		setTargetColour(*pos, sprite, steps);
-
-		pos++;
-
-		// loop around the string
-		if (*pos == 0)
+		if (patternMask.length > 0)
 		{
-			pos = colourMask;
+			setTargetColour(patternMask.entries[maskPos], sprite, steps);
+
+			// loop around the mask
+			maskPos++;
+			if (maskPos == patternMask.length)
+			{
+				maskPos = 0;
+			}
 		}
 
 		row++;
@@ -210,10 +366,12 @@ void Frame::fadeSpritesToColourCharMask(char *colourMask, int steps)
 
 void Frame::disableAllSprites()
 {
-	for (int i = 0; i < MAX_NO_OF_SPRITES; i++)
+	while (noOfActiveSprites > 0)
 	{
-		sprites[i]->enabled = false;
+		sprites[activeSprites[noOfActiveSprites - 1]].disable();
 	}
+
+	changed = true;
 }
 
 int Frame::getNumberOfActiveSprites()
@@ -221,39 +379,35 @@ int Frame::getNumberOfActiveSprites()
 	int noOfPixels = width * height;
 
 	if (noOfPixels < 12)
-		return 3;
+		return MIN_NO_OF_SPRITES;
 
-	int activeSprites = (int)round(noOfPixels / 4) + 1;
+	int activeCount = (int)round(noOfPixels / 4) + 1;
 
-	if (activeSprites > MAX_NO_OF_SPRITES)
+	if (activeCount > noOfSprites)
 	{
-		activeSprites = MAX_NO_OF_SPRITES;
+		activeCount = noOfSprites;
 	}
 
-	return activeSprites;
+	return activeCount;
 }
 
-void Frame::setTargetColour(char ch, Sprite *s, int steps)
+void Frame::setTargetColour(int8_t maskEntry, Sprite *s, int steps)
 {
-	switch (ch)
+	switch (maskEntry)
 	{
-	case '*':
+	case COLOUR_MASK_RANDOM:
 		// A colour of * means "set a random colour for this sprite"
 		{
-			struct colourNameLookup *newColour = findRandomColour();
+			const struct colourNameLookup *newColour = findRandomColour();
 			s->fadeToColour(newColour->col, steps);
 		}
 		break;
-	case '+':
+	case COLOUR_MASK_KEEP:
 		// A colour of + means "don't set the colour of this sprite"
 		break;
 	default:
-		// Any other character, look up the colour and use it
-		colourCharLookup *colour = findColourByChar(ch);
-		if (colour != NULL)
-		{
-			s->fadeToColour(colour->col, steps);
-		}
+		// Any other entry is the colour to use
+		s->fadeToColour(colourChars[maskEntry].col, steps);
 		break;
 	}
 }
@@ -265,53 +419,59 @@ void Frame::fadeSpritesToWalkingColours(char *colours, int steps)
 	if (steps < 0)
 		steps = 10;
 
-	char *colourChar = colours;
+	compileColourMask(&patternMask, colours);
+
+	int maskPos = 0;
 
-	int noOfSprites = getNumberOfActiveSprites();
+	int noOfWalkingSprites = getNumberOfActiveSprites();
+
+	changed = true;
 
 	// fade out and disable all the sprites we aren't using
-	for(int i=noOfSprites; i< MAX_NO_OF_SPRITES; i++)
+	for(int i=noOfWalkingSprites; i< noOfSprites; i++)
 	{
-		sprites[i]->fadeToBrightness(0,steps);
+		sprites[i].fadeToBrightness(0,steps);
 	}
 
-	float pixelSpaceBetweenSprites = noOfPixels / noOfSprites;
+	float pixelSpaceBetweenSprites = noOfPixels / noOfWalkingSprites;
 
 	float dist = 0;
 	int x = 0;
 	int y = 0;
 	float minSpeed = 0.005;
 	float maxSpeed = 0.015;
-	float speedStep = (maxSpeed - minSpeed) / (noOfSprites * 2);
+	float speedStep = (maxSpeed - minSpeed) / (noOfWalkingSprites * 2);
 	float speed = minSpeed;
 
-	for (int i = 0; i < noOfSprites; i++)
+	for (int i = 0; i < noOfWalkingSprites; i++)
 	{
-		Sprite *s = sprites[i];
+		Sprite *s = &sprites[i];
 		s->moveToPosition(x + 0.5, y + 0.5, steps, Sprite::SPRITE_WRAP);
 
-		if(random(0,2)==1)
+		if(localRand(0,2)==1)
 			s->xSpeed = speed;
 		else
 			s->xSpeed = -speed;
 		speed = speed + speedStep;
-		if(random(0,2)==1)
+		if(localRand(0,2)==1)
 			s->ySpeed = speed;
 		else
 			s->ySpeed = -speed;
 		speed = speed + speedStep;
-		s->enabled = true;
+		s->enable();
 		
 		s->fadeToBrightness(1,steps);
 		s->opacity = 1;
 
-		setTargetColour(*colourChar, s, steps);
-
-		colourChar++;
-
-		if (!*colourChar)
+		if (patternMask.length > 0)
 		{
-			colourChar = colours;
+			setTargetColour(patternMask.entries[maskPos], s, steps);
+
+			maskPos++;
+			if (maskPos == patternMask.length)
+			{
+				maskPos = 0;
+			}
 		}
 
 		dist = dist + pixelSpaceBetweenSprites;
@@ -328,9 +488,11 @@ void Frame::fadeSpritesToWalkingColours(char *colours, int steps)
 void Frame::fadeSpritesToTwinkle(int steps)
 {
 	int MAX_NO_OF_SPRITESToTwinkle = getNumberOfActiveSprites();
+
+	changed = true;
 	for (int i = 0; i < MAX_NO_OF_SPRITESToTwinkle; i++)
 	{
-		struct colourNameLookup *newColour = findRandomColour();
-		sprites[i]->fadeToColour(newColour->col, steps);
+		const struct colourNameLookup *newColour = findRandomColour();
+		sprites[i].fadeToColour(newColour->col, steps);
 	}
 }
@@ -2,8 +2,18 @@
 
 #include "Led.h"
 #include "Leds.h"
+#include "Animation.h"
 
-#define MAX_NO_OF_SPRITES 20
+// The sprite pool is sized from the number of pixels when the frame is
+// made, one sprite per pixel within these limits
+
+#define MIN_NO_OF_SPRITES 3
+
+#if defined(ARDUINO_ARCH_ESP32)
+#define MAX_NO_OF_SPRITES 100
+#else
+#define MAX_NO_OF_SPRITES 32
+#endif
 
 class Sprite;
 
@@ -18,23 +28,70 @@ public:
 	Colour overlay;
 	unsigned long overlayEndTicks;
 	bool overlayActive;
+
+	// status items are shown over everything else, one colour per led on
+	// the status background, until they have been up for the given time
+	const Colour * statusColours;
+	int noOfStatusItems;
+	Colour statusBackground;
+	unsigned long statusStartMillis;
+	unsigned long statusMillis;
+	bool statusActive;
+
 	Leds * leds;
 	float brightness;
-	float brightnessStep;
-	int noOfBrightnessSteps;
+	float startBrightness;
 	float targetBrightness;
+	Animation brightnessAnimation;
+
+	// brightness the last render sent to the pixels, the dither refresh
+	// must show them at the same level, full brightness for the status
+	float renderedBrightness;
+
+	// time of the most recent update, animations are started from this
+	unsigned long animationMillis;
+
+	// set when anything that shows on the display has changed since the
+	// last render, renderIfChanged leaves the pixels alone otherwise
+	// unless the leds are still dithering, when they are shown again
+	bool changed;
+	unsigned long framesRendered;
+	unsigned long framesSkipped;
+	unsigned long framesDithered;
 
-	Sprite * sprites [MAX_NO_OF_SPRITES];
-	Frame(Leds* inLeds, Colour inBackground); 
+	// the pool of sprites, allocated in one block, and the indices of
+	// the enabled ones which are all that update and render look at
+	Sprite * sprites;
+	int noOfSprites;
+	int * activeSprites;
+	int noOfActiveSprites;
+
+	// the most recent mask or walking colours, kept compiled
+	ColourMask patternMask;
+
+	Frame(Leds* inLeds, Colour inBackground, int inNoOfSprites); 
+	~Frame();
+
+	static int getSpritePoolSize(int noOfPixels);
 
 	Sprite * getSprite(int spriteNo);
 
+	void activateSprite(Sprite * sprite);
+	void deactivateSprite(Sprite * sprite);
+
 	void overlayColour(Colour col, int timeMins);
+	void showStatus(const Colour * colours, int noOfItems, Colour inBackground, unsigned long timeMillis);
 
 	void render();
 
+	bool renderIfChanged();
+
+	void markChanged();
+
 	void update();
 
+	void update(unsigned long currentMillis);
+
 	void dump();
 
 	void disableAllSprites();
@@ -44,7 +101,7 @@ public:
 	void fadeDown(int noOfSteps);
 
 	void fadeToBrightness(float brightness, int steps);
-	void setTargetColour(char ch, Sprite * s, int steps);
+	void setTargetColour(int8_t maskEntry, Sprite * s, int steps);
 	void fadeToColour(Colour target, int steps);
 	void setColour(Colour target);
 	void fadeSpritesToColourCharMask(char * colourMask, int steps);
@@ -11,6 +11,9 @@ void Led::Reset()
 	colour.Red = 0;
 	colour.Green = 0;
 	colour.Blue = 0;
+	fixedColour.Red = 0;
+	fixedColour.Green = 0;
+	fixedColour.Blue = 0;
 }
 
 void Led::AddColour(Colour colour, float fraction) {
@@ -54,6 +57,26 @@ void Led::AddColourValues(float r, float g, float b, float opacity) {
 	colour.Blue = newBlue;
 }
 
+// Fixed point version of AddColourValues. keep is the Q16 fraction of the
+// existing colour to retain, FIXED_FRACTION_ONE for an opacity of 1 which
+// adds the light to what is already there.
+
+void Led::AddFixedColourValues(uint32_t r, uint32_t g, uint32_t b, uint32_t keep)
+{
+	uint32_t newRed = ((fixedColour.Red * keep) >> 16) + r;
+	uint32_t newGreen = ((fixedColour.Green * keep) >> 16) + g;
+	uint32_t newBlue = ((fixedColour.Blue * keep) >> 16) + b;
+
+	if (newRed > FIXED_COLOUR_ONE) newRed = FIXED_COLOUR_ONE;
+	fixedColour.Red = newRed;
+
+	if (newGreen > FIXED_COLOUR_ONE) newGreen = FIXED_COLOUR_ONE;
+	fixedColour.Green = newGreen;
+
+	if (newBlue > FIXED_COLOUR_ONE) newBlue = FIXED_COLOUR_ONE;
+	fixedColour.Blue = newBlue;
+}
+
 void Led::ReplceColour(Colour colour, float fraction) {
 	float newVal;
 	newVal = colour.Red*fraction;
@@ -9,11 +9,13 @@ public:
 	Led();
 
 	Colour colour;
+	FixedColour fixedColour;
 
 	void Reset();
 	void AddColour(Colour colour, float fraction);
 	void AddColourValues(float r, float g, float b, float opacity);
 	void ReplceColour(Colour colour, float fraction);
+	void AddFixedColourValues(uint32_t r, uint32_t g, uint32_t b, uint32_t keep);
 
 
 };
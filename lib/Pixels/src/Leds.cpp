@@ -1,72 +1,146 @@
 #include "Leds.h"
+#include <string.h>
 bool close_to(float a, float b);
 
 Leds::Leds(int inWidth, int inHeight, 
 			void (*inShow)(),
-			void (*inSetPixel)(int no, float r, float g, float b))
+			void (*inSetPixel)(int no, float r, float g, float b),
+			void (*inSetPixelBytes)(int no, uint8_t r, uint8_t g, uint8_t b))
 {
 	ledWidth = inWidth;
 	ledHeight = inHeight;
+	noOfLeds = ledWidth * ledHeight;
 
 	normWidth = 1.0; // width of display is always 1
 	normHeight = (float)ledHeight / (float)ledWidth;
 
 	show = inShow;
 	setPixel = inSetPixel;
+	setPixelBytes = inSetPixelBytes;
+	fixedPoint = true;
+	exactSplat = false;
+	gammaDither = false;
+	ditherPending = false;
 
-	leds = new Led *[ledWidth];
+	outputBuffer = NULL;
+	outputLookup = NULL;
 
-	for (int i = 0; i < ledWidth; i++)
+	leds = new Led[noOfLeds];
+
+	ditherErrors = new uint8_t[noOfLeds * 3];
+	memset(ditherErrors, 0, noOfLeds * 3);
+}
+
+Leds::~Leds()
+{
+	delete[] leds;
+	delete[] ditherErrors;
+}
+
+void Leds::setOutputBuffer(uint8_t *buffer, const int *lookup, int inRedOffset, int inGreenOffset, int inBlueOffset)
+{
+	outputBuffer = buffer;
+	outputLookup = lookup;
+	redOffset = inRedOffset;
+	greenOffset = inGreenOffset;
+	blueOffset = inBlueOffset;
+}
+
+void Leds::display(float brightness)
+{
+	ditherPending = false;
+
+	if (fixedPoint)
+	{
+		displayFixed(brightness);
+	}
+	else
 	{
-		leds[i] = new Led[ledHeight];
+		displayFloat(brightness);
 	}
 }
 
-void Leds::display(float brightness)
+void Leds::clear(Colour colour)
 {
-	int ledNo = 0;
-	for (int y = 0; y < ledHeight; y++)
+	if (fixedPoint)
 	{
-		for (int x = 0; x < ledWidth; x++)
-		{
-			float r = (leds[x][y].colour.Red * brightness);
-			float g = (leds[x][y].colour.Green * brightness);
-			float b = (leds[x][y].colour.Blue * brightness);
-			setPixel(ledNo, r, g, b);
-			ledNo++;
-		}
+		clearFixed(colour);
+	}
+	else
+	{
+		clearFloat(colour);
+	}
+}
+
+void Leds::setLedColour(int ledNo, Colour colour)
+{
+	if (fixedPoint)
+	{
+		colourToFixed(&colour, &leds[ledNo].fixedColour);
+	}
+	else
+	{
+		leds[ledNo].colour = colour;
+	}
+}
+
+void Leds::renderLight(float sourceX, float sourceY, Colour colour, float brightness, float opacity)
+{
+	if (fixedPoint)
+	{
+		renderLightFixed(sourceX, sourceY, colour, brightness, opacity);
+	}
+	else
+	{
+		renderLightFloat(sourceX, sourceY, colour, brightness, opacity);
+	}
+}
+
+void Leds::displayFloat(float brightness)
+{
+	for (int ledNo = 0; ledNo < noOfLeds; ledNo++)
+	{
+		Colour *c = &leds[ledNo].colour;
+		float r = (c->Red * brightness);
+		float g = (c->Green * brightness);
+		float b = (c->Blue * brightness);
+		setPixel(ledNo, r, g, b);
 	}
 	show();
 }
 
-void Leds::clear(Colour colour)
+void Leds::clearFloat(Colour colour)
 {
-	for (int y = 0; y < ledHeight; y++)
+	for (int ledNo = 0; ledNo < noOfLeds; ledNo++)
 	{
-		for (int x = 0; x < ledWidth; x++)
-		{
-			leds[x][y].colour = colour;
-		}
+		leds[ledNo].colour = colour;
 	}
 }
 
 void Leds::dump()
 {
 	Serial.printf("Leds width:%d height:%d\n  ", ledWidth, ledHeight);
-	for (int y = 0; y < ledHeight; y++)
+	for (int ledNo = 0; ledNo < noOfLeds; ledNo++)
 	{
-		for (int x = 0; x < ledWidth; x++)
+		if (fixedPoint)
+		{
+			Serial.printf("     r:%04x g:%04x b:%04x\n",
+						  leds[ledNo].fixedColour.Red,
+						  leds[ledNo].fixedColour.Green,
+						  leds[ledNo].fixedColour.Blue);
+		}
+		else
 		{
 			Serial.printf("     r:%f g:%f b:%f\n",
-						  leds[x][y].colour.Red,
-						  leds[x][y].colour.Green,
-						  leds[x][y].colour.Blue);
+						  leds[ledNo].colour.Red,
+						  leds[ledNo].colour.Green,
+						  leds[ledNo].colour.Blue);
 		}
 	}
 	Serial.println();
 }
 
-void Leds::renderLight(float sourceX, float sourceY, Colour colour, float brightness, float opacity)
+void Leds::renderLightFloat(float sourceX, float sourceY, Colour colour, float brightness, float opacity)
 {
 
 	int intX = int(sourceX);
@@ -132,9 +206,328 @@ void Leds::renderLight(float sourceX, float sourceY, Colour colour, float bright
 				float gs = colour.Green * brightness * factor;
 				float bs = colour.Blue * brightness * factor;
 
-				leds[writeX][writeY].AddColourValues(rs, gs, bs, opacity);
+				getLed(writeX, writeY)->AddColourValues(rs, gs, bs, opacity);
 			}
 		}
 	}
 	return;
 }
+
+// Fixed point pipeline
+// The frame is held as Q8.8 values so that blending is integer multiplies
+// and shifts and the bytes for the pixel come straight from the top of each
+// channel. Only the light positions and distances stay in floating point.
+
+// gamma corrected Q8.8 output levels for each Q8.8 input level top byte,
+// built the first time the display needs it and shared by every Leds.
+// The extra entry at the end lets the top entry be interpolated
+
+uint16_t *gammaTable = NULL;
+
+void buildGammaTable()
+{
+	gammaTable = new uint16_t[GAMMA_TABLE_SIZE];
+
+	for (int i = 0; i < GAMMA_TABLE_SIZE; i++)
+	{
+		float level = (float)i / 255.0;
+
+		if (level > 1)
+		{
+			level = 1;
+		}
+
+		gammaTable[i] = (uint16_t)((pow(level, PIXEL_GAMMA) * FIXED_COLOUR_ONE) + 0.5);
+	}
+}
+
+// converts a Q8.8 level to a pixel byte through the gamma table. Levels
+// that come out dim are dithered using the fraction carried in error,
+// brighter ones are rounded and leave no fraction behind
+
+uint8_t Leds::ditherChannel(uint32_t level, uint8_t *error)
+{
+	uint32_t index = level >> 8;
+	uint32_t low = gammaTable[index];
+	uint32_t output = low + (((gammaTable[index + 1] - low) * (level & 0xFF)) >> 8);
+
+	if ((output >> 8) >= DITHER_LIMIT)
+	{
+		*error = 0;
+		return (uint8_t)((output + 0x80) >> 8);
+	}
+
+	output = output + *error;
+	*error = (uint8_t)(output & 0xFF);
+
+	if (*error != 0)
+	{
+		ditherPending = true;
+	}
+
+	return (uint8_t)(output >> 8);
+}
+
+void Leds::displayFixed(float brightness)
+{
+	uint32_t scale = floatToFixedFraction(brightness);
+
+	if (gammaDither)
+	{
+		if (gammaTable == NULL)
+		{
+			buildGammaTable();
+		}
+
+		uint8_t *error = ditherErrors;
+
+		for (int ledNo = 0; ledNo < noOfLeds; ledNo++)
+		{
+			FixedColour *c = &leds[ledNo].fixedColour;
+			uint8_t r = ditherChannel((c->Red * scale) >> 16, error);
+			uint8_t g = ditherChannel((c->Green * scale) >> 16, error + 1);
+			uint8_t b = ditherChannel((c->Blue * scale) >> 16, error + 2);
+			error += 3;
+
+			if (outputBuffer != NULL)
+			{
+				uint8_t *dest = outputBuffer + (outputLookup[ledNo] * 3);
+				dest[redOffset] = r;
+				dest[greenOffset] = g;
+				dest[blueOffset] = b;
+			}
+			else
+			{
+				setPixelBytes(ledNo, r, g, b);
+			}
+		}
+
+		show();
+		return;
+	}
+
+	if (outputBuffer != NULL)
+	{
+		// write straight into the pixel buffer through the raster lookup
+		for (int ledNo = 0; ledNo < noOfLeds; ledNo++)
+		{
+			FixedColour *c = &leds[ledNo].fixedColour;
+			uint8_t *dest = outputBuffer + (outputLookup[ledNo] * 3);
+			dest[redOffset] = (uint8_t)((((c->Red * scale) >> 16) + 0x80) >> 8);
+			dest[greenOffset] = (uint8_t)((((c->Green * scale) >> 16) + 0x80) >> 8);
+			dest[blueOffset] = (uint8_t)((((c->Blue * scale) >> 16) + 0x80) >> 8);
+		}
+	}
+	else
+	{
+		for (int ledNo = 0; ledNo < noOfLeds; ledNo++)
+		{
+			FixedColour *c = &leds[ledNo].fixedColour;
+			uint8_t r = (uint8_t)((((c->Red * scale) >> 16) + 0x80) >> 8);
+			uint8_t g = (uint8_t)((((c->Green * scale) >> 16) + 0x80) >> 8);
+			uint8_t b = (uint8_t)((((c->Blue * scale) >> 16) + 0x80) >> 8);
+			setPixelBytes(ledNo, r, g, b);
+		}
+	}
+	show();
+}
+
+void Leds::clearFixed(Colour colour)
+{
+	FixedColour fixed;
+	colourToFixed(&colour, &fixed);
+
+	for (int ledNo = 0; ledNo < noOfLeds; ledNo++)
+	{
+		leds[ledNo].fixedColour = fixed;
+	}
+}
+
+// falloff weights as Q16 fractions, indexed by the x and y distances
+// from the light to the pixel centre in sixteenths of a pixel
+uint32_t *splatWeights = NULL;
+
+void buildSplatWeights()
+{
+	splatWeights = new uint32_t[SPLAT_TABLE_SIZE * SPLAT_TABLE_SIZE];
+
+	for (int xDist = 0; xDist < SPLAT_TABLE_SIZE; xDist++)
+	{
+		for (int yDist = 0; yDist < SPLAT_TABLE_SIZE; yDist++)
+		{
+			// use the same sums as the exact renderer so that lights
+			// which sit on a sixteenth come out identical
+			float dx = (float)xDist / SPLAT_SUB_POSITIONS;
+			float dy = (float)yDist / SPLAT_SUB_POSITIONS;
+			float dist = sqrt((dx * dx) + (dy * dy));
+			uint32_t weight = 0;
+
+			if (dist < 1)
+			{
+				weight = floatToFixedFraction(1 - dist);
+			}
+
+			splatWeights[(xDist * SPLAT_TABLE_SIZE) + yDist] = weight;
+		}
+	}
+}
+
+// Works out the three pixels along one axis that a light at the given
+// position can reach, wrapped onto the display, along with the distance
+// from the light to the centre of each as an index into the splat table
+
+void getSplatTaps(float position, int size, int *taps, int *distances)
+{
+	int whole = int(position);
+	int sub = (int)(((position - whole) * SPLAT_SUB_POSITIONS) + 0.5);
+
+	if (sub < 0)
+		sub = 0;
+
+	// a light that rounds up to the next pixel is centred on that one
+	whole = whole + (sub >> SPLAT_SUB_POSITION_BITS);
+	sub = sub & (SPLAT_SUB_POSITIONS - 1);
+
+	for (int tap = 0; tap < 3; tap++)
+	{
+		int p = whole + tap - 1;
+
+		// wrap without branches, -(test) is all ones when the test is true
+		taps[tap] = p + (size & -(p < 0)) - (size & -(p >= size));
+
+		// the distance to the pixel centre in sixteenths
+		int dist = abs(sub - (SPLAT_SUB_POSITIONS / 2) - ((tap - 1) * SPLAT_SUB_POSITIONS));
+
+		if (dist > SPLAT_SUB_POSITIONS)
+			dist = SPLAT_SUB_POSITIONS;
+
+		distances[tap] = dist;
+	}
+}
+
+void Leds::renderLightFixed(float sourceX, float sourceY, Colour colour, float brightness, float opacity)
+{
+	if (exactSplat)
+	{
+		renderLightFixedExact(sourceX, sourceY, colour, brightness, opacity);
+		return;
+	}
+
+	if (splatWeights == NULL)
+	{
+		buildSplatWeights();
+	}
+
+	// scale the colour by the brightness once for the whole light
+	uint32_t red = floatToFixedColour(colour.Red * brightness);
+	uint32_t green = floatToFixedColour(colour.Green * brightness);
+	uint32_t blue = floatToFixedColour(colour.Blue * brightness);
+
+	// an opacity of 1 adds the light to the pixel, anything else
+	// keeps part of the existing colour
+	uint32_t keep;
+
+	if (opacity == 1)
+	{
+		keep = FIXED_FRACTION_ONE;
+	}
+	else
+	{
+		keep = floatToFixedFraction(1 - opacity);
+	}
+
+	int columns[3], xDistances[3];
+	int rows[3], yDistances[3];
+
+	getSplatTaps(sourceX, ledWidth, columns, xDistances);
+	getSplatTaps(sourceY, ledHeight, rows, yDistances);
+
+	for (int xTap = 0; xTap < 3; xTap++)
+	{
+		uint32_t *weights = splatWeights + (xDistances[xTap] * SPLAT_TABLE_SIZE);
+
+		for (int yTap = 0; yTap < 3; yTap++)
+		{
+			uint32_t factor = weights[yDistances[yTap]];
+
+			// pixels a whole pixel or more from the light are not lit
+			if (factor != 0)
+			{
+				leds[(rows[yTap] * ledWidth) + columns[xTap]].AddFixedColourValues(
+					(red * factor) >> 16,
+					(green * factor) >> 16,
+					(blue * factor) >> 16,
+					keep);
+			}
+		}
+	}
+}
+
+void Leds::renderLightFixedExact(float sourceX, float sourceY, Colour colour, float brightness, float opacity)
+{
+	// scale the colour by the brightness once for the whole light
+	uint32_t red = floatToFixedColour(colour.Red * brightness);
+	uint32_t green = floatToFixedColour(colour.Green * brightness);
+	uint32_t blue = floatToFixedColour(colour.Blue * brightness);
+
+	// an opacity of 1 adds the light to the pixel, anything else
+	// keeps part of the existing colour
+	uint32_t keep;
+
+	if (opacity == 1)
+	{
+		keep = FIXED_FRACTION_ONE;
+	}
+	else
+	{
+		keep = floatToFixedFraction(1 - opacity);
+	}
+
+	int intX = int(sourceX);
+	int intY = int(sourceY);
+
+	for (int xOffset = -1; xOffset <= 1; xOffset++)
+	{
+		int px = intX + xOffset;
+		int writeX = px;
+
+		if (px >= ledWidth)
+		{
+			writeX = px - ledWidth;
+		}
+		else if (px < 0)
+		{
+			writeX = px + ledWidth;
+		}
+
+		for (int yOffset = -1; yOffset <= 1; yOffset++)
+		{
+			int py = intY + yOffset;
+			int writeY = py;
+
+			if (py >= ledHeight)
+			{
+				writeY = py - ledHeight;
+			}
+			else if (py < 0)
+			{
+				writeY = py + ledHeight;
+			}
+
+			float dx = sourceX - (px + 0.5);
+			float dy = sourceY - (py + 0.5);
+			float dist = sqrt((dx * dx) + (dy * dy));
+
+			if (dist < 1)
+			{
+				uint32_t factor = floatToFixedFraction(1 - dist);
+
+				getLed(writeX, writeY)->AddFixedColourValues(
+					(red * factor) >> 16,
+					(green * factor) >> 16,
+					(blue * factor) >> 16,
+					keep);
+			}
+		}
+	}
+}
@@ -3,28 +3,111 @@
 #include "math.h"
 #include <HardwareSerial.h>
 
+// The fixed point renderer lights the 3x3 pixels around a light using a
+// table of falloff weights rather than working out each distance. Light
+// positions are rounded to the nearest sixteenth of a pixel, so the
+// distance from a light to a pixel centre along each axis is a whole
+// number of sixteenths and the weight for every tap comes from one table
+// indexed by the two distances. Distances of a pixel or more map to the
+// last row and column, which hold zero.
+//
+// Rounding moves a light by up to a thirty second of a pixel along each
+// axis, which changes its distance to a pixel centre by up to 0.044 of a
+// pixel. The weight falls by one for each pixel of distance, so a full
+// brightness light can come out up to 11.3 lsb from the exact render,
+// and with the rounding of the output byte a light is within
+// SPLAT_MAX_DIFFERENCE. Where lights overlap their differences can add.
+
+#define SPLAT_SUB_POSITION_BITS 4
+#define SPLAT_SUB_POSITIONS (1 << SPLAT_SUB_POSITION_BITS)
+#define SPLAT_TABLE_SIZE (SPLAT_SUB_POSITIONS + 1)
+#define SPLAT_MAX_DIFFERENCE 12
+
+// The fixed point display can gamma correct its output so that equal steps
+// in colour look like equal steps in brightness. The gamma table maps the
+// top byte of a Q8.8 level to a Q8.8 output level and the bottom byte
+// interpolates between entries. Dim output levels are then dithered over
+// time: the fraction left over when a level is cut to a byte is carried
+// in each led and added to the next frame, so a level between two bytes
+// is shown as a mix of the two rather than being rounded away.
+
+#define PIXEL_GAMMA 2.2
+#define GAMMA_TABLE_SIZE 257
+#define DITHER_LIMIT 64
+
 class Leds
 {
 public:
 
 	void(*show)();
 	void(*setPixel)(int no, float r, float g, float b);
+	void(*setPixelBytes)(int no, uint8_t r, uint8_t g, uint8_t b);
 
-	Led** leds;
+	// one block of ledWidth * ledHeight leds in row major order, so the
+	// led at x,y is leds[(y * ledWidth) + x] and the display order is
+	// simply the order in memory
+	Led* leds;
 	int ledWidth;
 	int ledHeight;
+	int noOfLeds;
+
+	// when an output buffer is set the fixed point display writes the pixel
+	// bytes straight into it, each led going to the pixel given by the
+	// lookup with its colours at the given offsets
+	uint8_t *outputBuffer;
+	const int *outputLookup;
+	uint8_t redOffset;
+	uint8_t greenOffset;
+	uint8_t blueOffset;
 
 	float normWidth;
 	float normHeight;
 
+	// selects the Q8.8 colour pipeline rather than the float one
+	bool fixedPoint;
+
+	// makes the fixed point pipeline work out each distance rather than
+	// using the splat table, for comparison
+	bool exactSplat;
+
+	// gamma corrects and dithers the fixed point output
+	bool gammaDither;
+
+	// the fractions carried over by the dither, three for each led
+	uint8_t *ditherErrors;
+
+	// set by the display when a dithered led is still carrying a fraction,
+	// which means the display should be refreshed even if nothing changes
+	bool ditherPending;
+
 	Leds(int inWidth, int inHeight,
 		void(*inShow)(), 
-		void(*inSetPixel)(int no, float r, float g, float b));
+		void(*inSetPixel)(int no, float r, float g, float b),
+		void(*inSetPixelBytes)(int no, uint8_t r, uint8_t g, uint8_t b));
+
+	~Leds();
+
+	Led *getLed(int x, int y)
+	{
+		return &leds[(y * ledWidth) + x];
+	}
+
+	void setOutputBuffer(uint8_t *buffer, const int *lookup, int inRedOffset, int inGreenOffset, int inBlueOffset);
 
 	void dump();
 	void display(float brightness);
 	void clear(Colour colour);
+	void setLedColour(int ledNo, Colour colour);
 	void renderLight(float sourceX, float sourceY, Colour colour, float brightness, float opacity);
 
-};
+	void displayFloat(float brightness);
+	void clearFloat(Colour colour);
+	void renderLightFloat(float sourceX, float sourceY, Colour colour, float brightness, float opacity);
 
+	void displayFixed(float brightness);
+	uint8_t ditherChannel(uint32_t level, uint8_t *error);
+	void clearFixed(Colour colour);
+	void renderLightFixed(float sourceX, float sourceY, Colour colour, float brightness, float opacity);
+	void renderLightFixedExact(float sourceX, float sourceY, Colour colour, float brightness, float opacity);
+
+};
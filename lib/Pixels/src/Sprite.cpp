@@ -5,6 +5,52 @@
 // class - these functions use members of the Frame class can can't be 
 // defined in Sprite.h
 
+void Sprite::enable()
+{
+    if (enabled)
+        return;
+
+    enabled = true;
+    lastUpdateMillis = frame->animationMillis;
+    frame->activateSprite(this);
+}
+
+void Sprite::disable()
+{
+    if (!enabled)
+        return;
+
+    enabled = false;
+    frame->deactivateSprite(this);
+}
+
+void Sprite::fadeToColour(Colour target, int noOfSteps, Easing easing)
+{
+    startColour = colour;
+    targetColour = target;
+    startAnimation(&colourAnimation, frame->animationMillis, noOfSteps, easing);
+}
+
+void Sprite::fadeToBrightness(float target, int noOfSteps, Easing easing)
+{
+    startBrightness = brightness;
+    targetBrightness = target;
+    startAnimation(&brightnessAnimation, frame->animationMillis, noOfSteps, easing);
+}
+
+void Sprite::moveToPosition(float targetX, float targetY, int noOfSteps, SpriteMovingState inStateWhenMoveCompleted,
+    Easing easing)
+{
+    startX = x;
+    startY = y;
+    destX = targetX;
+    destY = targetY;
+
+    stateWhenMoveCompleted = inStateWhenMoveCompleted;
+    startAnimation(&moveAnimation, frame->animationMillis, noOfSteps, easing);
+    movingState = SPRITE_MOVE;
+}
+
 void Sprite::render()
 {
     if (!enabled)
@@ -21,10 +67,10 @@ void Sprite::renderColour(Colour col)
     frame->leds->renderLight(x, y, col, brightness, 1);
 }
 
-void Sprite::bounce()
+void Sprite::bounce(float elapsedSteps)
 {
-    x = x + xSpeed;
-    y = y + ySpeed;
+    x = x + (xSpeed * elapsedSteps);
+    y = y + (ySpeed * elapsedSteps);
 
     if (x < 0)
     {
@@ -51,11 +97,11 @@ void Sprite::bounce()
     }
 }
 
-void Sprite::wrap()
+void Sprite::wrap(float elapsedSteps)
 {
     
-    x = x + xSpeed;
-    y = y + ySpeed;
+    x = x + (xSpeed * elapsedSteps);
+    y = y + (ySpeed * elapsedSteps);
 
     while(x<0)
         x=x+frame->width;
@@ -71,13 +117,14 @@ void Sprite::wrap()
 
 }
 
-void Sprite::move()
+void Sprite::move(unsigned long currentMillis)
 {
-    x = x + positionXSpeed;
-    y = y + positionYSpeed;
+    float progress = getAnimationProgress(&moveAnimation, currentMillis);
+
+    x = interpolate(startX, destX, progress);
+    y = interpolate(startY, destY, progress);
 
-    moveSteps--;
-    if(moveSteps==0)
+    if(!moveAnimation.active)
     {
         x=destX;
         y=destY;
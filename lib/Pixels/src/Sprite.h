@@ -7,6 +7,7 @@ class Frame;
 class Leds;
 
 #include "Colour.h"
+#include "Animation.h"
 
 class Sprite
 {
@@ -21,32 +22,42 @@ public:
     Leds* leds;
 	Colour colour;
 
-    float redStep, blueStep, greenStep;
+    // colour, brightness and moves to a position are animated between a
+    // start and a target value, see Animation.h
+    Colour startColour;
     Colour targetColour;
-    int colourSteps;
+    Animation colourAnimation;
 
 	float brightness;
+    float startBrightness;
     float targetBrightness;
-    float brightnessStep;
-    int brightnessSteps;
+    Animation brightnessAnimation;
 
 	float opacity;
 
 	float x;
 	float y;
+    // bounce and wrap speeds are in pixels per animation step
     float xSpeed;
     float ySpeed;
 
     // we can make the pixels move to a position and then start an action
-    // these are the position update values
-    float positionXSpeed;
-    float positionYSpeed;
+    float startX;
+    float startY;
     float destX;
     float destY;
-    int moveSteps;
+    Animation moveAnimation;
+
+    // time of the last update, bounce and wrap move by the time since then
+    unsigned long lastUpdateMillis;
 
     bool enabled;
 
+    // position of the sprite in the frame's pool and in its list of
+    // enabled sprites, -1 when the sprite is not enabled
+    int poolIndex;
+    int activeSlot;
+
     #define CLOSE_TOLERANCE 0.0001
 
     bool close_to(float a, float b)
@@ -77,69 +88,58 @@ public:
     }
 
     void setColour(Colour target){
-        redStep = 0;
-        blueStep = 0;
-        greenStep = 0;
         colour=target;
         targetColour = target;
-        colourSteps = 0;
+        stopAnimation(&colourAnimation);
     }
 
-    void fadeToColour(Colour target, int noOfSteps){
-        redStep = (target.Red - colour.Red) / noOfSteps;
-        blueStep = (target.Blue - colour.Blue) / noOfSteps;
-        greenStep = (target.Green - colour.Green) / noOfSteps;
-        targetColour = target;
-        colourSteps = noOfSteps;
-    }
+    // the animations start at the time of the last frame update, the
+    // first change shows at the next one
+
+    void fadeToColour(Colour target, int noOfSteps, Easing easing = EASE_LINEAR);
 
     // fade to brightness level. If we fade to black
     // the sprite is then disabled
 
-    void fadeToBrightness(float target, int noOfSteps){
-        brightnessStep = (target - brightness)/noOfSteps;
-        targetBrightness = target;
-        brightnessSteps = noOfSteps;
-    }
+    void fadeToBrightness(float target, int noOfSteps, Easing easing = EASE_LINEAR);
 
-    void moveToPosition(float targetX, float targetY, int noOfSteps, SpriteMovingState inStateWhenMoveCompleted)
-    {
-        destX=targetX ;
-        destY=targetY;
+    void moveToPosition(float targetX, float targetY, int noOfSteps, SpriteMovingState inStateWhenMoveCompleted,
+        Easing easing = EASE_LINEAR);
 
-        positionXSpeed = (targetX-x) / noOfSteps;
-        positionYSpeed = (targetY-y) / noOfSteps;   
+    // returns true if the sprite changed in a way that will show
 
-        stateWhenMoveCompleted = inStateWhenMoveCompleted;
-        moveSteps = noOfSteps;
-        movingState = SPRITE_MOVE;
-    }
-
-    void update()
+    bool update(unsigned long currentMillis)
     {
         if(!enabled)
-            return;
+            return false;
+
+        bool changed = false;
 
-        if(brightnessSteps>0)
+        float elapsedSteps = (float)(currentMillis - lastUpdateMillis) / MILLIS_PER_ANIMATION_STEP;
+        lastUpdateMillis = currentMillis;
+
+        if(brightnessAnimation.active)
         {
-            brightness = brightness + brightnessStep;
-            brightnessSteps--;
-            if(brightnessSteps==0)
+            changed = true;
+            float progress = getAnimationProgress(&brightnessAnimation, currentMillis);
+            brightness = interpolate(startBrightness, targetBrightness, progress);
+            if(!brightnessAnimation.active)
             {
                 brightness = targetBrightness;
                 if(targetBrightness==0){
-                    enabled=false;
+                    disable();
                 }
             }
         }
 
-        if(colourSteps>0)
+        if(colourAnimation.active)
         {
-            colour.Red = colour.Red + redStep;
-            colour.Blue = colour.Blue + blueStep;
-            colour.Green = colour.Green + greenStep;
-            colourSteps--;
-            if(colourSteps==0){
+            changed = true;
+            float progress = getAnimationProgress(&colourAnimation, currentMillis);
+            colour.Red = interpolate(startColour.Red, targetColour.Red, progress);
+            colour.Green = interpolate(startColour.Green, targetColour.Green, progress);
+            colour.Blue = interpolate(startColour.Blue, targetColour.Blue, progress);
+            if(!colourAnimation.active){
                 colour=targetColour;
             }
         }
@@ -149,26 +149,31 @@ public:
             case SPRITE_STOPPED:
                 break;
             case SPRITE_BOUNCE:
-                bounce();
+                bounce(elapsedSteps);
+                changed = changed || xSpeed != 0 || ySpeed != 0;
                 break;
             case SPRITE_WRAP:
-                wrap();
+                wrap(elapsedSteps);
+                changed = changed || xSpeed != 0 || ySpeed != 0;
                 break;
             case SPRITE_MOVE:
-                move();
+                move(currentMillis);
+                changed = true;
                 break;
         }
+
+        return changed;
     }
 
     void render();
     
     void renderColour(Colour col);
 
-    void bounce();
+    void bounce(float elapsedSteps);
 
-    void wrap();
+    void wrap(float elapsedSteps);
 
-    void move();
+    void move(unsigned long currentMillis);
 
     void dump() {
         if(!enabled)
@@ -176,10 +181,10 @@ public:
             return;            
         }
 
-        Serial.printf("r:%f g:%f b:%f bright:%f opacity:%f x:%f y:%f moveSteps:%d colourSteps:%d ",
+        Serial.printf("r:%f g:%f b:%f bright:%f opacity:%f x:%f y:%f moving:%d fading colour:%d fading brightness:%d ",
             colour.Red, colour.Green, colour.Blue,
             brightness, opacity,
-            x, y, moveSteps, colourSteps);
+            x, y, moveAnimation.active, colourAnimation.active, brightnessAnimation.active);
 
         switch(movingState)
         {
@@ -200,36 +205,39 @@ public:
 
     void reset()
     {
-        enabled=false;
+        if(enabled)
+            disable();
         movingState = SPRITE_STOPPED;
         colour=BLACK_COLOUR;
-        moveSteps=0;
-        colourSteps=0;
-        brightnessSteps=0;
+        targetColour=BLACK_COLOUR;
+        stopAnimation(&moveAnimation);
+        stopAnimation(&colourAnimation);
+        stopAnimation(&brightnessAnimation);
+        brightness=0;
+        targetBrightness=0;
+        opacity=1;
         x=0;
         y=0;
         xSpeed=0;
         ySpeed=0;
-        redStep=0;
-        greenStep=0;
-        blueStep=0;
-        brightnessStep=0;
+        lastUpdateMillis=0;
     }
 
-    Sprite(Frame * inFrame)
+    Sprite()
     {
-        frame= inFrame;
+        frame=NULL;
+        poolIndex=0;
+        activeSlot=-1;
+        enabled=false;
         reset();
     }
 
-    void enable(){
-        enabled=true;
-    }
+    // enabling and disabling go through the frame so that it can keep
+    // the list of sprites it has to update and render
 
-    void disable()
-    {
-        enabled=false;
-    }
+    void enable();
+
+    void disable();
     
     void setup(Colour inColour, float inBrightness, float inOpacity,
         float inX, float inY, 
@@ -246,6 +254,9 @@ public:
         xSpeed = inXSpeed;
         ySpeed = inYSpeed;
         movingState = inMovingState;
-        enabled = inEnabled;
+        if(inEnabled)
+            enable();
+        else
+            disable();
     }
 };
@@ -32,6 +32,8 @@
 #include "boot.h"
 #include "otaupdate.h"
 #include "outpin.h"
+#include "latency.h"
+#include "settingsstore.h"
 
 // This function will be different for each build of the device.
 
@@ -54,6 +56,7 @@ void populateProcessList()
 	addProcessToAllProcessList(&hullosProcess);
 	addProcessToAllProcessList(&otaUpdateProcessDescriptor);
 	addProcessToAllProcessList(&outPinProcess);
+	addProcessToAllProcessList(&settingsStoreProcess);
 }
 
 void populateSensorList()
@@ -140,10 +143,11 @@ void startDevice()
 
 	startSensors();
 
+	// the pixel frame keeps the status up for a while
 	addStatusItem(PIXEL_STATUS_OK);
 	renderStatusDisplay();
 
-	delay(1000); // show the status for a while
+	resetLoopTimings();
 
 	Serial.printf("Start complete\n\nType help and press enter for help\n\n");
 }
@@ -175,7 +179,26 @@ void setup()
 
 void loop()
 {
+	unsigned long loopStartMicros = micros();
 	updateSensors();
 	updateProcesses();
-	delay(1);
+	recordLoopCycle(loopStartMicros, ulongDiff(micros(), loopStartMicros));
+
+	// sleep until the next process or sensor is due
+	unsigned long now = millis();
+	unsigned long sleepMillis = getProcessSleepMillis(now);
+	unsigned long sensorSleepMillis = getSensorSleepMillis(now);
+
+	if (sensorSleepMillis < sleepMillis)
+	{
+		sleepMillis = sensorSleepMillis;
+	}
+
+	// always give the network stack a look in
+	if (sleepMillis == 0)
+	{
+		sleepMillis = 1;
+	}
+
+	delay(sleepMillis);
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+// Host stand-in for the NeoPixel driver. The strip keeps its pixel buffer in
+// the same byte order as the real one and show() passes it to the hook set
+// with hostSetPixelShowHook, so a host program can see every frame.
+
+#include <Arduino.h>
+
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_RBG ((0 << 6) | (0 << 4) | (2 << 2) | (1))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_GBR ((2 << 6) | (2 << 4) | (0 << 2) | (1))
+#define NEO_BRG ((1 << 6) | (1 << 4) | (2 << 2) | (0))
+#define NEO_BGR ((2 << 6) | (2 << 4) | (1 << 2) | (0))
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+
+typedef uint16_t neoPixelType;
+
+class Adafruit_NeoPixel
+{
+public:
+	Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800);
+	~Adafruit_NeoPixel();
+
+	void begin() {}
+	void show();
+	void clear();
+	void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+	void setPixelColor(uint16_t n, uint32_t c);
+	void setBrightness(uint8_t b) {}
+	uint32_t getPixelColor(uint16_t n) const;
+	uint8_t *getPixels() const { return pixels; }
+	uint16_t numPixels() const { return numLEDs; }
+
+private:
+	uint16_t numLEDs;
+	uint8_t *pixels;
+	uint8_t rOffset;
+	uint8_t gOffset;
+	uint8_t bOffset;
+};
@@ -0,0 +1,551 @@
+#include <time.h>
+#include <string>
+
+#include "Arduino.h"
+#include "hostArduino.h"
+
+// clock
+
+bool hostClockFrozen = false;
+unsigned long long hostClockOffsetMicros = 0;
+unsigned long hostDelayTotalMillis = 0;
+unsigned long hostDelayCallCount = 0;
+
+static unsigned long long hostRealMicros()
+{
+	static unsigned long long startMicros = 0;
+
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	unsigned long long nowMicros = (unsigned long long)now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+
+	if (startMicros == 0)
+	{
+		startMicros = nowMicros;
+	}
+
+	return nowMicros - startMicros;
+}
+
+// the frozen clock keeps the real time it stopped at
+
+unsigned long long hostFrozenMicros = 0;
+
+static unsigned long long hostMicros()
+{
+	if (hostClockFrozen)
+	{
+		return hostFrozenMicros + hostClockOffsetMicros;
+	}
+	return hostRealMicros() + hostClockOffsetMicros;
+}
+
+void hostFreezeClock(bool frozen)
+{
+	if (frozen == hostClockFrozen)
+	{
+		return;
+	}
+
+	if (frozen)
+	{
+		hostFrozenMicros = hostRealMicros();
+	}
+	else
+	{
+		// carry on from the frozen time
+		hostClockOffsetMicros = hostFrozenMicros + hostClockOffsetMicros - hostRealMicros();
+	}
+
+	hostClockFrozen = frozen;
+}
+
+void hostAdvanceMillis(unsigned long ms)
+{
+	hostClockOffsetMicros += (unsigned long long)ms * 1000;
+}
+
+unsigned long hostDelayMillis()
+{
+	return hostDelayTotalMillis;
+}
+
+unsigned long hostDelayCalls()
+{
+	return hostDelayCallCount;
+}
+
+void hostResetDelayCounts()
+{
+	hostDelayTotalMillis = 0;
+	hostDelayCallCount = 0;
+}
+
+unsigned long millis()
+{
+	return (unsigned long)(hostMicros() / 1000);
+}
+
+unsigned long micros()
+{
+	return (unsigned long)hostMicros();
+}
+
+void delay(unsigned long ms)
+{
+	hostDelayTotalMillis += ms;
+	hostDelayCallCount++;
+	hostAdvanceMillis(ms);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+	hostClockOffsetMicros += us;
+}
+
+void yield()
+{
+}
+
+long random(long limit)
+{
+	if (limit <= 0)
+	{
+		return 0;
+	}
+	return rand() % limit;
+}
+
+long random(long low, long high)
+{
+	if (high <= low)
+	{
+		return low;
+	}
+	return low + random(high - low);
+}
+
+void randomSeed(unsigned long seed)
+{
+	srand(seed);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+	return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+// pins
+
+#define HOST_NO_OF_PINS 64
+
+int hostPinLevels[HOST_NO_OF_PINS];
+int hostAnalogLevels[HOST_NO_OF_PINS];
+void (*hostPinInterrupts[HOST_NO_OF_PINS])(void);
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+	if (pin < HOST_NO_OF_PINS && mode == INPUT_PULLUP)
+	{
+		hostPinLevels[pin] = HIGH;
+	}
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+	if (pin < HOST_NO_OF_PINS)
+	{
+		hostPinLevels[pin] = value;
+	}
+}
+
+int digitalRead(uint8_t pin)
+{
+	return pin < HOST_NO_OF_PINS ? hostPinLevels[pin] : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+	return pin < HOST_NO_OF_PINS ? hostAnalogLevels[pin] : 0;
+}
+
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode)
+{
+	if (pin < HOST_NO_OF_PINS)
+	{
+		hostPinInterrupts[pin] = handler;
+	}
+}
+
+void detachInterrupt(uint8_t pin)
+{
+	if (pin < HOST_NO_OF_PINS)
+	{
+		hostPinInterrupts[pin] = NULL;
+	}
+}
+
+void hostSetDigitalInput(int pin, int value)
+{
+	if (pin < 0 || pin >= HOST_NO_OF_PINS)
+	{
+		return;
+	}
+
+	bool changed = hostPinLevels[pin] != value;
+	hostPinLevels[pin] = value;
+
+	if (changed && hostPinInterrupts[pin] != NULL)
+	{
+		hostPinInterrupts[pin]();
+	}
+}
+
+void hostSetAnalogInput(int pin, int value)
+{
+	if (pin >= 0 && pin < HOST_NO_OF_PINS)
+	{
+		hostAnalogLevels[pin] = value;
+	}
+}
+
+// String
+
+String::String(float value, unsigned char places) : String((double)value, places)
+{
+}
+
+String::String(double value, unsigned char places)
+{
+	char buffer[40];
+	snprintf(buffer, sizeof(buffer), "%.*f", places, value);
+	text = buffer;
+}
+
+int String::indexOf(char c) const
+{
+	size_t pos = text.find(c);
+	return pos == std::string::npos ? -1 : (int)pos;
+}
+
+int String::indexOf(const char *s) const
+{
+	size_t pos = text.find(s);
+	return pos == std::string::npos ? -1 : (int)pos;
+}
+
+String String::substring(unsigned int from) const
+{
+	return from >= text.length() ? String() : String(text.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+	if (from > to)
+	{
+		unsigned int t = from;
+		from = to;
+		to = t;
+	}
+	if (from >= text.length())
+	{
+		return String();
+	}
+	return String(text.substr(from, to - from));
+}
+
+void String::toCharArray(char *buffer, unsigned int bufferSize) const
+{
+	if (bufferSize == 0)
+	{
+		return;
+	}
+	snprintf(buffer, bufferSize, "%s", text.c_str());
+}
+
+void String::trim()
+{
+	size_t start = text.find_first_not_of(" \t\r\n");
+	if (start == std::string::npos)
+	{
+		text.clear();
+		return;
+	}
+	size_t end = text.find_last_not_of(" \t\r\n");
+	text = text.substr(start, end - start + 1);
+}
+
+void String::toLowerCase()
+{
+	for (size_t i = 0; i < text.length(); i++)
+	{
+		text[i] = tolower(text[i]);
+	}
+}
+
+void String::toUpperCase()
+{
+	for (size_t i = 0; i < text.length(); i++)
+	{
+		text[i] = toupper(text[i]);
+	}
+}
+
+bool String::endsWith(const String &s) const
+{
+	if (s.text.length() > text.length())
+	{
+		return false;
+	}
+	return text.compare(text.length() - s.text.length(), s.text.length(), s.text) == 0;
+}
+
+// Print and Stream
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+	size_t n = 0;
+	while (size--)
+	{
+		n += write(*buffer++);
+	}
+	return n;
+}
+
+size_t Print::print(long value, int base)
+{
+	if (base == 10)
+	{
+		return printf("%ld", value);
+	}
+	return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+	switch (base)
+	{
+	case 16:
+		return printf("%lX", value);
+	case 8:
+		return printf("%lo", value);
+	case 2:
+	{
+		char buffer[sizeof(value) * 8 + 1];
+		int pos = sizeof(buffer) - 1;
+		buffer[pos] = 0;
+		do
+		{
+			buffer[--pos] = '0' + (value & 1);
+			value >>= 1;
+		} while (value != 0);
+		return write(buffer + pos);
+	}
+	default:
+		return printf("%lu", value);
+	}
+}
+
+size_t Print::print(double value, int places)
+{
+	return printf("%.*f", places, value);
+}
+
+size_t Print::printf(const char *format, ...)
+{
+	char buffer[256];
+	va_list args;
+
+	va_start(args, format);
+	int length = vsnprintf(buffer, sizeof(buffer), format, args);
+	va_end(args);
+
+	if (length < 0)
+	{
+		return 0;
+	}
+
+	if (length < (int)sizeof(buffer))
+	{
+		return write((const uint8_t *)buffer, length);
+	}
+
+	std::string longText(length + 1, 0);
+	va_start(args, format);
+	vsnprintf(&longText[0], length + 1, format, args);
+	va_end(args);
+	return write((const uint8_t *)longText.c_str(), length);
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+	size_t count = 0;
+	while (count < length)
+	{
+		int c = read();
+		if (c < 0)
+		{
+			break;
+		}
+		buffer[count++] = (char)c;
+	}
+	return count;
+}
+
+String Stream::readStringUntil(char terminator)
+{
+	std::string text;
+	int c;
+	while ((c = read()) >= 0 && c != terminator)
+	{
+		text += (char)c;
+	}
+	return String(text);
+}
+
+String Stream::readString()
+{
+	std::string text;
+	int c;
+	while ((c = read()) >= 0)
+	{
+		text += (char)c;
+	}
+	return String(text);
+}
+
+// Serial
+
+bool hostSerialOutputOn = true;
+void (*hostSerialOutputHook)(const char *text, size_t length) = NULL;
+std::string hostSerialInputText;
+size_t hostSerialInputPos = 0;
+
+HardwareSerial Serial(0);
+HardwareSerial Serial1(1);
+
+void hostSerialOutput(bool on)
+{
+	fflush(stdout);
+	hostSerialOutputOn = on;
+}
+
+void hostSetSerialOutputHook(void (*hook)(const char *text, size_t length))
+{
+	hostSerialOutputHook = hook;
+}
+
+void hostSerialInput(const char *text)
+{
+	hostSerialInputText.erase(0, hostSerialInputPos);
+	hostSerialInputPos = 0;
+	hostSerialInputText += text;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+	return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+	// Serial1 drives the printer, which the host doesn't have
+	if (port != 0)
+	{
+		return size;
+	}
+
+	if (hostSerialOutputOn)
+	{
+		fwrite(buffer, 1, size, stdout);
+	}
+
+	if (hostSerialOutputHook != NULL)
+	{
+		hostSerialOutputHook((const char *)buffer, size);
+	}
+
+	return size;
+}
+
+int HardwareSerial::available()
+{
+	if (port != 0)
+	{
+		return 0;
+	}
+	return hostSerialInputText.length() - hostSerialInputPos;
+}
+
+int HardwareSerial::read()
+{
+	if (available() == 0)
+	{
+		return -1;
+	}
+	return (unsigned char)hostSerialInputText[hostSerialInputPos++];
+}
+
+int HardwareSerial::peek()
+{
+	if (available() == 0)
+	{
+		return -1;
+	}
+	return (unsigned char)hostSerialInputText[hostSerialInputPos];
+}
+
+// ESP
+
+EspClass ESP;
+
+struct rst_info hostResetInfo = {REASON_DEFAULT_RST, 0, 0, 0, 0, 0, 0};
+uint32_t hostRtcUserMemory[128];
+
+uint32_t EspClass::getFreeHeap()
+{
+	return 40000;
+}
+
+uint32_t EspClass::getChipId()
+{
+	return 0x00C1B0;
+}
+
+uint32_t EspClass::getCycleCount()
+{
+	return (uint32_t)(hostMicros() * 80);
+}
+
+void EspClass::restart()
+{
+	fflush(stdout);
+	fprintf(stderr, "ESP.restart() called on the host\n");
+	exit(0);
+}
+
+struct rst_info *EspClass::getResetInfoPtr()
+{
+	return &hostResetInfo;
+}
+
+bool EspClass::rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size)
+{
+	// the offset is in words and the size in bytes, as on the ESP8266
+	if (offset * sizeof(uint32_t) + size > sizeof(hostRtcUserMemory))
+	{
+		return false;
+	}
+	memcpy(data, hostRtcUserMemory + offset, size);
+	return true;
+}
+
+bool EspClass::rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size)
+{
+	if (offset * sizeof(uint32_t) + size > sizeof(hostRtcUserMemory))
+	{
+		return false;
+	}
+	memcpy(hostRtcUserMemory + offset, data, size);
+	return true;
+}
@@ -0,0 +1,262 @@
+#pragma once
+
+// Host stand-in for the parts of the Arduino core the firmware uses, so the
+// libraries can be built and run on Linux for benchmarks and tests.
+// hostArduino.h has the controls the host programs use to drive it.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <math.h>
+#include <ctype.h>
+#include <string>
+#include <functional>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+long random(long limit);
+long random(long low, long high);
+void randomSeed(unsigned long seed);
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+
+#define A0 17
+
+#ifndef LED_BUILTIN
+#define LED_BUILTIN 2
+#endif
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void attachInterrupt(uint8_t pin, void (*handler)(void), int mode);
+void detachInterrupt(uint8_t pin);
+#define digitalPinToInterrupt(p) (p)
+
+#define ICACHE_RAM_ATTR
+#define IRAM_ATTR
+
+template <class T, class L, class H>
+T constrain(T value, L low, H high)
+{
+	return value < low ? low : (value > high ? high : value);
+}
+
+long map(long x, long inMin, long inMax, long outMin, long outMax);
+
+#define PROGMEM
+#define PSTR(s) (s)
+#define F(s) (s)
+#define pgm_read_byte(p) (*(const uint8_t *)(p))
+#define pgm_read_byte_near(p) (*(const uint8_t *)(p))
+#define pgm_read_word(p) (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p) (*(void *const *)(p))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define memcpy_P memcpy
+
+class __FlashStringHelper;
+
+inline bool isAlphaNumeric(int c) { return isalnum(c) != 0; }
+inline bool isAlpha(int c) { return isalpha(c) != 0; }
+inline bool isDigit(int c) { return isdigit(c) != 0; }
+inline bool isWhitespace(int c) { return c == ' ' || c == '\t'; }
+inline bool isSpace(int c) { return isspace(c) != 0; }
+inline bool isPunct(int c) { return ispunct(c) != 0; }
+inline int toLowerCase(int c) { return tolower(c); }
+inline int toUpperCase(int c) { return toupper(c); }
+
+class String
+{
+public:
+	String() {}
+	String(const char *text) : text(text ? text : "") {}
+	String(const std::string &text) : text(text) {}
+	String(char c) : text(1, c) {}
+	String(int value) : text(std::to_string(value)) {}
+	String(unsigned int value) : text(std::to_string(value)) {}
+	String(long value) : text(std::to_string(value)) {}
+	String(unsigned long value) : text(std::to_string(value)) {}
+	String(float value, unsigned char places = 2);
+	String(double value, unsigned char places = 2);
+
+	const char *c_str() const { return text.c_str(); }
+	unsigned int length() const { return text.length(); }
+	char charAt(unsigned int index) const { return index < text.length() ? text[index] : 0; }
+	char operator[](unsigned int index) const { return charAt(index); }
+	int indexOf(char c) const;
+	int indexOf(const char *s) const;
+	String substring(unsigned int from) const;
+	String substring(unsigned int from, unsigned int to) const;
+	void toCharArray(char *buffer, unsigned int bufferSize) const;
+	void trim();
+	void toLowerCase();
+	void toUpperCase();
+	long toInt() const { return atol(text.c_str()); }
+	float toFloat() const { return (float)atof(text.c_str()); }
+	bool startsWith(const String &s) const { return text.compare(0, s.text.length(), s.text) == 0; }
+	bool endsWith(const String &s) const;
+	bool equals(const String &s) const { return text == s.text; }
+	bool equalsIgnoreCase(const String &s) const { return strcasecmp(text.c_str(), s.c_str()) == 0; }
+
+	String &operator+=(const String &s)
+	{
+		text += s.text;
+		return *this;
+	}
+	String &operator+=(const char *s)
+	{
+		text += s;
+		return *this;
+	}
+	String &operator+=(char c)
+	{
+		text += c;
+		return *this;
+	}
+	bool operator==(const String &s) const { return text == s.text; }
+	bool operator==(const char *s) const { return text == s; }
+	bool operator!=(const String &s) const { return text != s.text; }
+	bool operator!=(const char *s) const { return text != s; }
+
+	friend String operator+(const String &a, const String &b) { return String(a.text + b.text); }
+	friend String operator+(const String &a, const char *b) { return String(a.text + b); }
+	friend String operator+(const char *a, const String &b) { return String(a + b.text); }
+
+private:
+	std::string text;
+};
+
+class Print
+{
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t c) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	size_t write(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+	size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+
+	size_t print(const char *text) { return write(text); }
+	size_t print(const String &text) { return write(text.c_str()); }
+	size_t print(char c) { return write((uint8_t)c); }
+	size_t print(unsigned char value, int base = 10) { return print((unsigned long)value, base); }
+	size_t print(int value, int base = 10) { return print((long)value, base); }
+	size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+	size_t print(long value, int base = 10);
+	size_t print(unsigned long value, int base = 10);
+	size_t print(double value, int places = 2);
+
+	size_t println() { return write("\r\n"); }
+	template <typename T>
+	size_t println(T value)
+	{
+		size_t n = print(value);
+		return n + println();
+	}
+	template <typename T>
+	size_t println(T value, int format)
+	{
+		size_t n = print(value, format);
+		return n + println();
+	}
+
+	size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+class Stream : public Print
+{
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	virtual void flush() {}
+
+	size_t readBytes(char *buffer, size_t length);
+	size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+	String readStringUntil(char terminator);
+	String readString();
+};
+
+// Serial writes to stdout and reads from text queued by hostSerialInput
+
+class HardwareSerial : public Stream
+{
+public:
+	HardwareSerial(int port) : port(port) {}
+	void begin(unsigned long baud) {}
+	void end() {}
+	void setDebugOutput(bool on) {}
+	size_t write(uint8_t c) override;
+	size_t write(const uint8_t *buffer, size_t size) override;
+	using Print::write;
+	int available() override;
+	int read() override;
+	int peek() override;
+	operator bool() const { return true; }
+
+private:
+	int port;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+class EspClass
+{
+public:
+	uint32_t getFreeHeap();
+	uint32_t getChipId();
+	uint32_t getCycleCount();
+	void restart();
+	void reset() { restart(); }
+	void deepSleep(uint64_t micros) {}
+	struct rst_info *getResetInfoPtr();
+	bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size);
+	bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size);
+};
+
+extern EspClass ESP;
+
+enum rst_reason
+{
+	REASON_DEFAULT_RST = 0,
+	REASON_WDT_RST = 1,
+	REASON_EXCEPTION_RST = 2,
+	REASON_SOFT_WDT_RST = 3,
+	REASON_SOFT_RESTART = 4,
+	REASON_DEEP_SLEEP_AWAKE = 5,
+	REASON_EXT_SYS_RST = 6
+};
+
+struct rst_info
+{
+	uint32_t reason;
+	uint32_t exccause;
+	uint32_t epc1;
+	uint32_t epc2;
+	uint32_t epc3;
+	uint32_t excvaddr;
+	uint32_t depc;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <ESP8266WiFi.h>
+
+class DNSServer
+{
+public:
+	bool start(uint16_t port, const String &domainName, const IPAddress &resolvedIP) { return true; }
+	void processNextRequest() {}
+	void stop() {}
+};
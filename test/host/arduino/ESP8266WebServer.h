@@ -0,0 +1,28 @@
+#pragma once
+
+// Host stand-in for the config web server, nothing ever connects to it
+
+#include <ESP8266WiFi.h>
+
+class ESP8266WebServer
+{
+public:
+	typedef std::function<void(void)> THandlerFunction;
+
+	ESP8266WebServer(int port = 80) {}
+	void begin() {}
+	void stop() {}
+	void close() {}
+	void handleClient() {}
+	void on(const String &uri, THandlerFunction handler) {}
+	void onNotFound(THandlerFunction handler) {}
+	String arg(const String &name) { return String(); }
+	String arg(int i) { return String(); }
+	String argName(int i) { return String(); }
+	int args() { return 0; }
+	bool hasArg(const String &name) { return false; }
+	String uri() { return String("/"); }
+	void sendHeader(const String &name, const String &value, bool first = false) {}
+	void send(int code, const char *contentType, const String &content) {}
+	void send(int code, const char *contentType = NULL, const char *content = NULL) {}
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+// Host stand-in for the ESP8266 WiFi stack. The networks a scan finds are
+// set with hostSetWiFiNetworks, joining one of them connects at once.
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <WiFiClientSecure.h>
+
+class IPAddress
+{
+public:
+	IPAddress() : address(0) {}
+	IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+	String toString() const;
+
+private:
+	uint32_t address;
+};
+
+typedef enum
+{
+	WL_NO_SHIELD = 255,
+	WL_IDLE_STATUS = 0,
+	WL_NO_SSID_AVAIL = 1,
+	WL_SCAN_COMPLETED = 2,
+	WL_CONNECTED = 3,
+	WL_CONNECT_FAILED = 4,
+	WL_CONNECTION_LOST = 5,
+	WL_WRONG_PASSWORD = 6,
+	WL_DISCONNECTED = 7
+} wl_status_t;
+
+typedef enum
+{
+	WIFI_OFF = 0,
+	WIFI_STA = 1,
+	WIFI_AP = 2,
+	WIFI_AP_STA = 3
+} WiFiMode_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+class ESP8266WiFiClass
+{
+public:
+	bool mode(WiFiMode_t mode);
+	wl_status_t begin(const char *ssid, const char *password = NULL);
+	wl_status_t status();
+	bool disconnect(bool wifiOff = false);
+	int8_t scanNetworks(bool async = false);
+	int8_t scanComplete();
+	void scanDelete();
+	String SSID(uint8_t networkItem);
+	String SSID();
+	int32_t RSSI() { return -50; }
+	bool softAP(const char *ssid, const char *password = NULL);
+	IPAddress localIP();
+	IPAddress softAPIP();
+	String macAddress() { return String("5C:CF:7F:00:00:01"); }
+};
+
+extern ESP8266WiFiClass WiFi;
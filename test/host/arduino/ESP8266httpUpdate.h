@@ -0,0 +1,31 @@
+#pragma once
+
+// Host stand-in for the OTA updater, an update never finds new firmware
+
+#include <ESP8266WiFi.h>
+
+enum HTTPUpdateResult
+{
+	HTTP_UPDATE_FAILED,
+	HTTP_UPDATE_NO_UPDATES,
+	HTTP_UPDATE_OK
+};
+
+typedef HTTPUpdateResult t_httpUpdate_return;
+
+class ESP8266HTTPUpdate
+{
+public:
+	void onStart(std::function<void()> callback) {}
+	void onEnd(std::function<void()> callback) {}
+	void onProgress(std::function<void(int, int)> callback) {}
+	void onError(std::function<void(int)> callback) {}
+	t_httpUpdate_return update(WiFiClient &client, const String &url, const String &currentVersion = "")
+	{
+		return HTTP_UPDATE_NO_UPDATES;
+	}
+	int getLastError() { return 0; }
+	String getLastErrorString() { return String("host build"); }
+};
+
+extern ESP8266HTTPUpdate ESPhttpUpdate;
@@ -0,0 +1,267 @@
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "FS.h"
+#include "LittleFS.h"
+#include "hostArduino.h"
+
+namespace fs = std::filesystem;
+
+FS LittleFS;
+
+std::string hostFileSystemRoot = "host_fs";
+
+void hostSetFileSystemRoot(const char *path)
+{
+	hostFileSystemRoot = path;
+}
+
+static fs::path hostPath(const char *path)
+{
+	while (*path == '/')
+	{
+		path++;
+	}
+	return fs::path(hostFileSystemRoot) / path;
+}
+
+struct HostFile
+{
+	std::string name;
+	fs::path path;
+	FILE *file;
+	bool directory;
+	std::vector<std::string> entries;
+	size_t nextEntry;
+
+	~HostFile()
+	{
+		if (file != NULL)
+		{
+			fclose(file);
+		}
+	}
+};
+
+static File openHostFile(const char *path, const char *mode)
+{
+	fs::path hostFilePath = hostPath(path);
+	std::error_code error;
+
+	std::shared_ptr<HostFile> result = std::make_shared<HostFile>();
+	result->name = hostFilePath.filename().string();
+	result->path = hostFilePath;
+	result->file = NULL;
+	result->directory = false;
+	result->nextEntry = 0;
+
+	if (fs::is_directory(hostFilePath, error))
+	{
+		result->directory = true;
+
+		for (const fs::directory_entry &entry : fs::directory_iterator(hostFilePath, error))
+		{
+			result->entries.push_back(entry.path().filename().string());
+		}
+		std::sort(result->entries.begin(), result->entries.end());
+
+		return File(result);
+	}
+
+	const char *hostMode;
+
+	switch (mode[0])
+	{
+	case 'w':
+		hostMode = mode[1] == '+' ? "w+b" : "wb";
+		break;
+	case 'a':
+		hostMode = mode[1] == '+' ? "a+b" : "ab";
+		break;
+	default:
+		hostMode = mode[1] == '+' ? "r+b" : "rb";
+	}
+
+	if (hostMode[0] != 'r')
+	{
+		// LittleFS makes the folders a new file needs
+		fs::create_directories(hostFilePath.parent_path(), error);
+	}
+
+	result->file = fopen(hostFilePath.c_str(), hostMode);
+
+	if (result->file == NULL)
+	{
+		return File();
+	}
+
+	return File(result);
+}
+
+File::operator bool() const
+{
+	return file != NULL && (file->directory || file->file != NULL);
+}
+
+void File::close()
+{
+	file.reset();
+}
+
+size_t File::size()
+{
+	if (!*this || file->directory)
+	{
+		return 0;
+	}
+
+	long position = ftell(file->file);
+	fseek(file->file, 0, SEEK_END);
+	long size = ftell(file->file);
+	fseek(file->file, position, SEEK_SET);
+	return size;
+}
+
+const char *File::name()
+{
+	return file ? file->name.c_str() : "";
+}
+
+bool File::isDirectory()
+{
+	return file && file->directory;
+}
+
+File File::openNextFile()
+{
+	if (!isDirectory() || file->nextEntry >= file->entries.size())
+	{
+		return File();
+	}
+
+	fs::path entryPath = file->path / file->entries[file->nextEntry++];
+	std::string entryName = "/" + fs::relative(entryPath, hostFileSystemRoot).string();
+	return openHostFile(entryName.c_str(), "r");
+}
+
+bool File::seek(uint32_t position)
+{
+	if (!*this || file->directory)
+	{
+		return false;
+	}
+	return fseek(file->file, position, SEEK_SET) == 0;
+}
+
+size_t File::position()
+{
+	if (!*this || file->directory)
+	{
+		return 0;
+	}
+	return ftell(file->file);
+}
+
+size_t File::write(uint8_t c)
+{
+	return write(&c, 1);
+}
+
+size_t File::write(const uint8_t *buffer, size_t size)
+{
+	if (!*this || file->directory)
+	{
+		return 0;
+	}
+	return fwrite(buffer, 1, size, file->file);
+}
+
+int File::available()
+{
+	if (!*this || file->directory)
+	{
+		return 0;
+	}
+	return size() - position();
+}
+
+int File::read()
+{
+	if (!*this || file->directory)
+	{
+		return -1;
+	}
+	return fgetc(file->file);
+}
+
+int File::peek()
+{
+	int c = read();
+	if (c >= 0)
+	{
+		ungetc(c, file->file);
+	}
+	return c;
+}
+
+size_t File::read(uint8_t *buffer, size_t size)
+{
+	if (!*this || file->directory)
+	{
+		return 0;
+	}
+	return fread(buffer, 1, size, file->file);
+}
+
+bool FS::begin()
+{
+	std::error_code error;
+	fs::create_directories(hostFileSystemRoot, error);
+	return fs::is_directory(hostFileSystemRoot, error);
+}
+
+bool FS::format()
+{
+	std::error_code error;
+	fs::remove_all(hostFileSystemRoot, error);
+	return begin();
+}
+
+File FS::open(const char *path, const char *mode)
+{
+	return openHostFile(path, mode);
+}
+
+bool FS::exists(const char *path)
+{
+	std::error_code error;
+	return fs::exists(hostPath(path), error);
+}
+
+bool FS::remove(const char *path)
+{
+	std::error_code error;
+	return fs::is_regular_file(hostPath(path), error) && fs::remove(hostPath(path), error);
+}
+
+bool FS::rename(const char *from, const char *to)
+{
+	std::error_code error;
+	fs::rename(hostPath(from), hostPath(to), error);
+	return !error;
+}
+
+bool FS::mkdir(const char *path)
+{
+	std::error_code error;
+	fs::create_directories(hostPath(path), error);
+	return fs::is_directory(hostPath(path), error);
+}
+
+bool FS::rmdir(const char *path)
+{
+	std::error_code error;
+	return fs::remove(hostPath(path), error);
+}
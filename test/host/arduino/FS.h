@@ -0,0 +1,55 @@
+#pragma once
+
+// Host stand-in for the Arduino file system, files live in a directory on
+// the host (see hostSetFileSystemRoot)
+
+#include <Arduino.h>
+#include <memory>
+
+struct HostFile;
+
+class File : public Stream
+{
+public:
+	File() {}
+	File(std::shared_ptr<HostFile> file) : file(file) {}
+
+	operator bool() const;
+	void close();
+	size_t size();
+	const char *name();
+	bool isDirectory();
+	File openNextFile();
+	bool seek(uint32_t position);
+	size_t position();
+
+	size_t write(uint8_t c) override;
+	size_t write(const uint8_t *buffer, size_t size) override;
+	using Print::write;
+	int available() override;
+	int read() override;
+	int peek() override;
+	size_t read(uint8_t *buffer, size_t size);
+
+private:
+	std::shared_ptr<HostFile> file;
+};
+
+class FS
+{
+public:
+	bool begin();
+	bool begin(bool formatOnFail) { return begin(); }
+	void end() {}
+	bool format();
+	File open(const char *path, const char *mode);
+	File open(const String &path, const char *mode) { return open(path.c_str(), mode); }
+	bool exists(const char *path);
+	bool exists(const String &path) { return exists(path.c_str()); }
+	bool remove(const char *path);
+	bool remove(const String &path) { return remove(path.c_str()); }
+	bool rename(const char *from, const char *to);
+	bool mkdir(const char *path);
+	bool mkdir(const String &path) { return mkdir(path.c_str()); }
+	bool rmdir(const char *path);
+};
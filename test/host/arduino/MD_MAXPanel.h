@@ -0,0 +1,52 @@
+#pragma once
+
+// Host stand-in for the MAX7219 panel driver, the panel draws nothing
+
+#include <Arduino.h>
+
+class MD_MAX72XX
+{
+public:
+	enum moduleType_t
+	{
+		GENERIC_HW,
+		FC16_HW,
+		PAROLA_HW,
+		ICSTATION_HW
+	};
+	typedef const uint8_t fontType_t;
+};
+
+extern const uint8_t _sysfont[];
+
+class MD_MAXPanel
+{
+public:
+	enum rotation_t
+	{
+		ROT_0,
+		ROT_90,
+		ROT_180,
+		ROT_270
+	};
+
+	MD_MAXPanel(MD_MAX72XX::moduleType_t mod, uint8_t dataPin, uint8_t clkPin, uint8_t csPin, uint8_t xDevices, uint8_t yDevices)
+		: xDevices(xDevices), yDevices(yDevices) {}
+
+	void begin() {}
+	void clear() {}
+	void update(bool state) {}
+	void update() {}
+	void setIntensity(uint8_t intensity) {}
+	bool setFont(MD_MAX72XX::fontType_t *font) { return true; }
+	uint16_t getXMax() { return xDevices * 8 - 1; }
+	uint16_t getYMax() { return yDevices * 8 - 1; }
+	uint16_t drawText(int16_t x, int16_t y, const char *text, rotation_t rot = ROT_0, bool state = true)
+	{
+		return strlen(text) * 4;
+	}
+
+private:
+	uint8_t xDevices;
+	uint8_t yDevices;
+};
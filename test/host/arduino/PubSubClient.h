@@ -0,0 +1,43 @@
+#pragma once
+
+// Host stand-in for PubSubClient. It connects while the host WiFi is up,
+// records what is published and hands messages queued by hostMQTTDeliver to
+// the callback from loop(), as the real client does.
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+#define MQTT_CONNECT_BAD_PROTOCOL 1
+#define MQTT_CONNECT_BAD_CLIENT_ID 2
+#define MQTT_CONNECT_UNAVAILABLE 3
+#define MQTT_CONNECT_BAD_CREDENTIALS 4
+#define MQTT_CONNECT_UNAUTHORIZED 5
+
+#define MQTT_CALLBACK_SIGNATURE void (*callback)(char *, uint8_t *, unsigned int)
+
+class PubSubClient
+{
+public:
+	PubSubClient() {}
+	PubSubClient(Client &client) {}
+
+	PubSubClient &setServer(const char *domain, uint16_t port) { return *this; }
+	PubSubClient &setCallback(MQTT_CALLBACK_SIGNATURE);
+	PubSubClient &setClient(Client &client) { return *this; }
+	bool setBufferSize(uint16_t size) { return true; }
+
+	bool connect(const char *id);
+	bool connect(const char *id, const char *user, const char *pass);
+	void disconnect();
+	bool connected();
+	int state();
+	bool publish(const char *topic, const char *payload);
+	bool publish(const char *topic, const uint8_t *payload, unsigned int length);
+	bool subscribe(const char *topic);
+	bool loop();
+};
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <Arduino.h>
+
+class Servo
+{
+public:
+	uint8_t attach(int pin) { return 0; }
+	uint8_t attach(int pin, int min, int max) { return 0; }
+	void detach() {}
+	void write(int value) {}
+	void writeMicroseconds(int value) {}
+	int read() { return 0; }
+	bool attached() { return false; }
+};
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <Arduino.h>
+
+class Client : public Stream
+{
+public:
+	size_t write(uint8_t c) override { return 1; }
+	using Print::write;
+	int available() override { return 0; }
+	int read() override { return -1; }
+	int peek() override { return -1; }
+};
+
+class WiFiClient : public Client
+{
+};
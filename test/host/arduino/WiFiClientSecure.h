@@ -0,0 +1,9 @@
+#pragma once
+
+#include <WiFiClient.h>
+
+class WiFiClientSecure : public WiFiClient
+{
+public:
+	void setInsecure() {}
+};
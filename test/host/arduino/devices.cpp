@@ -0,0 +1,407 @@
+#include <string>
+#include <vector>
+#include <deque>
+#include <time.h>
+
+#include "Arduino.h"
+#include "ESP8266WiFi.h"
+#include "PubSubClient.h"
+#include "ESP8266httpUpdate.h"
+#include "ezTime.h"
+#include "Adafruit_NeoPixel.h"
+#include "MD_MAXPanel.h"
+#include "hostArduino.h"
+
+// WiFi
+
+ESP8266WiFiClass WiFi;
+
+std::vector<std::string> hostWiFiNetworks;
+wl_status_t hostWiFiStatus = WL_DISCONNECTED;
+std::string hostWiFiSSID;
+
+void hostAddWiFiNetwork(const char *ssid)
+{
+	hostWiFiNetworks.push_back(ssid);
+}
+
+String IPAddress::toString() const
+{
+	char buffer[16];
+	snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u",
+			 address & 0xff, (address >> 8) & 0xff, (address >> 16) & 0xff, address >> 24);
+	return String(buffer);
+}
+
+bool ESP8266WiFiClass::mode(WiFiMode_t mode)
+{
+	if (mode == WIFI_OFF)
+	{
+		hostWiFiStatus = WL_DISCONNECTED;
+	}
+	return true;
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char *ssid, const char *password)
+{
+	hostWiFiStatus = WL_NO_SSID_AVAIL;
+
+	for (size_t i = 0; i < hostWiFiNetworks.size(); i++)
+	{
+		if (hostWiFiNetworks[i] == ssid)
+		{
+			hostWiFiSSID = ssid;
+			hostWiFiStatus = WL_CONNECTED;
+		}
+	}
+
+	return hostWiFiStatus;
+}
+
+wl_status_t ESP8266WiFiClass::status()
+{
+	return hostWiFiStatus;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifiOff)
+{
+	hostWiFiStatus = WL_DISCONNECTED;
+	return true;
+}
+
+// scans finish straight away
+
+int8_t ESP8266WiFiClass::scanNetworks(bool async)
+{
+	return hostWiFiNetworks.size();
+}
+
+int8_t ESP8266WiFiClass::scanComplete()
+{
+	return hostWiFiNetworks.size();
+}
+
+void ESP8266WiFiClass::scanDelete()
+{
+}
+
+String ESP8266WiFiClass::SSID(uint8_t networkItem)
+{
+	if (networkItem >= hostWiFiNetworks.size())
+	{
+		return String();
+	}
+	return String(hostWiFiNetworks[networkItem].c_str());
+}
+
+String ESP8266WiFiClass::SSID()
+{
+	return String(hostWiFiSSID.c_str());
+}
+
+bool ESP8266WiFiClass::softAP(const char *ssid, const char *password)
+{
+	return true;
+}
+
+IPAddress ESP8266WiFiClass::localIP()
+{
+	return hostWiFiStatus == WL_CONNECTED ? IPAddress(192, 168, 1, 42) : IPAddress();
+}
+
+IPAddress ESP8266WiFiClass::softAPIP()
+{
+	return IPAddress(192, 168, 4, 1);
+}
+
+// MQTT
+
+bool hostMQTTBrokerUp = true;
+bool hostMQTTConnected = false;
+void (*hostMQTTCallback)(char *, uint8_t *, unsigned int) = NULL;
+void (*hostMQTTPublishHook)(const char *topic, const char *payload) = NULL;
+unsigned long hostMQTTPublished = 0;
+
+struct HostMQTTMessage
+{
+	std::string topic;
+	std::string payload;
+};
+
+std::deque<HostMQTTMessage> hostMQTTIncoming;
+int hostMQTTMessagesPerLoop = 1;
+
+void hostSetMQTTBrokerUp(bool up)
+{
+	hostMQTTBrokerUp = up;
+}
+
+void hostMQTTDeliver(const char *topic, const char *payload)
+{
+	HostMQTTMessage message = {topic, payload};
+	hostMQTTIncoming.push_back(message);
+}
+
+int hostMQTTPending()
+{
+	return hostMQTTIncoming.size();
+}
+
+void hostSetMQTTMessagesPerLoop(int messages)
+{
+	hostMQTTMessagesPerLoop = messages;
+}
+
+void hostSetMQTTPublishHook(void (*hook)(const char *topic, const char *payload))
+{
+	hostMQTTPublishHook = hook;
+}
+
+unsigned long hostMQTTPublishCount()
+{
+	return hostMQTTPublished;
+}
+
+PubSubClient &PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE)
+{
+	hostMQTTCallback = callback;
+	return *this;
+}
+
+bool PubSubClient::connect(const char *id)
+{
+	hostMQTTConnected = hostMQTTBrokerUp && WiFi.status() == WL_CONNECTED;
+	return hostMQTTConnected;
+}
+
+bool PubSubClient::connect(const char *id, const char *user, const char *pass)
+{
+	return connect(id);
+}
+
+void PubSubClient::disconnect()
+{
+	hostMQTTConnected = false;
+}
+
+bool PubSubClient::connected()
+{
+	if (!hostMQTTBrokerUp || WiFi.status() != WL_CONNECTED)
+	{
+		hostMQTTConnected = false;
+	}
+	return hostMQTTConnected;
+}
+
+int PubSubClient::state()
+{
+	if (connected())
+	{
+		return MQTT_CONNECTED;
+	}
+	return hostMQTTBrokerUp ? MQTT_DISCONNECTED : MQTT_CONNECT_UNAVAILABLE;
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload)
+{
+	if (!connected())
+	{
+		return false;
+	}
+
+	hostMQTTPublished++;
+
+	if (hostMQTTPublishHook != NULL)
+	{
+		hostMQTTPublishHook(topic, payload);
+	}
+
+	return true;
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int length)
+{
+	std::string text((const char *)payload, length);
+	return publish(topic, text.c_str());
+}
+
+bool PubSubClient::subscribe(const char *topic)
+{
+	return connected();
+}
+
+bool PubSubClient::loop()
+{
+	if (!connected())
+	{
+		return false;
+	}
+
+	int delivered = 0;
+
+	while (!hostMQTTIncoming.empty() && hostMQTTCallback != NULL &&
+		   (hostMQTTMessagesPerLoop == 0 || delivered < hostMQTTMessagesPerLoop))
+	{
+		// the real client passes its own buffer, which the callback may not keep
+		HostMQTTMessage message = hostMQTTIncoming.front();
+		hostMQTTIncoming.pop_front();
+
+		std::vector<char> topic(message.topic.begin(), message.topic.end());
+		topic.push_back(0);
+		std::vector<uint8_t> payload(message.payload.begin(), message.payload.end());
+		payload.push_back(0);
+
+		hostMQTTCallback(topic.data(), payload.data(), message.payload.length());
+		delivered++;
+	}
+
+	return true;
+}
+
+// OTA update
+
+ESP8266HTTPUpdate ESPhttpUpdate;
+
+// time
+
+Timezone UTC;
+
+static struct tm hostTime()
+{
+	time_t now = time(NULL);
+	struct tm result;
+	gmtime_r(&now, &result);
+	return result;
+}
+
+bool Timezone::setLocation(const String &location)
+{
+	return true;
+}
+
+String Timezone::dateTime(const String &format)
+{
+	struct tm now = hostTime();
+	char buffer[32];
+	strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S+00:00", &now);
+	return String(buffer);
+}
+
+uint8_t Timezone::hour()
+{
+	return hostTime().tm_hour;
+}
+
+uint8_t Timezone::minute()
+{
+	return hostTime().tm_min;
+}
+
+uint8_t Timezone::second()
+{
+	return hostTime().tm_sec;
+}
+
+uint8_t Timezone::day()
+{
+	return hostTime().tm_mday;
+}
+
+uint8_t Timezone::month()
+{
+	return hostTime().tm_mon + 1;
+}
+
+uint16_t Timezone::year()
+{
+	return hostTime().tm_year + 1900;
+}
+
+uint8_t Timezone::weekday()
+{
+	return hostTime().tm_wday + 1;
+}
+
+timeStatus_t timeStatus()
+{
+	return timeSet;
+}
+
+bool waitForSync(uint16_t timeout)
+{
+	return true;
+}
+
+void events()
+{
+}
+
+// pixels
+
+void (*hostPixelShowHook)(const uint8_t *pixels, int noOfPixels) = NULL;
+
+void hostSetPixelShowHook(void (*hook)(const uint8_t *pixels, int noOfPixels))
+{
+	hostPixelShowHook = hook;
+}
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t pin, neoPixelType type)
+{
+	numLEDs = n;
+	pixels = new uint8_t[n * 3];
+	memset(pixels, 0, n * 3);
+	rOffset = (type >> 4) & 3;
+	gOffset = (type >> 2) & 3;
+	bOffset = type & 3;
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel()
+{
+	delete[] pixels;
+}
+
+void Adafruit_NeoPixel::show()
+{
+	if (hostPixelShowHook != NULL)
+	{
+		hostPixelShowHook(pixels, numLEDs);
+	}
+}
+
+void Adafruit_NeoPixel::clear()
+{
+	memset(pixels, 0, numLEDs * 3);
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+{
+	if (n >= numLEDs)
+	{
+		return;
+	}
+
+	uint8_t *p = pixels + n * 3;
+	p[rOffset] = r;
+	p[gOffset] = g;
+	p[bOffset] = b;
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c)
+{
+	setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c);
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const
+{
+	if (n >= numLEDs)
+	{
+		return 0;
+	}
+
+	const uint8_t *p = pixels + n * 3;
+	return ((uint32_t)p[rOffset] << 16) | ((uint32_t)p[gOffset] << 8) | p[bOffset];
+}
+
+// MAX7219 panel
+
+const uint8_t _sysfont[] = {0};
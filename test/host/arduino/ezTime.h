@@ -0,0 +1,35 @@
+#pragma once
+
+// Host stand-in for ezTime, the time is always synced and comes from the
+// host clock in UTC
+
+#include <Arduino.h>
+
+#define RFC3339 "Y-m-d~TH:i:sP"
+
+enum timeStatus_t
+{
+	timeNotSet,
+	timeNeedsSync,
+	timeSet
+};
+
+class Timezone
+{
+public:
+	bool setLocation(const String &location = "");
+	String dateTime(const String &format = "");
+	uint8_t hour();
+	uint8_t minute();
+	uint8_t second();
+	uint8_t day();
+	uint8_t month();
+	uint16_t year();
+	uint8_t weekday();
+};
+
+extern Timezone UTC;
+
+timeStatus_t timeStatus();
+bool waitForSync(uint16_t timeout = 0);
+void events();
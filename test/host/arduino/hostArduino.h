@@ -0,0 +1,63 @@
+#pragma once
+
+// Controls for the host stand-ins, used by the host benchmarks and tests to
+// drive the firmware as the board and the network would
+
+#include <Arduino.h>
+
+// The host clock runs in real time, but delay() moves it on without
+// sleeping so a benchmark is not held up by the loop's sleep. When the clock
+// is frozen it only moves with delay() and hostAdvanceMillis, which makes
+// runs repeatable.
+
+void hostFreezeClock(bool frozen);
+void hostAdvanceMillis(unsigned long ms);
+
+// Time asked for by delay() since the counts were reset
+
+unsigned long hostDelayMillis();
+unsigned long hostDelayCalls();
+void hostResetDelayCounts();
+
+// Serial output goes to stdout unless it is turned off, Serial input is
+// read from text given here
+
+void hostSerialOutput(bool on);
+void hostSerialInput(const char *text);
+
+// Called with everything written to Serial, whether or not it is shown
+
+void hostSetSerialOutputHook(void (*hook)(const char *text, size_t length));
+
+// Files are stored under this host directory, "host_fs" unless set
+
+void hostSetFileSystemRoot(const char *path);
+
+// Input pin levels
+
+void hostSetDigitalInput(int pin, int value);
+void hostSetAnalogInput(int pin, int value);
+
+// A WiFi scan finds the networks added here and the MQTT broker accepts
+// connections while it is up
+
+void hostAddWiFiNetwork(const char *ssid);
+void hostSetMQTTBrokerUp(bool up);
+
+// Messages from the broker are held until the client loop() runs, which
+// hands them to the callback. The real client hands over one message for
+// each loop(), a number of 0 hands over all of them in one go, as if a burst
+// had been read at once.
+
+void hostMQTTDeliver(const char *topic, const char *payload);
+int hostMQTTPending();
+void hostSetMQTTMessagesPerLoop(int messages);
+
+// Called for each message the client publishes
+
+void hostSetMQTTPublishHook(void (*hook)(const char *topic, const char *payload));
+unsigned long hostMQTTPublishCount();
+
+// Called with the strip buffer each time the pixels are shown
+
+void hostSetPixelShowHook(void (*hook)(const uint8_t *pixels, int noOfPixels));
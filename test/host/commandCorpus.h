@@ -0,0 +1,19 @@
+#pragma once
+
+// Commands of the kind sent to a box over MQTT, for the command benchmark
+// and the parser test
+
+const char *const commandCorpus[] = {
+	"{\"process\":\"pixels\",\"command\":\"setcolour\",\"red\":1,\"green\":0.5,\"blue\":0,\"steps\":20}",
+	"{\"process\":\"pixels\",\"command\":\"setnamedcolour\",\"colourname\":\"magenta\",\"steps\":10,\"seq\":12}",
+	"{\"process\":\"pixels\",\"command\":\"brightness\",\"value\":0.5,\"steps\":5}",
+	"{\"process\":\"pixels\",\"command\":\"setrandomcolour\",\"sensor\":\"button\",\"trigger\":\"pressed\"}",
+	"{\"process\":\"pixels\",\"command\":\"map\",\"sensor\":\"pot\",\"trigger\":\"changed\",\"options\":\"\",\"steps\":2,\"colourmask\":\"RGB\"}",
+	"{\"process\":\"console\",\"command\":\"reporttext\",\"text\":\"hello \\\"world\\\"\\n\",\"to\":\"\"}",
+	"{\"process\":\"controller\",\"command\":\"perform\",\"store\":\"start\"}",
+	"{\"process\":\"pixels\",\"command\":\"nosuchcommand\"}",
+	"{\"setting\":\"pixelcontrolpin\",\"seq\":\"7\"}",
+	"{ process:'pixels', command:'pattern', pattern:'wander', steps:-1e2, \"store\":\"start\", \"id\":\"boot\" }",
+	"{process:pixels,command:setnamedcolour,colourname:red,steps:5}"};
+
+const int commandCorpusSize = sizeof(commandCorpus) / sizeof(const char *);
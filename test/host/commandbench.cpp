@@ -0,0 +1,88 @@
+// Command benchmark
+// Boots the firmware on the host and times act_onJson_message over a corpus
+// of commands, decoded and validated but not performed.
+//
+// commandbench [repeats] [--quick]
+
+#include <time.h>
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "hostArduino.h"
+#include "controller.h"
+#include "commandCorpus.h"
+
+void setup();
+
+#define COMMAND_BENCH_REPEATS 100000
+#define COMMAND_BENCH_QUICK_REPEATS 1000
+
+int commandBenchReplies;
+int commandBenchErrors;
+
+void commandBenchResult(char *resultText)
+{
+	commandBenchReplies++;
+	if (strstr(resultText, "\"error\":0,") == NULL)
+	{
+		commandBenchErrors++;
+	}
+}
+
+unsigned long long nanosNow()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+int main(int argc, char **argv)
+{
+	int repeats = COMMAND_BENCH_REPEATS;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			repeats = COMMAND_BENCH_QUICK_REPEATS;
+		}
+		else
+		{
+			repeats = atoi(argv[i]);
+		}
+	}
+
+	// the default settings
+	LittleFS.format();
+
+	hostSerialOutput(false);
+	setup();
+
+	commandBenchReplies = 0;
+	commandBenchErrors = 0;
+	performDecodedCommands = false;
+
+	unsigned long long startNanos = nanosNow();
+
+	for (int i = 0; i < repeats; i++)
+	{
+		for (int j = 0; j < commandCorpusSize; j++)
+		{
+			act_onJson_message(commandCorpus[j], commandBenchResult);
+		}
+	}
+
+	unsigned long long elapsedNanos = nanosNow() - startNanos;
+
+	performDecodedCommands = true;
+
+	hostSerialOutput(true);
+
+	printf("Commands:%d in %.3f secs (%.0f per sec, %.1f nanosecs each) rejected:%d\n",
+		   commandBenchReplies, elapsedNanos / 1e9,
+		   elapsedNanos ? commandBenchReplies * 1e9 / elapsedNanos : 0.0,
+		   commandBenchReplies ? (double)elapsedNanos / commandBenchReplies : 0.0,
+		   commandBenchErrors);
+
+	return 0;
+}
@@ -0,0 +1,156 @@
+// HullOS bench
+// Boots the firmware on the host and runs a loop heavy HullOS program through
+// the text interpreter and then through the bytecode, timing each. It fails
+// if the program doesn't compile or the two leave different variable values.
+//
+// hullosbench [repeats] [--quick]
+
+#include <time.h>
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "hostArduino.h"
+#include "HullOS.h"
+#include "HullOSCommands.h"
+#include "HullOSVariables.h"
+#include "HullOSBytecode.h"
+
+void setup();
+
+#define HULLOS_BENCH_REPEATS 100
+#define HULLOS_BENCH_QUICK_REPEATS 1
+
+// Stops a run if the bench program doesn't end
+
+#define HULLOS_BENCH_STATEMENT_LIMIT 100000
+
+// Loop heavy program in the stored program format
+
+const char hullosBenchProgram[] =
+	"VSi=0\r"
+	"VSj=0\r"
+	"CLl1\r"
+	"CFi<2000,l2\r"
+	"VSj=i%7\r"
+	"VSi=i+1\r"
+	"CJl1\r"
+	"CLl2\r";
+
+static_assert(sizeof(hullosBenchProgram) <= HULLOS_PROGRAM_SIZE - STORED_PROGRAM_OFFSET,
+			  "HullOS bench program does not fit in the program store");
+
+unsigned long long nanosNow()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+unsigned long long runHullOSBench(bool useBytecode, long *statements, int *values)
+{
+	hullosBytecodeEnabled = useBytecode;
+
+	startProgramExecution(STORED_PROGRAM_OFFSET);
+
+	long count = 0;
+
+	unsigned long long startNanos = nanosNow();
+
+	while ((hullosTask->programState == PROGRAM_ACTIVE) && (count < HULLOS_BENCH_STATEMENT_LIMIT))
+	{
+		exeuteProgramStatement();
+		count++;
+	}
+
+	unsigned long long benchNanos = nanosNow() - startNanos;
+
+	haltProgramExecution();
+
+	for (int i = 0; i < NUMBER_OF_VARIABLES; i++)
+	{
+		values[i] = variableStore->variables[i].value;
+	}
+
+	*statements = count;
+	return benchNanos;
+}
+
+double statementsPerSecond(long statements, unsigned long long nanos)
+{
+	if (nanos == 0)
+	{
+		return 0;
+	}
+	return statements * 1e9 / nanos;
+}
+
+int main(int argc, char **argv)
+{
+	int repeats = HULLOS_BENCH_REPEATS;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			repeats = HULLOS_BENCH_QUICK_REPEATS;
+		}
+		else
+		{
+			repeats = atoi(argv[i]);
+		}
+	}
+
+	// the default settings, which have no program running
+	LittleFS.format();
+
+	hostSerialOutput(false);
+	setup();
+	hostSerialOutput(true);
+
+	selectHullOSTask(&hullosTasks[0]);
+
+	memcpy(hullosSettings.hullosCode + STORED_PROGRAM_OFFSET, hullosBenchProgram, sizeof(hullosBenchProgram));
+	invalidateLabelIndex();
+
+	long textStatements = 0;
+	long bytecodeStatements = 0;
+	unsigned long long textNanos = 0;
+	unsigned long long bytecodeNanos = 0;
+	int textValues[NUMBER_OF_VARIABLES];
+	int bytecodeValues[NUMBER_OF_VARIABLES];
+	bool compiled = true;
+	bool match = true;
+
+	for (int i = 0; i < repeats; i++)
+	{
+		long statements;
+
+		textNanos += runHullOSBench(false, &statements, textValues);
+		textStatements += statements;
+
+		bytecodeNanos += runHullOSBench(true, &statements, bytecodeValues);
+		bytecodeStatements += statements;
+
+		compiled = compiled && hullosTask->bytecodeReady;
+		match = match && memcmp(textValues, bytecodeValues, sizeof(textValues)) == 0;
+	}
+
+	// Both runs perform the same program statements, so the rates are
+	// given in statements of the program text
+
+	printf("HullOS text: %ld statements in %.3f secs (%.0f statements/sec)\n",
+		   textStatements, textNanos / 1e9, statementsPerSecond(textStatements, textNanos));
+
+	if (!compiled)
+	{
+		printf("FAIL: bench program did not compile\n");
+		return 1;
+	}
+
+	printf("HullOS bytecode: %ld instructions in %.3f secs (%.0f statements/sec)\n",
+		   bytecodeStatements, bytecodeNanos / 1e9, statementsPerSecond(textStatements, bytecodeNanos));
+
+	printf("%s: results %s\n", match ? "PASS" : "FAIL", match ? "match" : "differ");
+
+	return match ? 0 : 1;
+}
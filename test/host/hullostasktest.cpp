@@ -0,0 +1,125 @@
+// HullOS task test
+// Boots the firmware on the host and starts HullOS tasks from the console
+// with the "hullos run" command. With nothing in the program store it must
+// say that no program is stored, without taking a task, and only once a
+// program is stored and every task is busy must it say there is no free task.
+//
+// hullostasktest
+
+#include <string>
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "hostArduino.h"
+#include "HullOS.h"
+#include "HullOSCommands.h"
+
+void setup();
+void loop();
+
+#define HULLOS_TEST_LOOPS 100
+
+#define NO_PROGRAM_MESSAGE "No HullOS program stored"
+#define NO_FREE_TASK_MESSAGE "No free HullOS task"
+#define TASK_RUNNING_MESSAGE "running the program"
+
+// a program that never ends, so the tasks stay busy
+const char hullosTestProgram[] =
+	"CLl1\r"
+	"CJl1\r";
+
+std::string hullosTestOutput;
+
+void hullosTestSerialOutput(const char *text, size_t length)
+{
+	hullosTestOutput.append(text, length);
+}
+
+// sends the console command and returns what the device printed
+
+const char *runConsoleCommand(const char *command)
+{
+	hullosTestOutput.clear();
+
+	hostSerialInput(command);
+
+	for (int i = 0; i < HULLOS_TEST_LOOPS; i++)
+	{
+		loop();
+	}
+
+	return hullosTestOutput.c_str();
+}
+
+int countTasksInUse()
+{
+	int inUse = 0;
+
+	// task 0 belongs to the serial port
+	for (int i = 1; i < HULLOS_MAX_TASKS; i++)
+	{
+		if (hullosTasks[i].inUse)
+		{
+			inUse++;
+		}
+	}
+
+	return inUse;
+}
+
+bool checkRun(const char *name, const char *expected, const char *unexpected, int expectedTasks)
+{
+	const char *output = runConsoleCommand("hullos run\n");
+
+	bool ok = strstr(output, expected) != NULL &&
+			  (unexpected == NULL || strstr(output, unexpected) == NULL) &&
+			  countTasksInUse() == expectedTasks;
+
+	printf("%s: %s reports \"%s\" with %d tasks in use\n", ok ? "PASS" : "FAIL", name, expected, countTasksInUse());
+
+	if (!ok)
+	{
+		printf("   output:%s\n", output);
+	}
+
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	LittleFS.format();
+
+	hostSerialOutput(false);
+	setup();
+
+	hostSetSerialOutputHook(hullosTestSerialOutput);
+
+	bool ok = true;
+
+	// the default settings leave the program store empty
+	ok = checkRun("empty store", NO_PROGRAM_MESSAGE, NO_FREE_TASK_MESSAGE, 0) && ok;
+
+	bool started = startHullOSTask(STORED_PROGRAM_OFFSET) != NULL;
+	printf("%s: startHullOSTask with no program %s\n", started ? "FAIL" : "PASS",
+		   started ? "took a task" : "returns NULL");
+	ok = !started && ok;
+
+	memset(hullosSettings.hullosCode + STORED_PROGRAM_OFFSET, 0xFF, HULLOS_PROGRAM_SIZE - STORED_PROGRAM_OFFSET);
+	ok = checkRun("erased store", NO_PROGRAM_MESSAGE, NO_FREE_TASK_MESSAGE, 0) && ok;
+
+	memcpy(hullosSettings.hullosCode + STORED_PROGRAM_OFFSET, hullosTestProgram, sizeof(hullosTestProgram));
+	invalidateLabelIndex();
+
+	for (int i = 1; i < HULLOS_MAX_TASKS; i++)
+	{
+		ok = checkRun("stored program", TASK_RUNNING_MESSAGE, NO_PROGRAM_MESSAGE, i) && ok;
+	}
+
+	ok = checkRun("busy tasks", NO_FREE_TASK_MESSAGE, NO_PROGRAM_MESSAGE, HULLOS_MAX_TASKS - 1) && ok;
+
+	haltAllHullOSTasks();
+
+	hostSetSerialOutputHook(NULL);
+
+	return ok ? 0 : 1;
+}
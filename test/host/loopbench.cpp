@@ -0,0 +1,239 @@
+// Loop cycle benchmark
+// Boots the firmware on the host, connected to a WiFi network and an MQTT
+// broker, and runs loop() for a number of passes. It reports what each
+// process and sensor update costs and how long the loop asked to sleep.
+//
+// loopbench [passes] [--quick] [--min-sleep millisecs]
+//
+// With --min-sleep it fails if the average sleep is shorter than that, or if
+// any active process or sensor is still updated on every pass.
+
+#include <time.h>
+
+#include "Arduino.h"
+#include "hostArduino.h"
+#include "processes.h"
+#include "sensors.h"
+#include "schedule.h"
+
+void setup();
+void loop();
+
+#define LOOP_BENCH_PASSES 2000000
+#define LOOP_BENCH_QUICK_PASSES 20000
+
+#define LOOP_BENCH_SETTINGS "wifissid1=hostnet\n" \
+							"mqttactive=yes\n"    \
+							"mqtthost=broker.local\n"
+
+// Each process and sensor update is swapped for one that times it with the
+// host clock, which is finer than the micros() the firmware times with.
+
+#define MAX_TIMED_UPDATES 40
+
+struct timedUpdate
+{
+	const char *name;
+	void (*update)();
+	unsigned long calls;
+	unsigned long long nanos;
+};
+
+struct timedUpdate timedUpdates[MAX_TIMED_UPDATES];
+int noOfTimedUpdates = 0;
+
+unsigned long long nanosNow()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+template <int N>
+void timeUpdate()
+{
+	struct timedUpdate *t = &timedUpdates[N];
+	unsigned long long startNanos = nanosNow();
+	t->update();
+	t->nanos += nanosNow() - startNanos;
+	t->calls++;
+}
+
+typedef void (*updateFunction)();
+
+template <int N>
+struct timedUpdateTable
+{
+	static void fill(updateFunction *table)
+	{
+		timedUpdateTable<N - 1>::fill(table);
+		table[N - 1] = timeUpdate<N - 1>;
+	}
+};
+
+template <>
+struct timedUpdateTable<0>
+{
+	static void fill(updateFunction *table)
+	{
+	}
+};
+
+updateFunction timedUpdateFunctions[MAX_TIMED_UPDATES];
+
+updateFunction addTimedUpdate(const char *name, updateFunction update)
+{
+	if (noOfTimedUpdates == MAX_TIMED_UPDATES)
+	{
+		return update;
+	}
+
+	struct timedUpdate *t = &timedUpdates[noOfTimedUpdates];
+	t->name = name;
+	t->update = update;
+	t->calls = 0;
+	t->nanos = 0;
+	return timedUpdateFunctions[noOfTimedUpdates++];
+}
+
+extern struct process *allProcessList;
+extern struct process *activeProcessList;
+extern struct sensor *allSensorList;
+extern struct sensor *activeSensorList;
+
+void timeAllUpdates()
+{
+	timedUpdateTable<MAX_TIMED_UPDATES>::fill(timedUpdateFunctions);
+
+	for (struct process *p = allProcessList; p != NULL; p = p->nextAllProcesses)
+	{
+		p->udpateProcess = addTimedUpdate(p->processName, p->udpateProcess);
+	}
+
+	for (struct sensor *s = allSensorList; s != NULL; s = s->nextAllSensors)
+	{
+		s->updateSensor = addTimedUpdate(s->sensorName, s->updateSensor);
+	}
+}
+
+// returns the number of active processes and sensors that keep the loop from sleeping
+
+int printPolledUpdates()
+{
+	int polled = 0;
+
+	printf("Polled:");
+
+	for (struct process *p = activeProcessList; p != NULL; p = p->nextActiveProcess)
+	{
+		if (p->scheduleMode == SCHEDULE_POLLED)
+		{
+			printf(" %s", p->processName);
+			polled++;
+		}
+	}
+
+	for (struct sensor *s = activeSensorList; s != NULL; s = s->nextActiveSensor)
+	{
+		if (s->beingUpdated && s->scheduleMode == SCHEDULE_POLLED)
+		{
+			printf(" %s", s->sensorName);
+			polled++;
+		}
+	}
+
+	printf(polled == 0 ? " none\n" : "\n");
+
+	return polled;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long passes = LOOP_BENCH_PASSES;
+	double minSleepMillis = 0;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			passes = LOOP_BENCH_QUICK_PASSES;
+		}
+		else if (strcmp(argv[i], "--min-sleep") == 0 && i + 1 < argc)
+		{
+			minSleepMillis = atof(argv[++i]);
+		}
+		else
+		{
+			passes = strtoul(argv[i], NULL, 10);
+		}
+	}
+
+	// start from the same settings each run
+	LittleFS.format();
+	File settingsFile = LittleFS.open(SETTINGS_FILENAME, "w");
+	settingsFile.print(LOOP_BENCH_SETTINGS);
+	settingsFile.close();
+
+	hostAddWiFiNetwork("hostnet");
+
+	hostSerialOutput(false);
+	setup();
+
+	// let the device connect and settle before timing it
+	for (int i = 0; i < 1000; i++)
+	{
+		loop();
+	}
+
+	timeAllUpdates();
+	hostResetDelayCounts();
+
+	unsigned long long startNanos = nanosNow();
+	for (unsigned long i = 0; i < passes; i++)
+	{
+		loop();
+	}
+	unsigned long long loopNanos = nanosNow() - startNanos;
+
+	hostSerialOutput(true);
+
+	printf("Loop passes:%lu total:%.3f secs per pass:%.1f nanosecs\n",
+		   passes, loopNanos / 1e9, (double)loopNanos / passes);
+	double averageSleepMillis = hostDelayCalls() ? (double)hostDelayMillis() / hostDelayCalls() : 0.0;
+
+	printf("Loop sleeps:%lu average sleep:%.3f millisecs\n", hostDelayCalls(), averageSleepMillis);
+
+	int polled = printPolledUpdates();
+
+	printf("%-20s %12s %14s %12s\n", "Update", "calls", "nanosecs/call", "% of loop");
+
+	for (int i = 0; i < noOfTimedUpdates; i++)
+	{
+		struct timedUpdate *t = &timedUpdates[i];
+
+		if (t->calls == 0)
+		{
+			continue;
+		}
+
+		printf("%-20s %12lu %14.1f %12.2f\n", t->name, t->calls,
+			   (double)t->nanos / t->calls, 100.0 * t->nanos / loopNanos);
+	}
+
+	if (minSleepMillis > 0)
+	{
+		if (polled > 0)
+		{
+			printf("FAIL: updates polled on every pass\n");
+			return 1;
+		}
+
+		if (averageSleepMillis < minSleepMillis)
+		{
+			printf("FAIL: average sleep below %.3f millisecs\n", minSleepMillis);
+			return 1;
+		}
+	}
+
+	return 0;
+}
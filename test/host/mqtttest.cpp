@@ -0,0 +1,191 @@
+// MQTT receive test
+// Boots the firmware on the host connected to an MQTT broker and sends it
+// bursts of messages, which the client hands to the firmware callback from
+// loop() as the PubSubClient does. Each message carries a sequence number and
+// the firmware reports every message it acts on over the serial port, so lost
+// or reordered messages can be found. The lengths vary so that records wrap
+// around the end of the receive ring.
+//
+// mqtttest [messages]
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "hostArduino.h"
+#include "processes.h"
+#include "mqtt.h"
+
+void setup();
+void loop();
+
+#define MQTT_TEST_MESSAGES 150
+#define MQTT_TEST_BURST_SIZE 8
+#define MQTT_TEST_MAX_LOOPS 100000
+
+#define MQTT_TEST_SETTINGS "wifissid1=hostnet\n" \
+						   "mqttactive=yes\n"    \
+						   "mqtthost=broker.local\n"
+
+#define MQTT_TEST_RECEIVED_PREFIX "Received from MQTT: {\"seq\":"
+
+int mqttTestExpected;
+int mqttTestHandled;
+int mqttTestLost;
+int mqttTestOutOfOrder;
+
+char mqttTestLine[MQTT_RECEIVE_BUFFER_SIZE * 2];
+int mqttTestLineLength = 0;
+
+void checkMQTTTestLine(const char *line)
+{
+	if (strncmp(line, MQTT_TEST_RECEIVED_PREFIX, strlen(MQTT_TEST_RECEIVED_PREFIX)) != 0)
+	{
+		return;
+	}
+
+	int seq = atoi(line + strlen(MQTT_TEST_RECEIVED_PREFIX));
+
+	if (seq < mqttTestExpected)
+	{
+		mqttTestOutOfOrder++;
+		return;
+	}
+
+	mqttTestLost = mqttTestLost + seq - mqttTestExpected;
+	mqttTestExpected = seq + 1;
+	mqttTestHandled++;
+}
+
+// collects the serial output into lines
+
+void mqttTestSerialOutput(const char *text, size_t length)
+{
+	for (size_t i = 0; i < length; i++)
+	{
+		if (text[i] == '\n')
+		{
+			mqttTestLine[mqttTestLineLength] = 0;
+			checkMQTTTestLine(mqttTestLine);
+			mqttTestLineLength = 0;
+		}
+		else if (mqttTestLineLength < (int)sizeof(mqttTestLine) - 1)
+		{
+			mqttTestLine[mqttTestLineLength++] = text[i];
+		}
+	}
+}
+
+// Sends the messages in bursts, running loop() until each burst has been
+// handled. With expectLoss every message must be either handled in order or
+// counted as an overflow, otherwise none may be lost.
+
+bool runMQTTReceiveTest(int noOfMessages, int burstSize, int messagesPerLoop, bool expectLoss)
+{
+	char message[MQTT_RECEIVE_BUFFER_SIZE];
+	char padding[MQTT_RECEIVE_BUFFER_SIZE];
+
+	mqttTestExpected = 0;
+	mqttTestHandled = 0;
+	mqttTestLost = 0;
+	mqttTestOutOfOrder = 0;
+
+	hostSetMQTTMessagesPerLoop(messagesPerLoop);
+
+	unsigned long startOverflows = mqttReceiveOverflows;
+	mqttReceivePeakBytes = 0;
+	int loops = 0;
+	int seq = 0;
+
+	while (seq < noOfMessages && loops < MQTT_TEST_MAX_LOOPS)
+	{
+		for (int i = 0; i < burstSize && seq < noOfMessages; i++)
+		{
+			int padLength = (seq * 37) % 150;
+			memset(padding, 'x', padLength);
+			padding[padLength] = 0;
+			snprintf(message, MQTT_RECEIVE_BUFFER_SIZE, "{\"seq\":%d,\"pad\":\"%s\"}", seq, padding);
+			hostMQTTDeliver("test", message);
+			seq++;
+		}
+
+		while ((hostMQTTPending() > 0 || getMQTTReceiveBytesUsed() > 0) && loops < MQTT_TEST_MAX_LOOPS)
+		{
+			loop();
+			loops++;
+		}
+	}
+
+	// anything missing from the end
+	mqttTestLost = mqttTestLost + noOfMessages - mqttTestExpected;
+
+	unsigned long overflows = mqttReceiveOverflows - startOverflows;
+
+	bool ok = mqttTestOutOfOrder == 0 && loops < MQTT_TEST_MAX_LOOPS;
+
+	if (expectLoss)
+	{
+		ok = ok && mqttTestHandled + (int)overflows == noOfMessages && mqttTestLost == (int)overflows;
+	}
+	else
+	{
+		ok = ok && mqttTestLost == 0 && overflows == 0;
+	}
+
+	printf("%s: burst:%d per loop:%d sent:%d handled:%d lost:%d out of order:%d overflows:%lu loops:%d peak use:%u bytes\n",
+		   ok ? "PASS" : "FAIL", burstSize, messagesPerLoop, noOfMessages, mqttTestHandled,
+		   mqttTestLost, mqttTestOutOfOrder, overflows, loops, mqttReceivePeakBytes);
+
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	int noOfMessages = MQTT_TEST_MESSAGES;
+
+	if (argc > 1)
+	{
+		noOfMessages = atoi(argv[1]);
+	}
+
+	LittleFS.format();
+	File settingsFile = LittleFS.open(SETTINGS_FILENAME, "w");
+	settingsFile.print(MQTT_TEST_SETTINGS);
+	settingsFile.close();
+
+	hostAddWiFiNetwork("hostnet");
+
+	hostSerialOutput(false);
+	setup();
+
+	for (int i = 0; i < MQTT_TEST_MAX_LOOPS && MQTTProcessDescriptor.status != MQTT_OK; i++)
+	{
+		loop();
+	}
+
+	if (MQTTProcessDescriptor.status != MQTT_OK)
+	{
+		printf("FAIL: MQTT did not connect\n");
+		return 1;
+	}
+
+	hostSetSerialOutputHook(mqttTestSerialOutput);
+
+	printf("MQTT receive ring test, %d bytes, %d messages per update\n",
+		   MQTT_RECEIVE_RING_SIZE, MQTT_RECEIVE_MESSAGES_PER_UPDATE);
+
+	bool ok = true;
+
+	// the client hands over one message each loop, so even a single burst of
+	// everything must not overflow the ring
+	ok = runMQTTReceiveTest(noOfMessages, MQTT_TEST_BURST_SIZE, 1, false) && ok;
+	ok = runMQTTReceiveTest(noOfMessages, noOfMessages, 1, false) && ok;
+
+	// bursts that fit in the ring must not lose anything
+	ok = runMQTTReceiveTest(noOfMessages, MQTT_TEST_BURST_SIZE, MQTT_TEST_BURST_SIZE, false) && ok;
+
+	// a single burst of everything at once overflows
+	ok = runMQTTReceiveTest(noOfMessages, noOfMessages, 0, true) && ok;
+
+	hostSetSerialOutputHook(NULL);
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,293 @@
+// Command parser test
+// Checks how numbers reach the validators, times the parser over the command
+// corpus and then parses mutated copies of the corpus. Every accepted command
+// must lie inside its text and must print as JSON that parses back to the
+// same members.
+//
+// parsertest [iterations] [--quick]
+
+#include <time.h>
+
+#include "Arduino.h"
+#include "utils.h"
+#include "settings.h"
+#include "commandparser.h"
+#include "commandCorpus.h"
+
+#define PARSER_TEST_ITERATIONS 1000000
+#define PARSER_TEST_QUICK_ITERATIONS 10000
+#define PARSER_TEST_SEED 1234
+
+unsigned long long nanosNow()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// A number sent for an integer item must arrive whole, as it did with the
+// previous JSON library, or be rejected. It must never be cut short.
+
+struct numberCase
+{
+	const char *json;
+	bool valid;
+	int value;
+};
+
+struct numberCase numberCases[] = {
+	{"-1", true, -1},
+	{"-1e2", true, -100},
+	{"1e2", true, 100},
+	{"2.5e1", true, 25},
+	{"1E+1", true, 10},
+	{"5e-1", true, 0},
+	{"1e300", false, 0}};
+
+int testNumbers()
+{
+	parsedCommand *command = new parsedCommand;
+	int failures = 0;
+
+	for (unsigned int i = 0; i < sizeof(numberCases) / sizeof(struct numberCase); i++)
+	{
+		struct numberCase *test = &numberCases[i];
+		char json[COMMAND_NUMBER_TEXT_LENGTH];
+		snprintf(json, sizeof(json), "{\"steps\":%s}", test->json);
+
+		bool valid = false;
+		int value = 0;
+
+		if (parseCommand(command, json))
+		{
+			char numberText[COMMAND_NUMBER_TEXT_LENGTH];
+			const char *text = getCommandMemberValueText(findCommandMember(command, "steps"),
+														 numberText, COMMAND_NUMBER_TEXT_LENGTH);
+			valid = text != NULL && validateInt(&value, text);
+		}
+
+		bool ok = valid == test->valid && (!valid || value == test->value);
+
+		if (!ok)
+		{
+			failures++;
+		}
+
+		if (test->valid)
+		{
+			printf("%s: %s gives %d, expected %d\n", ok ? "PASS" : "FAIL", test->json, value, test->value);
+		}
+		else
+		{
+			printf("%s: %s is %s, expected rejected\n", ok ? "PASS" : "FAIL", test->json,
+				   valid ? "accepted" : "rejected");
+		}
+	}
+
+	delete command;
+
+	return failures;
+}
+
+bool commandMembersInText(parsedCommand *command)
+{
+	const char *textEnd = command->text + COMMAND_TEXT_LENGTH;
+
+	for (int i = 0; i < command->noOfMembers; i++)
+	{
+		commandMember *member = &command->members[i];
+
+		if (member->key < command->text || member->key >= textEnd ||
+			member->text < command->text || member->text >= textEnd)
+		{
+			return false;
+		}
+
+		if (strnlen(member->key, textEnd - member->key) == (size_t)(textEnd - member->key) ||
+			strnlen(member->text, textEnd - member->text) == (size_t)(textEnd - member->text))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool commandsMatch(parsedCommand *first, parsedCommand *second)
+{
+	if (first->noOfMembers != second->noOfMembers)
+	{
+		return false;
+	}
+
+	for (int i = 0; i < first->noOfMembers; i++)
+	{
+		commandMember *a = &first->members[i];
+		commandMember *b = &second->members[i];
+
+		if (a->type != b->type || strcmp(a->key, b->key) != 0 || strcmp(a->text, b->text) != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+const char commandFuzzChars[] = "\"'\\{}[]:, \t0123456789-.eEuntrfalsx";
+
+void mutateCommandText(char *text)
+{
+	int mutations = localRand(1, 5);
+
+	for (int i = 0; i < mutations; i++)
+	{
+		int length = strlen(text);
+		int pos = localRand(length + 1);
+		char ch = commandFuzzChars[localRand(sizeof(commandFuzzChars) - 1)];
+
+		switch (localRand(4))
+		{
+		case 0:
+			// replace a character
+			if (pos < length)
+			{
+				text[pos] = ch;
+			}
+			break;
+		case 1:
+			// insert a character
+			if (length < COMMAND_TEXT_LENGTH - 2)
+			{
+				memmove(text + pos + 1, text + pos, length - pos + 1);
+				text[pos] = ch;
+			}
+			break;
+		case 2:
+			// delete a character
+			if (pos < length)
+			{
+				memmove(text + pos, text + pos + 1, length - pos);
+			}
+			break;
+		case 3:
+			// truncate
+			text[pos] = 0;
+			break;
+		}
+	}
+}
+
+void timeParser(int iterations)
+{
+	parsedCommand *command = new parsedCommand;
+
+	int parsed = 0;
+	unsigned long long bytes = 0;
+
+	unsigned long long startNanos = nanosNow();
+
+	for (int i = 0; i < iterations; i++)
+	{
+		const char *json = commandCorpus[i % commandCorpusSize];
+		if (parseCommand(command, json))
+		{
+			parsed++;
+		}
+		bytes = bytes + strlen(json);
+	}
+
+	unsigned long long elapsedNanos = nanosNow() - startNanos;
+
+	if (elapsedNanos == 0)
+	{
+		elapsedNanos = 1;
+	}
+
+	printf("Parsed:%d of %d in %.3f secs (%.0f per sec, %.0f bytes per sec)\n",
+		   parsed, iterations, elapsedNanos / 1e9,
+		   iterations * 1e9 / elapsedNanos, bytes * 1e9 / elapsedNanos);
+
+	delete command;
+}
+
+int fuzzParser(int iterations, int seed)
+{
+	parsedCommand *command = new parsedCommand;
+	parsedCommand *reparsed = new parsedCommand;
+	char *text = new char[COMMAND_TEXT_LENGTH];
+	char *printed = new char[COMMAND_TEXT_LENGTH];
+
+	localSrand(seed);
+
+	int accepted = 0;
+	int rejected = 0;
+	int failures = 0;
+
+	for (int i = 0; i < iterations; i++)
+	{
+		strcpy(text, commandCorpus[localRand(commandCorpusSize)]);
+		mutateCommandText(text);
+
+		if (!parseCommand(command, text))
+		{
+			rejected++;
+			continue;
+		}
+
+		accepted++;
+
+		bool ok = commandMembersInText(command);
+
+		if (ok)
+		{
+			ok = printCommandJson(command, printed, COMMAND_TEXT_LENGTH) &&
+				 parseCommand(reparsed, printed) &&
+				 commandsMatch(command, reparsed);
+		}
+
+		if (!ok)
+		{
+			failures++;
+			if (failures <= 5)
+			{
+				printf("   failed on:%s\n", text);
+			}
+		}
+	}
+
+	printf("Fuzzed:%d accepted:%d rejected:%d failures:%d\n",
+		   iterations, accepted, rejected, failures);
+
+	delete command;
+	delete reparsed;
+	delete[] text;
+	delete[] printed;
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	int iterations = PARSER_TEST_ITERATIONS;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			iterations = PARSER_TEST_QUICK_ITERATIONS;
+		}
+		else
+		{
+			iterations = atoi(argv[i]);
+		}
+	}
+
+	int failures = testNumbers();
+
+	timeParser(iterations);
+
+	failures += fuzzParser(iterations, PARSER_TEST_SEED);
+
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,481 @@
+// Pixel pipeline benchmark
+// Renders the same animated frames through the float and the fixed point
+// pipelines, timing each and comparing the bytes that would be sent to the
+// pixels. The fixed point frames are produced both through setPixelBytes and
+// by writing straight into a pixel buffer through a raster lookup, which is
+// how a fitted strip is driven. The frames are captured rather than shown.
+// It fails if the two pipelines differ by more than one lsb anywhere, or if
+// the pixel buffer doesn't hold the same frame as setPixelBytes was given.
+// The full output stage, with gamma correction and dithering, must render
+// every frame within the update interval, and the dithered output of each
+// level, averaged over time, must be within PIXEL_DITHER_TOLERANCE of the
+// gamma corrected level.
+//
+// It then times the fixed point light rendering with the splat table
+// against working out each distance. A single light swept across a pixel
+// must stay within SPLAT_MAX_DIFFERENCE of the exact render, and lights on
+// sixteenths of a pixel must match it exactly.
+//
+// pixelbench [frames] [--quick]
+
+#include <time.h>
+
+#include "Arduino.h"
+#include "pixels.h"
+#include "Sprite.h"
+
+#define PIXEL_BENCH_FRAMES 2000
+#define PIXEL_BENCH_QUICK_FRAMES 200
+
+unsigned long long nanosNow()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+double getFramesPerSec(int noOfFrames, unsigned long long elapsedNanos)
+{
+	if (elapsedNanos == 0)
+		return 0;
+
+	return noOfFrames * 1e9 / elapsedNanos;
+}
+
+uint8_t *pixelBenchOutput;
+
+void pixelBenchShow()
+{
+}
+
+void pixelBenchSetPixel(int no, float r, float g, float b)
+{
+	uint8_t *dest = pixelBenchOutput + (no * 3);
+	dest[0] = (uint8_t)round(r * 255);
+	dest[1] = (uint8_t)round(g * 255);
+	dest[2] = (uint8_t)round(b * 255);
+}
+
+void pixelBenchSetPixelBytes(int no, uint8_t r, uint8_t g, uint8_t b)
+{
+	uint8_t *dest = pixelBenchOutput + (no * 3);
+	dest[0] = r;
+	dest[1] = g;
+	dest[2] = b;
+}
+
+struct pixelBenchLayout
+{
+	int width;
+	int height;
+};
+
+// a ring, a matrix and the largest supported strand
+struct pixelBenchLayout pixelBenchLayouts[] = {
+	{12, 1},
+	{16, 16},
+	{20, MAX_NO_OF_PIXELS / 20}};
+
+bool benchPixelLayout(int width, int height, int noOfFrames)
+{
+	int noOfPixels = width * height;
+	int noOfBytes = noOfPixels * 3;
+
+	uint8_t *floatOutput = new uint8_t[noOfBytes];
+	uint8_t *fixedOutput = new uint8_t[noOfBytes];
+	uint8_t *directOutput = new uint8_t[noOfBytes];
+	uint8_t *ditherOutput = new uint8_t[noOfBytes];
+	int *lookup = new int[noOfPixels];
+
+	buildRasterLookup(lookup, width, height);
+
+	Leds *benchLeds = new Leds(width, height,
+							   pixelBenchShow, pixelBenchSetPixel, pixelBenchSetPixelBytes);
+	Frame *benchFrame = new Frame(benchLeds, BLACK_COLOUR, Frame::getSpritePoolSize(noOfPixels));
+
+	// compare like with like, the splat table rounds the light positions
+	benchLeds->exactSplat = true;
+
+	benchFrame->fadeSpritesToWalkingColours("RGBYMC", 10);
+
+	// blend some of the sprites as well as adding them
+	for (int i = 0; i < benchFrame->noOfSprites; i += 3)
+	{
+		benchFrame->sprites[i].opacity = 0.5;
+	}
+
+	// sweep the frame brightness so that the scaling is tested too
+	benchFrame->brightness = 1;
+	benchFrame->fadeToBrightness(0.3, noOfFrames);
+
+	unsigned long long floatNanos = 0;
+	unsigned long long fixedNanos = 0;
+	unsigned long long directNanos = 0;
+	unsigned long long ditherNanos = 0;
+	unsigned long long longestDitherNanos = 0;
+	int maxDifference = 0;
+	int mismatches = 0;
+	int directMismatches = 0;
+
+	// step the animations on by a frame each time, however long the
+	// renders take
+	unsigned long benchMillis = benchFrame->animationMillis;
+
+	for (int frameNo = 0; frameNo < noOfFrames; frameNo++)
+	{
+		benchMillis += MILLIS_BETWEEN_UPDATES;
+		benchFrame->update(benchMillis);
+
+		benchLeds->fixedPoint = false;
+		pixelBenchOutput = floatOutput;
+		unsigned long long startNanos = nanosNow();
+		benchFrame->render();
+		floatNanos += nanosNow() - startNanos;
+
+		benchLeds->fixedPoint = true;
+		benchLeds->setOutputBuffer(NULL, NULL, 0, 1, 2);
+		pixelBenchOutput = fixedOutput;
+		startNanos = nanosNow();
+		benchFrame->render();
+		fixedNanos += nanosNow() - startNanos;
+
+		benchLeds->setOutputBuffer(directOutput, lookup, 0, 1, 2);
+		startNanos = nanosNow();
+		benchFrame->render();
+		directNanos += nanosNow() - startNanos;
+
+		// the full output stage, which has to fit in the update interval
+		benchLeds->gammaDither = true;
+		benchLeds->setOutputBuffer(ditherOutput, lookup, 0, 1, 2);
+		startNanos = nanosNow();
+		benchFrame->render();
+		unsigned long long frameNanos = nanosNow() - startNanos;
+		benchLeds->gammaDither = false;
+
+		ditherNanos += frameNanos;
+
+		if (frameNanos > longestDitherNanos)
+		{
+			longestDitherNanos = frameNanos;
+		}
+
+		for (int i = 0; i < noOfBytes; i++)
+		{
+			int difference = abs((int)floatOutput[i] - (int)fixedOutput[i]);
+
+			if (difference > maxDifference)
+			{
+				maxDifference = difference;
+			}
+
+			if (difference > 1)
+			{
+				mismatches++;
+			}
+		}
+
+		for (int ledNo = 0; ledNo < noOfPixels; ledNo++)
+		{
+			if (memcmp(fixedOutput + (ledNo * 3), directOutput + (lookup[ledNo] * 3), 3) != 0)
+			{
+				directMismatches++;
+			}
+		}
+	}
+
+	unsigned long long budgetNanos = MILLIS_BETWEEN_UPDATES * 1000000ULL;
+
+	bool ok = mismatches == 0 && directMismatches == 0 && longestDitherNanos < budgetNanos;
+
+	printf("%s: %dx%d float:%.0f fixed:%.0f direct:%.0f frames per sec largest difference:%d lsb over 1 lsb:%d direct mismatches:%d\n",
+		   ok ? "PASS" : "FAIL", width, height,
+		   getFramesPerSec(noOfFrames, floatNanos),
+		   getFramesPerSec(noOfFrames, fixedNanos),
+		   getFramesPerSec(noOfFrames, directNanos),
+		   maxDifference, mismatches, directMismatches);
+
+	printf("      gamma dithered:%.0f frames per sec longest frame:%.1f of %llu microsecs\n",
+		   getFramesPerSec(noOfFrames, ditherNanos),
+		   longestDitherNanos / 1000.0, budgetNanos / 1000);
+
+	delete benchFrame;
+	delete benchLeds;
+	delete[] floatOutput;
+	delete[] fixedOutput;
+	delete[] directOutput;
+	delete[] ditherOutput;
+	delete[] lookup;
+
+	return ok;
+}
+
+// Times the fixed point light rendering with the splat table against working
+// out each distance, and compares the frames they produce. The sprites are
+// then moved onto the nearest sixteenth of a pixel, where the two must
+// agree exactly.
+
+#define PIXEL_SPLAT_BENCH_WIDTH 20
+#define PIXEL_SPLAT_BENCH_HEIGHT (MAX_NO_OF_PIXELS / PIXEL_SPLAT_BENCH_WIDTH)
+
+unsigned long long renderBenchSprites(Frame *benchFrame, uint8_t *output)
+{
+	benchFrame->leds->clear(benchFrame->background);
+
+	unsigned long long startNanos = nanosNow();
+
+	for (int i = 0; i < benchFrame->noOfActiveSprites; i++)
+	{
+		benchFrame->sprites[benchFrame->activeSprites[i]].render();
+	}
+
+	unsigned long long elapsedNanos = nanosNow() - startNanos;
+
+	pixelBenchOutput = output;
+	benchFrame->leds->display(1);
+
+	return elapsedNanos;
+}
+
+int countBenchDifferences(uint8_t *a, uint8_t *b, int noOfBytes, int *maxDifference)
+{
+	int differences = 0;
+
+	for (int i = 0; i < noOfBytes; i++)
+	{
+		int difference = abs((int)a[i] - (int)b[i]);
+
+		if (difference > *maxDifference)
+		{
+			*maxDifference = difference;
+		}
+
+		if (difference != 0)
+		{
+			differences++;
+		}
+	}
+
+	return differences;
+}
+
+float snapToSplatPosition(float position)
+{
+	return round(position * SPLAT_SUB_POSITIONS) / SPLAT_SUB_POSITIONS;
+}
+
+bool benchPixelSplat(int noOfFrames)
+{
+	int noOfBytes = PIXEL_SPLAT_BENCH_WIDTH * PIXEL_SPLAT_BENCH_HEIGHT * 3;
+
+	uint8_t *exactOutput = new uint8_t[noOfBytes];
+	uint8_t *tableOutput = new uint8_t[noOfBytes];
+
+	Leds *benchLeds = new Leds(PIXEL_SPLAT_BENCH_WIDTH, PIXEL_SPLAT_BENCH_HEIGHT,
+							   pixelBenchShow, pixelBenchSetPixel, pixelBenchSetPixelBytes);
+	Frame *benchFrame = new Frame(benchLeds, BLACK_COLOUR,
+								  Frame::getSpritePoolSize(PIXEL_SPLAT_BENCH_WIDTH * PIXEL_SPLAT_BENCH_HEIGHT));
+
+	// the sprites are left opaque, a translucent light dims everything it
+	// touches however faint it is, so the pixels at the very edge of its
+	// reach change a lot when the rounded position moves the edge
+	benchFrame->fadeSpritesToWalkingColours("RGBYMC", 10);
+
+	unsigned long long exactNanos = 0;
+	unsigned long long tableNanos = 0;
+	unsigned long spriteRenders = 0;
+	int maxDifference = 0;
+	int differences = 0;
+	int snappedMaxDifference = 0;
+	int snappedDifferences = 0;
+
+	unsigned long benchMillis = benchFrame->animationMillis;
+
+	for (int frameNo = 0; frameNo < noOfFrames; frameNo++)
+	{
+		benchMillis += MILLIS_BETWEEN_UPDATES;
+		benchFrame->update(benchMillis);
+
+		spriteRenders += benchFrame->noOfActiveSprites;
+
+		benchLeds->exactSplat = true;
+		exactNanos += renderBenchSprites(benchFrame, exactOutput);
+
+		benchLeds->exactSplat = false;
+		tableNanos += renderBenchSprites(benchFrame, tableOutput);
+
+		differences += countBenchDifferences(exactOutput, tableOutput, noOfBytes, &maxDifference);
+
+		for (int i = 0; i < benchFrame->noOfSprites; i++)
+		{
+			Sprite *s = &benchFrame->sprites[i];
+			s->x = snapToSplatPosition(s->x);
+			s->y = snapToSplatPosition(s->y);
+		}
+
+		benchLeds->exactSplat = true;
+		renderBenchSprites(benchFrame, exactOutput);
+
+		benchLeds->exactSplat = false;
+		renderBenchSprites(benchFrame, tableOutput);
+
+		snappedDifferences += countBenchDifferences(exactOutput, tableOutput, noOfBytes, &snappedMaxDifference);
+	}
+
+	bool ok = snappedDifferences == 0;
+
+	// the error from each light can add up where lights overlap, so the
+	// frames are only reported against the bound for a single light
+	printf("Splat %lu sprite renders exact:%.1f table:%.1f nanosecs per sprite\n",
+		   spriteRenders,
+		   spriteRenders ? (double)exactNanos / spriteRenders : 0.0,
+		   spriteRenders ? (double)tableNanos / spriteRenders : 0.0);
+	printf("%s: splat frames largest difference:%d lsb values changed:%d on sixteenths:%d values changed:%d\n",
+		   ok ? "PASS" : "FAIL", maxDifference, differences, snappedMaxDifference, snappedDifferences);
+
+	delete benchFrame;
+	delete benchLeds;
+	delete[] exactOutput;
+	delete[] tableOutput;
+
+	return ok;
+}
+
+// Sweeps a single white light across a pixel in steps much finer than a
+// sixteenth and checks that the table render of every tap stays within
+// SPLAT_MAX_DIFFERENCE of the exact one
+
+#define PIXEL_SPLAT_SWEEP_SIZE 5
+#define PIXEL_SPLAT_SWEEP_STEPS 256
+
+bool testPixelSplatBound()
+{
+	int noOfBytes = PIXEL_SPLAT_SWEEP_SIZE * PIXEL_SPLAT_SWEEP_SIZE * 3;
+
+	uint8_t *exactOutput = new uint8_t[noOfBytes];
+	uint8_t *tableOutput = new uint8_t[noOfBytes];
+
+	Leds *sweepLeds = new Leds(PIXEL_SPLAT_SWEEP_SIZE, PIXEL_SPLAT_SWEEP_SIZE,
+							   pixelBenchShow, pixelBenchSetPixel, pixelBenchSetPixelBytes);
+
+	Colour white = WHITE_COLOUR;
+	int maxDifference = 0;
+
+	for (int i = 0; i < PIXEL_SPLAT_SWEEP_STEPS; i++)
+	{
+		for (int j = 0; j < PIXEL_SPLAT_SWEEP_STEPS; j++)
+		{
+			float x = 2 + (float)i / PIXEL_SPLAT_SWEEP_STEPS;
+			float y = 2 + (float)j / PIXEL_SPLAT_SWEEP_STEPS;
+
+			sweepLeds->exactSplat = true;
+			sweepLeds->clear(BLACK_COLOUR);
+			sweepLeds->renderLight(x, y, white, 1, 1);
+			pixelBenchOutput = exactOutput;
+			sweepLeds->display(1);
+
+			sweepLeds->exactSplat = false;
+			sweepLeds->clear(BLACK_COLOUR);
+			sweepLeds->renderLight(x, y, white, 1, 1);
+			pixelBenchOutput = tableOutput;
+			sweepLeds->display(1);
+
+			countBenchDifferences(exactOutput, tableOutput, noOfBytes, &maxDifference);
+		}
+	}
+
+	bool ok = maxDifference <= SPLAT_MAX_DIFFERENCE;
+
+	printf("%s: single light largest difference:%d lsb, bound %d lsb\n",
+		   ok ? "PASS" : "FAIL", maxDifference, SPLAT_MAX_DIFFERENCE);
+
+	delete sweepLeds;
+	delete[] exactOutput;
+	delete[] tableOutput;
+
+	return ok;
+}
+
+// Shows each level on a single dithered led for a number of frames and
+// checks the average output against the gamma corrected level
+
+#define PIXEL_DITHER_FRAMES 256
+#define PIXEL_DITHER_TOLERANCE 0.01
+
+bool testPixelDither()
+{
+	uint8_t output[3];
+
+	Leds *ditherLeds = new Leds(1, 1, pixelBenchShow, pixelBenchSetPixel, pixelBenchSetPixelBytes);
+	ditherLeds->gammaDither = true;
+
+	pixelBenchOutput = output;
+
+	double maxError = 0;
+	int worstLevel = 0;
+
+	for (int level = 0; level < 256; level++)
+	{
+		float value = level / 255.0;
+		Colour colour = {value, value, value};
+
+		ditherLeds->clear(colour);
+
+		unsigned long total = 0;
+
+		for (int frameNo = 0; frameNo < PIXEL_DITHER_FRAMES; frameNo++)
+		{
+			ditherLeds->display(1);
+			total += output[0];
+		}
+
+		double average = (double)total / (PIXEL_DITHER_FRAMES * 255.0);
+		double error = fabs(average - pow(value, PIXEL_GAMMA));
+
+		if (error > maxError)
+		{
+			maxError = error;
+			worstLevel = level;
+		}
+	}
+
+	bool ok = maxError <= PIXEL_DITHER_TOLERANCE;
+
+	printf("%s: dithered output largest error:%.4f at level %d, tolerance %.4f\n",
+		   ok ? "PASS" : "FAIL", maxError, worstLevel, PIXEL_DITHER_TOLERANCE);
+
+	delete ditherLeds;
+
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	int noOfFrames = PIXEL_BENCH_FRAMES;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--quick") == 0)
+		{
+			noOfFrames = PIXEL_BENCH_QUICK_FRAMES;
+		}
+		else
+		{
+			noOfFrames = atoi(argv[i]);
+		}
+	}
+
+	printf("Pixel pipeline frames:%d\n", noOfFrames);
+
+	bool ok = true;
+
+	for (unsigned int i = 0; i < sizeof(pixelBenchLayouts) / sizeof(struct pixelBenchLayout); i++)
+	{
+		ok = benchPixelLayout(pixelBenchLayouts[i].width, pixelBenchLayouts[i].height, noOfFrames) && ok;
+	}
+
+	ok = benchPixelSplat(noOfFrames) && ok;
+	ok = testPixelSplatBound() && ok;
+	ok = testPixelDither() && ok;
+
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,356 @@
+// Pixel trace test
+// Replays a script of pixel commands through the command handlers into
+// frames that aren't shown, for a fixed set of layouts with and without
+// gamma correction. After every frame the bytes that would go to the pixels
+// are added to a CRC32 for the step, and the CRCs are compared with the
+// golden ones in pixeltrace.golden next to this file, so a change to what
+// any command renders is found and the timings show what rendering work has
+// done to the speed. The random numbers are seeded and the animations
+// stepped a frame at a time so the trace is the same each run.
+//
+// pixeltrace golden-file [--record]
+//
+// With --record the golden file is written from this run rather than
+// checked. Only record from a build whose output is known to be good.
+
+#include <time.h>
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "hostArduino.h"
+#include "utils.h"
+#include "settingsstore.h"
+#include "controller.h"
+#include "pixels.h"
+
+void setup();
+
+#define PIXEL_TRACE_SEED 1234
+#define PIXEL_TRACE_REPLY_LENGTH 120
+#define PIXEL_TRACE_LINE_LENGTH 100
+
+struct pixelTraceLayout
+{
+	int width;
+	int height;
+	bool gammaDither;
+};
+
+// a ring and a matrix, and the matrix again without gamma correction
+struct pixelTraceLayout pixelTraceLayouts[] = {
+	{12, 1, true},
+	{16, 16, true},
+	{16, 16, false}};
+
+#define NO_OF_PIXEL_TRACE_LAYOUTS (sizeof(pixelTraceLayouts) / sizeof(struct pixelTraceLayout))
+
+struct pixelTraceStep
+{
+	const char *command;
+	int noOfFrames;
+};
+
+struct pixelTraceStep pixelTraceSteps[] = {
+	{"{\"process\":\"pixels\",\"command\":\"pattern\",\"pattern\":\"walking\",\"colourmask\":\"RGBYMC\",\"steps\":20}", 150},
+	{"{\"process\":\"pixels\",\"command\":\"setnamedcolour\",\"colourname\":\"orange\",\"steps\":20}", 40},
+	{"{\"process\":\"pixels\",\"command\":\"pattern\",\"pattern\":\"mask\",\"colourmask\":\"RGBY*+\",\"steps\":20}", 60},
+	{"{\"process\":\"pixels\",\"command\":\"twinkle\",\"steps\":20}", 60},
+	{"{\"process\":\"pixels\",\"command\":\"map\",\"value\":0.3,\"colourmask\":\"RGB\",\"options\":\"mix\",\"steps\":10}", 30},
+	{"{\"process\":\"pixels\",\"command\":\"map\",\"value\":0.8,\"colourmask\":\"RGB\",\"steps\":10}", 30},
+	{"{\"process\":\"pixels\",\"command\":\"brightness\",\"value\":0.05,\"steps\":20}", 40},
+	{"{\"process\":\"pixels\",\"command\":\"setnamedcolour\",\"colourname\":\"black\",\"steps\":20}", 40}};
+
+#define NO_OF_PIXEL_TRACE_STEPS (sizeof(pixelTraceSteps) / sizeof(struct pixelTraceStep))
+
+uint32_t pixelTraceCRCs[NO_OF_PIXEL_TRACE_LAYOUTS][NO_OF_PIXEL_TRACE_STEPS];
+
+uint8_t *pixelTraceOutput;
+char pixelTraceReply[PIXEL_TRACE_REPLY_LENGTH];
+
+unsigned long long nanosNow()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long long)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+void pixelTraceShow()
+{
+}
+
+// the trace leds use the fixed point pipeline, which doesn't set floats
+void pixelTraceSetPixel(int no, float r, float g, float b)
+{
+}
+
+void pixelTraceSetPixelBytes(int no, uint8_t r, uint8_t g, uint8_t b)
+{
+	uint8_t *dest = pixelTraceOutput + (no * 3);
+	dest[0] = r;
+	dest[1] = g;
+	dest[2] = b;
+}
+
+void pixelTraceResult(char *resultText)
+{
+	snprintf(pixelTraceReply, PIXEL_TRACE_REPLY_LENGTH, "%s", resultText);
+}
+
+// runs the script on one layout and fills in the CRC for each step,
+// returns the number of commands that failed
+
+int tracePixelLayout(struct pixelTraceLayout *layout, uint32_t *stepCRCs)
+{
+	int width = layout->width;
+	int height = layout->height;
+	int noOfBytes = width * height * 3;
+
+	pixelTraceOutput = new uint8_t[noOfBytes];
+	memset(pixelTraceOutput, 0, noOfBytes);
+
+	Leds *traceLeds = new Leds(width, height, pixelTraceShow, pixelTraceSetPixel, pixelTraceSetPixelBytes);
+	traceLeds->gammaDither = layout->gammaDither;
+
+	Frame *traceFrame = new Frame(traceLeds, BLACK_COLOUR, Frame::getSpritePoolSize(width * height));
+	traceFrame->brightness = 1;
+	traceFrame->targetBrightness = 1;
+	traceFrame->animationMillis = 0;
+
+	// the command handlers work on the display frame, so swap in the
+	// trace one while the script runs
+
+	Leds *displayLeds = leds;
+	Frame *displayFrame = frame;
+	leds = traceLeds;
+	frame = traceFrame;
+
+	localSrand(PIXEL_TRACE_SEED);
+
+	printf("Pixel trace %dx%d gamma:%s\n", width, height, layout->gammaDither ? "yes" : "no");
+
+	unsigned long traceMillis = 0;
+	int failedCommands = 0;
+
+	for (unsigned int stepNo = 0; stepNo < NO_OF_PIXEL_TRACE_STEPS; stepNo++)
+	{
+		struct pixelTraceStep *step = &pixelTraceSteps[stepNo];
+
+		pixelTraceReply[0] = 0;
+		act_onJson_message(step->command, pixelTraceResult);
+
+		if (strstr(pixelTraceReply, "\"error\":0,") == NULL)
+		{
+			printf("   step %d failed: %s\n", stepNo, pixelTraceReply);
+			failedCommands++;
+		}
+
+		uint32_t stepCRC = 0xFFFFFFFF;
+		unsigned long long totalNanos = 0;
+		unsigned long long longestNanos = 0;
+		unsigned long renderedBefore = traceFrame->framesRendered + traceFrame->framesDithered;
+
+		for (int frameNo = 0; frameNo < step->noOfFrames; frameNo++)
+		{
+			traceMillis += MILLIS_BETWEEN_UPDATES;
+
+			unsigned long long startNanos = nanosNow();
+			traceFrame->update(traceMillis);
+			traceFrame->renderIfChanged();
+			unsigned long long frameNanos = nanosNow() - startNanos;
+
+			totalNanos += frameNanos;
+
+			if (frameNanos > longestNanos)
+			{
+				longestNanos = frameNanos;
+			}
+
+			// a skipped frame leaves the previous one on the pixels, which
+			// is still in the output buffer
+			stepCRC = updateSettingsCRC(stepCRC, pixelTraceOutput, noOfBytes);
+		}
+
+		stepCRCs[stepNo] = stepCRC ^ 0xFFFFFFFF;
+
+		printf("   step %d frames:%d rendered:%lu crc:%08lx average:%.1f longest:%.1f microsecs\n",
+			   stepNo, step->noOfFrames,
+			   traceFrame->framesRendered + traceFrame->framesDithered - renderedBefore,
+			   (unsigned long)stepCRCs[stepNo],
+			   totalNanos / (step->noOfFrames * 1000.0), longestNanos / 1000.0);
+	}
+
+	leds = displayLeds;
+	frame = displayFrame;
+
+	delete traceFrame;
+	delete traceLeds;
+	delete[] pixelTraceOutput;
+
+	return failedCommands;
+}
+
+bool recordGoldenCRCs(const char *filename)
+{
+	FILE *goldenFile = fopen(filename, "w");
+
+	if (goldenFile == NULL)
+	{
+		printf("FAIL: can't write %s\n", filename);
+		return false;
+	}
+
+	fprintf(goldenFile, "# pixeltrace golden CRCs, written by pixeltrace --record\n");
+	fprintf(goldenFile, "# width height gamma step crc\n");
+
+	for (unsigned int layoutNo = 0; layoutNo < NO_OF_PIXEL_TRACE_LAYOUTS; layoutNo++)
+	{
+		struct pixelTraceLayout *layout = &pixelTraceLayouts[layoutNo];
+
+		for (unsigned int stepNo = 0; stepNo < NO_OF_PIXEL_TRACE_STEPS; stepNo++)
+		{
+			fprintf(goldenFile, "%d %d %s %u %08lx\n", layout->width, layout->height,
+					layout->gammaDither ? "yes" : "no", stepNo,
+					(unsigned long)pixelTraceCRCs[layoutNo][stepNo]);
+		}
+	}
+
+	fclose(goldenFile);
+
+	printf("Recorded golden CRCs in %s\n", filename);
+
+	return true;
+}
+
+// returns the number of steps that don't match the golden file, or that
+// the golden file doesn't cover
+
+int checkGoldenCRCs(const char *filename)
+{
+	FILE *goldenFile = fopen(filename, "r");
+
+	if (goldenFile == NULL)
+	{
+		printf("FAIL: can't read %s\n", filename);
+		return 1;
+	}
+
+	bool checked[NO_OF_PIXEL_TRACE_LAYOUTS][NO_OF_PIXEL_TRACE_STEPS] = {};
+	char line[PIXEL_TRACE_LINE_LENGTH];
+	int failures = 0;
+
+	while (fgets(line, PIXEL_TRACE_LINE_LENGTH, goldenFile) != NULL)
+	{
+		int width, height;
+		char gamma[4];
+		unsigned int stepNo;
+		unsigned long goldenCRC;
+
+		if (line[0] == '#' ||
+			sscanf(line, "%d %d %3s %u %lx", &width, &height, gamma, &stepNo, &goldenCRC) != 5)
+		{
+			continue;
+		}
+
+		for (unsigned int layoutNo = 0; layoutNo < NO_OF_PIXEL_TRACE_LAYOUTS; layoutNo++)
+		{
+			struct pixelTraceLayout *layout = &pixelTraceLayouts[layoutNo];
+
+			if (layout->width != width || layout->height != height ||
+				layout->gammaDither != (strcmp(gamma, "yes") == 0) ||
+				stepNo >= NO_OF_PIXEL_TRACE_STEPS)
+			{
+				continue;
+			}
+
+			checked[layoutNo][stepNo] = true;
+
+			if (pixelTraceCRCs[layoutNo][stepNo] != goldenCRC)
+			{
+				printf("FAIL: %dx%d gamma:%s step %u crc:%08lx golden:%08lx\n",
+					   width, height, gamma, stepNo,
+					   (unsigned long)pixelTraceCRCs[layoutNo][stepNo], goldenCRC);
+				failures++;
+			}
+		}
+	}
+
+	fclose(goldenFile);
+
+	for (unsigned int layoutNo = 0; layoutNo < NO_OF_PIXEL_TRACE_LAYOUTS; layoutNo++)
+	{
+		for (unsigned int stepNo = 0; stepNo < NO_OF_PIXEL_TRACE_STEPS; stepNo++)
+		{
+			if (!checked[layoutNo][stepNo])
+			{
+				printf("FAIL: %dx%d gamma:%s step %u has no golden crc\n",
+					   pixelTraceLayouts[layoutNo].width, pixelTraceLayouts[layoutNo].height,
+					   pixelTraceLayouts[layoutNo].gammaDither ? "yes" : "no", stepNo);
+				failures++;
+			}
+		}
+	}
+
+	return failures;
+}
+
+int main(int argc, char **argv)
+{
+	const char *goldenFilename = NULL;
+	bool record = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--record") == 0)
+		{
+			record = true;
+		}
+		else
+		{
+			goldenFilename = argv[i];
+		}
+	}
+
+	if (goldenFilename == NULL)
+	{
+		printf("pixeltrace golden-file [--record]\n");
+		return 1;
+	}
+
+	// the default settings, the trace brings its own leds
+	LittleFS.format();
+
+	hostSerialOutput(false);
+	setup();
+	hostSerialOutput(true);
+
+	int failures = 0;
+
+	for (unsigned int layoutNo = 0; layoutNo < NO_OF_PIXEL_TRACE_LAYOUTS; layoutNo++)
+	{
+		failures += tracePixelLayout(&pixelTraceLayouts[layoutNo], pixelTraceCRCs[layoutNo]);
+	}
+
+	if (failures > 0)
+	{
+		printf("FAIL: %d commands failed\n", failures);
+	}
+
+	if (record)
+	{
+		if (failures > 0 || !recordGoldenCRCs(goldenFilename))
+		{
+			return 1;
+		}
+
+		return 0;
+	}
+
+	failures += checkGoldenCRCs(goldenFilename);
+
+	if (failures == 0)
+	{
+		printf("PASS: every step matches its golden crc\n");
+	}
+
+	return failures == 0 ? 0 : 1;
+}
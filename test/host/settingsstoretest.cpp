@@ -0,0 +1,130 @@
+// Settings store test
+// Loads text records of different lengths into a setting and checks that a
+// value which fills the setting, leaving no room for the terminator, is
+// rejected without writing past the end of it.
+//
+// settingsstoretest
+
+#include "Arduino.h"
+#include "LittleFS.h"
+#include "hostArduino.h"
+#include "settingsstore.h"
+
+#define TEST_NAME_LENGTH 8
+#define TEST_GUARD_BYTE 0x5A
+
+struct TestSettings
+{
+	char name[TEST_NAME_LENGTH];
+	unsigned char guard[4];
+};
+
+struct TestSettings testSettings;
+
+boolean validateTestName(void *dest, const char *newValueStr)
+{
+	return validateString((char *)dest, newValueStr, TEST_NAME_LENGTH);
+}
+
+struct SettingItem testNameSetting = {
+	"Test name",
+	"testname",
+	testSettings.name,
+	TEST_NAME_LENGTH,
+	text,
+	setEmptyString,
+	validateTestName};
+
+struct SettingItem *testSettingItemPointers[] =
+	{
+		&testNameSetting};
+
+struct SettingItemCollection testSettingItems = {
+	"storetest",
+	"Settings store test",
+	testSettingItemPointers,
+	sizeof(testSettingItemPointers) / sizeof(struct SettingItem *)};
+
+// writes a block holding one text record for the test name setting
+
+void writeTestBlock(const char *value, int length)
+{
+	uint8_t payload[SETTINGS_STORE_RECORD_HEADER_SIZE + MAX_SETTING_LENGTH];
+	uint32_t nameHash = hashSettingName(testNameSetting.formName);
+
+	payload[0] = nameHash & 0xFF;
+	payload[1] = (nameHash >> 8) & 0xFF;
+	payload[2] = (nameHash >> 16) & 0xFF;
+	payload[3] = (nameHash >> 24) & 0xFF;
+	payload[4] = text;
+	payload[5] = length & 0xFF;
+	payload[6] = (length >> 8) & 0xFF;
+	memcpy(payload + SETTINGS_STORE_RECORD_HEADER_SIZE, value, length);
+
+	struct settingsStoreHeader header;
+	header.magic = SETTINGS_STORE_MAGIC;
+	header.version = SETTINGS_STORE_VERSION;
+	header.payloadLength = SETTINGS_STORE_RECORD_HEADER_SIZE + length;
+	header.schemaHash = getSettingCollectionSchemaHash(&testSettingItems);
+	header.crc = updateSettingsCRC(0xFFFFFFFF, payload, header.payloadLength) ^ 0xFFFFFFFF;
+
+	char filename[SETTINGS_STORE_FILENAME_LENGTH];
+	snprintf(filename, SETTINGS_STORE_FILENAME_LENGTH, SETTINGS_STORE_FILENAME_FORMAT,
+			 (unsigned long)hashSettingName(testSettingItems.collectionName));
+
+	File blockFile = LittleFS.open(filename, "w");
+	blockFile.write((uint8_t *)&header, sizeof(struct settingsStoreHeader));
+	blockFile.write(payload, header.payloadLength);
+	blockFile.close();
+}
+
+// loads a value of the given length and checks the setting afterwards
+
+bool testLoad(int length, bool expectLoaded)
+{
+	char value[MAX_SETTING_LENGTH];
+	memset(value, 'a', length);
+
+	snprintf(testSettings.name, TEST_NAME_LENGTH, "old");
+	memset(testSettings.guard, TEST_GUARD_BYTE, sizeof(testSettings.guard));
+
+	writeTestBlock(value, length);
+
+	bool ok = loadSettingCollectionFromStore(&testSettingItems);
+
+	for (unsigned int i = 0; i < sizeof(testSettings.guard); i++)
+	{
+		if (testSettings.guard[i] != TEST_GUARD_BYTE)
+		{
+			ok = false;
+		}
+	}
+
+	if (expectLoaded)
+	{
+		ok = ok && (int)strlen(testSettings.name) == length && memcmp(testSettings.name, value, length) == 0;
+	}
+	else
+	{
+		ok = ok && strcmp(testSettings.name, "old") == 0;
+	}
+
+	printf("%s: %d byte value in a %d byte setting %s\n", ok ? "PASS" : "FAIL",
+		   length, TEST_NAME_LENGTH, expectLoaded ? "loads" : "is rejected");
+
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	LittleFS.format();
+
+	bool ok = true;
+
+	ok = testLoad(0, true) && ok;
+	ok = testLoad(TEST_NAME_LENGTH - 1, true) && ok;
+	ok = testLoad(TEST_NAME_LENGTH, false) && ok;
+	ok = testLoad(TEST_NAME_LENGTH + 1, false) && ok;
+
+	return ok ? 0 : 1;
+}